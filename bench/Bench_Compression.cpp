@@ -0,0 +1,56 @@
+/*****************************************************************************/
+/**
+ * @file    Bench_Compression.cpp
+ * @author  Team Server
+ * @brief   Benchmarks for class Compression
+ */
+/*****************************************************************************/
+
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Network/QueueBodyCache.h"
+#include "TrackGenerator.h"
+#include "Utils/Compression.h"
+#include "Utils/JsonWriter.h"
+
+using namespace std;
+
+/**
+ * Compresses the queues of a 1000-track QueueStatus for a user who voted for
+ * two tracks. The baseline compresses the whole body for every response.
+ */
+BENCHMARK(Compression_QueueStatus) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(900, 100, false);
+  status.queueVersion = 1;
+  for (auto &track : status.normalQueue.tracks) {
+    track.userHasVoted = false;
+  }
+  status.normalQueue.tracks[10].userHasVoted = true;
+  status.normalQueue.tracks[500].userHasVoted = true;
+
+  QueueBodyCache cache;
+  auto entry = cache.get(status);
+  string body;
+  vector<BodySegment> segments;
+  JsonWriter writer(body);
+  writer.beginObject().key("admin_queue");
+  entry->appendAdminQueue(writer, &segments);
+  writer.key("normal_queue");
+  entry->appendNormalQueue(status.normalQueue, writer, &segments);
+  writer.endObject();
+
+  auto ns = Benchmark::measureNs(100, [&](size_t) {
+    Benchmark::doNotOptimize(
+        Compression::compress(body, segments, ContentEncoding::Gzip));
+  });
+  Benchmark::report("cached segments, 1000 tracks", ns);
+
+  ns = Benchmark::measureNs(100, [&](size_t) {
+    Benchmark::doNotOptimize(
+        Compression::compress(body, {}, ContentEncoding::Gzip));
+  });
+  Benchmark::report("baseline: whole body, 1000 tracks", ns);
+}
@@ -0,0 +1,275 @@
+/*****************************************************************************/
+/**
+ * @file    Bench_DataStore.cpp
+ * @author  Team Server
+ * @brief   Benchmarks for class RAMDataStore
+ */
+/*****************************************************************************/
+
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Datastore/RAMDataStore.h"
+#include "TrackGenerator.h"
+
+using namespace std;
+
+static vector<TSessionID> addUsers(RAMDataStore &ds, size_t nr) {
+  vector<TSessionID> ids;
+  for (size_t i = 0; i < nr; ++i) {
+    User user;
+    user.SessionID = "ID" + to_string(i) + to_string(time(nullptr));
+    user.ExpirationDate =
+        time(nullptr) + DataStore::cSessionTimeoutAfterSeconds;
+    user.Name = "user" + to_string(i);
+    user.isAdmin = false;
+    ds.addUser(user);
+    ids.push_back(user.SessionID);
+  }
+  return ids;
+}
+
+/**
+ * Session lookups (as done by every authenticated request) should take the
+ * same time regardless of the number of registered users.
+ */
+BENCHMARK(DataStore_UserLookup) {
+  size_t const lookups = 200000;
+
+  for (size_t nrUsers : {10, 100, 1000, 10000, 100000}) {
+    RAMDataStore ds;
+    auto ids = addUsers(ds, nrUsers);
+
+    // access the users in a random order to defeat the caches a bit
+    mt19937 rng(42);
+    vector<size_t> order(lookups);
+    for (auto &&idx : order) {
+      idx = rng() % ids.size();
+    }
+
+    auto ns = Benchmark::measureNs(lookups, [&](size_t i) {
+      Benchmark::doNotOptimize(ds.hasUser(ids[order[i]]));
+    });
+    Benchmark::report("hasUser, " + to_string(nrUsers) + " users", ns);
+
+    ns = Benchmark::measureNs(lookups, [&](size_t i) {
+      Benchmark::doNotOptimize(ds.isSessionExpired(ids[order[i]]));
+    });
+    Benchmark::report("isSessionExpired, " + to_string(nrUsers) + " users", ns);
+  }
+}
+
+/**
+ * Votes only move the voted track, so the vote throughput should barely depend
+ * on the queue length. The baseline mimics the former implementation which
+ * sorted the whole queue on every vote.
+ */
+BENCHMARK(DataStore_VoteThroughput) {
+  TrackGenerator gen;
+  size_t const nrUsers = 1000;
+
+  for (size_t nrTracks : {1000, 10000}) {
+    RAMDataStore ds;
+    auto tracks = gen.generateTracks(nrTracks);
+    for (auto &&track : tracks) {
+      ds.addTrack(track, QueueType::Normal);
+    }
+    auto ids = addUsers(ds, nrUsers);
+
+    // every (user, track) pair is voted once and revoked afterwards
+    size_t const votes = 20000;
+    mt19937 rng(42);
+    vector<size_t> trackIdx(votes);
+    for (auto &&idx : trackIdx) {
+      idx = rng() % tracks.size();
+    }
+    auto voteFor = [&](size_t i, TVote vote) {
+      auto &trackId = tracks[trackIdx[i]].trackId;
+      auto res = ds.voteTrack(ids[i % nrUsers], trackId, vote);
+      Benchmark::doNotOptimize(res);
+    };
+
+    auto ns = Benchmark::measureNs(votes, [&](size_t i) { voteFor(i, true); });
+    Benchmark::report("upvote, " + to_string(nrTracks) + " tracks", ns);
+    ns = Benchmark::measureNs(votes, [&](size_t i) { voteFor(i, false); });
+    Benchmark::report("revoke, " + to_string(nrTracks) + " tracks", ns);
+
+    // baseline: std::sort over a vector on every vote
+    auto queued = gen.generateQueuedTracks(nrTracks);
+    for (auto &&track : queued) {
+      track.votes = 0;
+    }
+    size_t const baselineVotes = 200;
+    ns = Benchmark::measureNs(baselineVotes, [&](size_t i) {
+      auto &id = queued[trackIdx[i] % queued.size()].trackId;
+      QueuedTrack key;
+      key.trackId = id;
+      auto it = find(queued.begin(), queued.end(), key);
+      it->votes++;
+      sort(queued.begin(), queued.end());
+    });
+    Benchmark::report(
+        "upvote baseline (sort), " + to_string(nrTracks) + " tracks", ns);
+  }
+}
+
+/**
+ * Playing the next track should not depend on the number of queued tracks.
+ * The baseline mimics the former implementation which erased the first track
+ * of a vector and sorted the normal queue afterwards.
+ */
+BENCHMARK(DataStore_NextTrack) {
+  TrackGenerator gen;
+
+  for (size_t nrTracks : {1000, 10000}) {
+    RAMDataStore ds;
+    auto tracks = gen.generateTracks(2 * nrTracks);
+    vector<BaseTrack> adminTracks(tracks.begin(), tracks.begin() + nrTracks);
+    vector<BaseTrack> normalTracks(tracks.begin() + nrTracks, tracks.end());
+    ds.addTracks(adminTracks, QueueType::Admin);
+    ds.addTracks(normalTracks, QueueType::Normal);
+
+    // drain the admin queue first, then the normal queue
+    auto ns = Benchmark::measureNs(
+        nrTracks, [&](size_t) { Benchmark::doNotOptimize(ds.nextTrack()); });
+    Benchmark::report("admin queue, " + to_string(nrTracks) + " tracks", ns);
+    ns = Benchmark::measureNs(
+        nrTracks, [&](size_t) { Benchmark::doNotOptimize(ds.nextTrack()); });
+    Benchmark::report("normal queue, " + to_string(nrTracks) + " tracks", ns);
+
+    // baseline: erase the front of a vector and sort the remaining tracks
+    auto queued = gen.generateQueuedTracks(nrTracks);
+    size_t const baselinePops = min<size_t>(nrTracks, 200);
+    ns = Benchmark::measureNs(baselinePops, [&](size_t) {
+      QueuedTrack track = queued.front();
+      queued.erase(queued.begin());
+      sort(queued.begin(), queued.end());
+      Benchmark::doNotOptimize(track);
+    });
+    Benchmark::report("baseline (erase + sort), " + to_string(nrTracks) +
+                          " tracks",
+                      ns);
+  }
+}
+
+/**
+ * Every poll flags the tracks the polling user has voted for. The baseline
+ * mimics the former implementation which compared every queued track with
+ * every vote of the user.
+ */
+BENCHMARK(DataStore_UserHasVoted) {
+  TrackGenerator gen;
+
+  for (size_t nrTracks : {50, 500, 5000}) {
+    RAMDataStore ds;
+    auto tracks = gen.generateTracks(nrTracks);
+    for (auto &&track : tracks) {
+      ds.addTrack(track, QueueType::Normal);
+    }
+    auto sid = addUsers(ds, 1).front();
+
+    // the user voted for every other track
+    vector<TTrackID> voteVector;
+    for (size_t i = 0; i < tracks.size(); i += 2) {
+      ds.voteTrack(sid, tracks[i].trackId, true);
+      voteVector.push_back(tracks[i].trackId);
+    }
+    auto user = get<User>(ds.getUser(sid));
+    auto queue = get<Queue>(ds.getQueue(QueueType::Normal));
+
+    size_t const polls = 500000 / nrTracks;
+    auto ns = Benchmark::measureNs(polls, [&](size_t) {
+      for (auto &queueElem : queue.tracks) {
+        queueElem.userHasVoted = user.votes.count(queueElem.trackId) > 0;
+      }
+      Benchmark::doNotOptimize(queue);
+    });
+    Benchmark::report("hashed set, " + to_string(nrTracks) + " tracks", ns);
+
+    // baseline: nested loop over the queue and a vector of votes
+    size_t const baselinePolls = max<size_t>(1, polls / nrTracks * 10);
+    ns = Benchmark::measureNs(baselinePolls, [&](size_t) {
+      for (auto &queueElem : queue.tracks) {
+        queueElem.userHasVoted = false;
+        for (auto const &votedElem : voteVector) {
+          if (queueElem.trackId == votedElem)
+            queueElem.userHasVoted = true;
+        }
+      }
+      Benchmark::doNotOptimize(queue);
+    });
+    Benchmark::report(
+        "baseline (nested loop), " + to_string(nrTracks) + " tracks", ns);
+  }
+}
+
+/**
+ * Mix of authenticated requests (session check and user lookup), votes and
+ * queue reads issued concurrently by `threads` threads.
+ */
+static double measureRequests(size_t threads, bool singleLock) {
+  TrackGenerator gen;
+  size_t const nrUsers = 1000;
+  size_t const nrTracks = 500;
+  size_t const iterations = 50000;
+
+  RAMDataStore ds;
+  auto tracks = gen.generateTracks(nrTracks);
+  for (auto &&track : tracks) {
+    ds.addTrack(track, QueueType::Normal);
+  }
+  auto ids = addUsers(ds, nrUsers);
+
+  auto request = [&](size_t t, size_t i) {
+    auto &sid = ids[(t * 7919 + i) % nrUsers];
+    switch (i % 5) {
+      case 0:
+      case 1:
+      case 2:
+        Benchmark::doNotOptimize(ds.isSessionExpired(sid));
+        Benchmark::doNotOptimize(ds.getUser(sid));
+        break;
+      case 3: {
+        auto &tid = tracks[(t * 31 + i) % nrTracks].trackId;
+        Benchmark::doNotOptimize(ds.voteTrack(sid, tid, (i / 5) % 2 == 0));
+      } break;
+      default:
+        Benchmark::doNotOptimize(ds.getQueueSnapshot());
+        break;
+    }
+  };
+
+  if (!singleLock) {
+    return Benchmark::measureParallelNs(threads, iterations, request);
+  }
+
+  // serialize all requests, as the former implementation did for all user
+  // operations
+  mutex globalMutex;
+  return Benchmark::measureParallelNs(
+      threads, iterations, [&](size_t t, size_t i) {
+        lock_guard<mutex> lock(globalMutex);
+        request(t, i);
+      });
+}
+
+/**
+ * Request throughput for a growing number of threads. Ideally the time per
+ * request drops with every added (physical) core.
+ */
+BENCHMARK(DataStore_Contention) {
+  size_t maxThreads = max<size_t>(4, thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    Benchmark::report("sharded, " + to_string(threads) + " threads",
+                      measureRequests(threads, false));
+    Benchmark::report(
+        "baseline (single lock), " + to_string(threads) + " threads",
+        measureRequests(threads, true));
+  }
+}
@@ -0,0 +1,55 @@
+/*****************************************************************************/
+/**
+ * @file    Bench_Metrics.cpp
+ * @author  Team Server
+ * @brief   Benchmarks for class Metrics
+ */
+/*****************************************************************************/
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "Benchmark.h"
+#include "Utils/Metrics.h"
+
+using namespace std;
+
+/**
+ * Recording a request should be cheap compared to the request itself and must
+ * not slow down when many threads record at the same time. The baselines use
+ * a shared counter and a shared histogram guarded by a mutex.
+ */
+BENCHMARK(Metrics_Record) {
+  auto &metrics = Metrics::getInstance();
+  auto counter = metrics.registerCounter("bench_record_total");
+  auto histogram = metrics.registerHistogram("bench_record_duration");
+
+  atomic<uint64_t> sharedCounter{0};
+  mutex sharedMutex;
+  LatencyHistogram sharedHistogram;
+
+  for (size_t threads : {1, 4, 16}) {
+    auto suffix = ", " + to_string(threads) + " threads";
+
+    auto record = [&](size_t, size_t i) {
+      metrics.increment(counter);
+      metrics.record(histogram, i);
+    };
+    auto ns = Benchmark::measureParallelNs(threads, 100000, record);
+    Benchmark::report("per-thread counter + histogram" + suffix, ns);
+
+    auto recordShared = [&](size_t, size_t i) {
+      sharedCounter.fetch_add(1);
+      lock_guard<mutex> lock(sharedMutex);
+      sharedHistogram.record(i);
+    };
+    ns = Benchmark::measureParallelNs(threads, 100000, recordShared);
+    Benchmark::report("baseline: shared counter + histogram" + suffix, ns);
+  }
+
+  auto ns = Benchmark::measureNs(1000, [&](size_t) {
+    Benchmark::doNotOptimize(metrics.getHistograms());
+  });
+  Benchmark::report("getHistograms", ns);
+}
@@ -0,0 +1,252 @@
+/*****************************************************************************/
+/**
+ * @file    Bench_PersistentDataStore.cpp
+ * @author  Team Server
+ * @brief   Benchmarks for class PersistentDataStore
+ */
+/*****************************************************************************/
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Datastore/PersistentDataStore.h"
+#include "Datastore/SnapshotFile.h"
+#include "TrackGenerator.h"
+
+using namespace std;
+
+static size_t const cNrEvents = 100000;
+
+static string createDirectory() {
+  char dir[] = "/tmp/jukebox_bench_XXXXXX";
+  if (mkdtemp(dir) == nullptr) {
+    return "";
+  }
+  return dir;
+}
+
+static void removeDirectory(string const &dir) {
+  DIR *d = opendir(dir.c_str());
+  while (auto entry = (d != nullptr) ? readdir(d) : nullptr) {
+    unlink((dir + "/" + entry->d_name).c_str());
+  }
+  if (d != nullptr) {
+    closedir(d);
+  }
+  rmdir(dir.c_str());
+}
+
+/**
+ * Generates `cNrEvents` modifications: users are added, tracks are added,
+ * voted for and played.
+ */
+static void generateEvents(PersistentDataStore &ds) {
+  TrackGenerator gen;
+  auto tracks = gen.generateTracks(1000);
+  vector<TSessionID> users;
+
+  for (size_t i = 0; i < cNrEvents; ++i) {
+    switch (i % 10) {
+      case 0: {
+        User user;
+        user.SessionID = "ID" + to_string(i);
+        user.ExpirationDate =
+            time(nullptr) + DataStore::cSessionTimeoutAfterSeconds;
+        user.Name = "user" + to_string(i);
+        user.isAdmin = false;
+        ds.addUser(user);
+        users.push_back(user.SessionID);
+      } break;
+      case 1:
+      case 2:
+        ds.addTrack(tracks[i % tracks.size()], QueueType::Normal);
+        break;
+      case 9:
+        ds.nextTrack();
+        break;
+      default:
+        ds.voteTrack(users[i % users.size()],
+                     tracks[(i / 10) % tracks.size()].trackId,
+                     (i % 2) == 0);
+        break;
+    }
+  }
+}
+
+/**
+ * Writes a snapshot with `nr` tracks in the normal queue and `nr` users, each
+ * of them voted for one track. Such a snapshot can also be used to seed a
+ * DataStore for load tests.
+ */
+static void writeSeedSnapshot(string const &dir, size_t nr) {
+  TrackGenerator gen;
+  QueueSnapshot queues;
+  queues.normalQueue.tracks = gen.generateQueuedTracks(nr);
+
+  vector<User> users(nr);
+  for (size_t i = 0; i < nr; ++i) {
+    auto &track = queues.normalQueue.tracks[i];
+    track.votes = 1;
+    track.insertedAt = i;
+
+    users[i].SessionID = "ID" + to_string(i);
+    users[i].ExpirationDate =
+        time(nullptr) + DataStore::cSessionTimeoutAfterSeconds;
+    users[i].Name = "user" + to_string(i);
+    users[i].isAdmin = false;
+    users[i].votes.insert(track.trackId);
+  }
+  SnapshotFile::write(dir + "/snapshot.bin", queues, users, 0);
+}
+
+static double measureOpenMs(string const &dir) {
+  auto start = chrono::steady_clock::now();
+  {
+    PersistentDataStore ds;
+    ds.open(dir);
+    Benchmark::doNotOptimize(ds.isEmpty());
+  }
+  auto end = chrono::steady_clock::now();
+  return chrono::duration<double, milli>(end - start).count();
+}
+
+/**
+ * Appending modifications to the journal should cost little more than the
+ * modification itself, syncs are shared between concurrent writers.
+ */
+BENCHMARK(PersistentDataStore_Append) {
+  auto dir = createDirectory();
+  {
+    PersistentDataStore ds;
+    ds.open(dir);
+    auto start = chrono::steady_clock::now();
+    generateEvents(ds);
+    auto end = chrono::steady_clock::now();
+    auto ns = chrono::duration<double, nano>(end - start).count();
+    Benchmark::report("single writer", ns / cNrEvents);
+
+    for (size_t threads : {4, 16}) {
+      auto addUser = [&](size_t t, size_t i) {
+        User user;
+        user.SessionID =
+            to_string(threads) + "_" + to_string(t) + "_" + to_string(i);
+        user.ExpirationDate =
+            time(nullptr) + DataStore::cSessionTimeoutAfterSeconds;
+        user.isAdmin = false;
+        ds.addUser(user);
+      };
+      ns = Benchmark::measureParallelNs(threads, 1000, addUser);
+      Benchmark::report(to_string(threads) + " writers", ns);
+    }
+  }
+  removeDirectory(dir);
+}
+
+/**
+ * Restoring the state from the journal or the snapshot after a restart.
+ */
+BENCHMARK(PersistentDataStore_Recovery) {
+  auto dir = createDirectory();
+  {
+    PersistentDataStore ds;
+    ds.open(dir);
+    generateEvents(ds);
+  }
+
+  // the timings are reported in ns per event
+  auto ms = measureOpenMs(dir);
+  Benchmark::report("replay journal, 100k events", ms * 1e6 / cNrEvents);
+
+  {
+    PersistentDataStore ds;
+    ds.open(dir);
+    ds.compact();
+  }
+  ms = measureOpenMs(dir);
+  Benchmark::report("load snapshot, 100k events", ms * 1e6 / cNrEvents);
+
+  removeDirectory(dir);
+}
+
+/**
+ * Time from opening a seeded DataStore until the queues can be served and
+ * until the snapshot has been loaded completely.
+ */
+BENCHMARK(PersistentDataStore_SnapshotStartup) {
+  for (size_t nr : {5000, 50000}) {
+    auto dir = createDirectory();
+    writeSeedSnapshot(dir, nr);
+
+    auto start = chrono::steady_clock::now();
+    {
+      PersistentDataStore ds;
+      ds.open(dir);
+      Benchmark::doNotOptimize(ds.getQueueSnapshot());
+      Benchmark::doNotOptimize(ds.getUser("ID0"));
+      auto end = chrono::steady_clock::now();
+      auto ns = chrono::duration<double, nano>(end - start).count();
+      Benchmark::report(
+          "open + getQueueSnapshot, " + to_string(nr) + " tracks/users", ns);
+
+      // looking up a track waits for the loading
+      Benchmark::doNotOptimize(ds.hasTrack("", QueueType::Normal));
+      end = chrono::steady_clock::now();
+      ns = chrono::duration<double, nano>(end - start).count();
+      Benchmark::report("open until loaded, " + to_string(nr) + " tracks/users",
+                        ns);
+    }
+    removeDirectory(dir);
+  }
+}
+
+/**
+ * Writers should only wait for copying the state while a snapshot of a large
+ * DataStore is written, not for writing and syncing it.
+ */
+BENCHMARK(PersistentDataStore_CompactionStall) {
+  size_t const nr = 50000;
+  auto dir = createDirectory();
+  writeSeedSnapshot(dir, nr);
+  {
+    PersistentDataStore ds;
+    ds.open(dir);
+
+    atomic<bool> stop{false};
+    double maxNs = 0;
+    thread writer([&]() {
+      for (size_t i = 0; !stop; i++) {
+        User user;
+        user.SessionID = "writer" + to_string(i);
+        user.ExpirationDate =
+            time(nullptr) + DataStore::cSessionTimeoutAfterSeconds;
+        user.isAdmin = false;
+        auto start = chrono::steady_clock::now();
+        ds.addUser(user);
+        auto end = chrono::steady_clock::now();
+        auto ns = chrono::duration<double, nano>(end - start).count();
+        maxNs = max(maxNs, ns);
+      }
+    });
+
+    auto start = chrono::steady_clock::now();
+    ds.compact();
+    auto end = chrono::steady_clock::now();
+    stop = true;
+    writer.join();
+
+    auto ns = chrono::duration<double, nano>(end - start).count();
+    Benchmark::report("compact, " + to_string(nr) + " tracks/users", ns);
+    Benchmark::report("longest write during compaction", maxNs);
+  }
+  removeDirectory(dir);
+}
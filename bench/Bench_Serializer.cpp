@@ -0,0 +1,112 @@
+/*****************************************************************************/
+/**
+ * @file    Bench_Serializer.cpp
+ * @author  Team Server
+ * @brief   Benchmarks for class Serializer
+ */
+/*****************************************************************************/
+
+#include <string>
+
+#include "Benchmark.h"
+#include "Network/ContentNegotiation.h"
+#include "TrackGenerator.h"
+#include "Utils/BinaryWriter.h"
+#include "Utils/JsonWriter.h"
+#include "Utils/Serializer.h"
+#include "json/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * Serializes the queue status as returned by getCurrentQueues. The baseline
+ * builds a JSON document first, as the handlers did before the JsonWriter.
+ */
+BENCHMARK(Serializer_QueueStatus) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(900, 100, true);
+
+  size_t lastSize = 0;
+  auto ns = Benchmark::measureNs(200, [&](size_t) {
+    string body;
+    body.reserve(lastSize);
+    JsonWriter writer(body);
+    writer.beginObject();
+    writer.key("admin_queue");
+    Serializer::serialize(status.adminQueue, writer);
+    writer.key("currently_playing");
+    Serializer::serialize(status.currentTrack.value(), writer);
+    writer.key("normal_queue");
+    Serializer::serialize(status.normalQueue, writer);
+    writer.key("version").value(status.version);
+    writer.endObject();
+    lastSize = body.size();
+    Benchmark::doNotOptimize(body);
+  });
+  Benchmark::report("JsonWriter, 1000 tracks", ns);
+
+  ns = Benchmark::measureNs(200, [&](size_t) {
+    json body = {
+        {"admin_queue", Serializer::serialize(status.adminQueue)},
+        {"currently_playing",
+         Serializer::serialize(status.currentTrack.value())},
+        {"normal_queue", Serializer::serialize(status.normalQueue)},
+        {"version", status.version}};
+    Benchmark::doNotOptimize(body.dump());
+  });
+  Benchmark::report("baseline: json document + dump, 1000 tracks", ns);
+
+  string title(200, 'a');
+  ns = Benchmark::measureNs(100000, [&](size_t) {
+    string out;
+    out.reserve(title.size());
+    JsonWriter::appendEscaped(title, out);
+    Benchmark::doNotOptimize(out);
+  });
+  Benchmark::report("appendEscaped, 200 characters", ns);
+}
+
+/**
+ * Creates the MessagePack body of the queue status. The baseline parses the
+ * JSON body into a document and converts it, as encodeResponse did before the
+ * BinaryWriter.
+ */
+BENCHMARK(Serializer_MessagePack) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(900, 100, true);
+
+  string jsonBody;
+  JsonWriter jsonWriter(jsonBody);
+  jsonWriter.beginObject();
+  jsonWriter.key("admin_queue");
+  Serializer::serialize(status.adminQueue, jsonWriter);
+  jsonWriter.key("normal_queue");
+  Serializer::serialize(status.normalQueue, jsonWriter);
+  jsonWriter.endObject();
+
+  auto ns = Benchmark::measureNs(200, [&](size_t) {
+    string body;
+    body.reserve(jsonBody.size());
+    BinaryWriter writer(body, BinaryFormat::MessagePack);
+    writer.beginObject();
+    writer.key("admin_queue");
+    Serializer::serialize(status.adminQueue, writer);
+    writer.key("normal_queue");
+    Serializer::serialize(status.normalQueue, writer);
+    writer.endObject();
+    Benchmark::doNotOptimize(body);
+  });
+  Benchmark::report("BinaryWriter, 1000 tracks", ns);
+
+  ns = Benchmark::measureNs(200, [&](size_t) {
+    Benchmark::doNotOptimize(
+        ContentNegotiation::encode(jsonBody, ResponseFormat::MessagePack));
+  });
+  Benchmark::report("transcoded from JSON, 1000 tracks", ns);
+
+  ns = Benchmark::measureNs(200, [&](size_t) {
+    Benchmark::doNotOptimize(json::to_msgpack(json::parse(jsonBody)));
+  });
+  Benchmark::report("baseline: json::parse + to_msgpack, 1000 tracks", ns);
+}
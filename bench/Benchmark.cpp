@@ -0,0 +1,56 @@
+/*****************************************************************************/
+/**
+ * @file    Benchmark.cpp
+ * @author  Team Server
+ * @brief   Benchmark registry and entrypoint of the benchmark executable
+ */
+/*****************************************************************************/
+
+#include "Benchmark.h"
+
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static vector<pair<string, Benchmark::TFunction>> &getRegistry() {
+  static vector<pair<string, Benchmark::TFunction>> registry;
+  return registry;
+}
+
+int Benchmark::registerBenchmark(char const *name, TFunction func) {
+  getRegistry().emplace_back(name, func);
+  return 0;
+}
+
+size_t Benchmark::run(string const &filter) {
+  size_t count = 0;
+  for (auto &&[name, func] : getRegistry()) {
+    if (name.find(filter) == string::npos) {
+      continue;
+    }
+    cout << "### " << name << endl;
+    func();
+    cout << endl;
+    count++;
+  }
+  return count;
+}
+
+void Benchmark::report(string const &label, double nsPerOp) {
+  cout << "  " << left << setw(48) << label << right << setw(12) << fixed
+       << setprecision(1) << nsPerOp << " ns/op" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  // an optional argument filters the benchmarks by name
+  string filter = (argc > 1) ? argv[1] : "";
+
+  if (Benchmark::run(filter) == 0) {
+    cerr << "No benchmark matches filter '" << filter << "'" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*****************************************************************************/
+/**
+ * @file    Benchmark.h
+ * @author  Team Server
+ * @brief   Minimal benchmark registry and timing helpers
+ */
+/*****************************************************************************/
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Registry for micro benchmarks.
+ * @details Benchmarks are registered using the `BENCHMARK` macro and are run
+ * by the benchmark executable. A benchmark is a plain function which uses
+ * `Benchmark::measureNs` to time its workload and `Benchmark::report` to print
+ * the results.
+ */
+class Benchmark {
+ public:
+  using TFunction = void (*)();
+
+  /**
+   * @brief Registers a benchmark function under the given name.
+   * @return Dummy value, so the function can be used in static initializers.
+   */
+  static int registerBenchmark(char const *name, TFunction func);
+
+  /**
+   * @brief Runs all registered benchmarks whose name contains `filter`.
+   * @return Number of benchmarks which have been run.
+   */
+  static size_t run(std::string const &filter);
+
+  /**
+   * @brief Prints a single result line.
+   * @param label Describes the measured workload (e.g. the parameter set).
+   * @param nsPerOp Measured nanoseconds per operation.
+   */
+  static void report(std::string const &label, double nsPerOp);
+
+  /**
+   * @brief Calls `func` `iterations` times and measures the elapsed time.
+   * @return Average nanoseconds per call.
+   */
+  template <class F>
+  static double measureNs(size_t iterations, F &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      func(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    return static_cast<double>(ns.count()) / iterations;
+  }
+
+  /**
+   * @brief Calls `func` `iterations` times on each of `threads` threads
+   * concurrently and measures the elapsed wall clock time.
+   * @details `func` gets the index of the calling thread and the iteration.
+   * @return Wall clock nanoseconds per call, i.e. the inverse throughput of
+   * all threads together.
+   */
+  template <class F>
+  static double measureParallelNs(size_t threads,
+                                  size_t iterations,
+                                  F &&func) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&func, t, iterations]() {
+        for (size_t i = 0; i < iterations; ++i) {
+          func(t, i);
+        }
+      });
+    }
+    for (auto &&worker : workers) {
+      worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    return static_cast<double>(ns.count()) / (threads * iterations);
+  }
+
+  /**
+   * @brief Prevents the compiler from optimizing away a computed value.
+   */
+  template <class T>
+  static void doNotOptimize(T const &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+  }
+};
+
+/**
+ * @brief Defines and registers a benchmark function.
+ */
+#define BENCHMARK(name)                          \
+  static void name();                            \
+  static int const name##Registered =            \
+      Benchmark::registerBenchmark(#name, name); \
+  static void name()
+
+#endif /* _BENCHMARK_H_ */
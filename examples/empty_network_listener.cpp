@@ -14,7 +14,9 @@
 
 #include <glog/logging.h>
 
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 #include "DummyData.h"
 #include "Network/RestAPI.h"
@@ -59,6 +61,36 @@ class EmptyNetworkListener : public NetworkListener {
     return status;
   }
 
+  TResult<uint64_t> waitForChange(TSessionID const &sid,
+                                  uint64_t since,
+                                  chrono::milliseconds timeout) override {
+    LOG(INFO) << "Session ID: " << sid;
+    LOG(INFO) << "Since version: " << since;
+    // nothing ever changes
+    this_thread::sleep_for(timeout);
+    return since;
+  }
+
+  TResult<EventBroadcaster *> getEvents(TSessionID const &sid) override {
+    LOG(INFO) << "Session ID: " << sid;
+    // nothing is ever published
+    return &mEvents;
+  }
+
+  TResult<TQueueSnapshot> getPreviousQueues(TSessionID const &sid,
+                                            uint64_t queueVersion) override {
+    LOG(INFO) << "Session ID: " << sid;
+    LOG(INFO) << "Queue version: " << queueVersion;
+    // no queues are kept, the clients always get the whole queues
+    return Error(ErrorCode::DoesntExist, "No previous queues available");
+  }
+
+  TResult<QueueStatusTag> getQueueStatusTag(TSessionID const &sid) override {
+    LOG(INFO) << "Session ID: " << sid;
+    // the queues never change and nobody can vote
+    return QueueStatusTag{0, 0};
+  }
+
   TResultOpt addTrackToQueue(TSessionID const &sid,
                              TTrackID const &trkid,
                              QueueType type) override {
@@ -88,6 +120,33 @@ class EmptyNetworkListener : public NetworkListener {
     return nullopt;
   }
 
+  TResult<vector<TResultOpt>> addTracksToQueue(TSessionID const &sid,
+                                               vector<TTrackID> const &trkids,
+                                               QueueType type) override {
+    LOG(INFO) << "Session ID: " << sid;
+    for (auto const &trkid : trkids) {
+      LOG(INFO) << "Track ID: " << trkid;
+    }
+    if (type == QueueType::Normal) {
+      LOG(INFO) << "Normal queue";
+    } else if (type == QueueType::Admin) {
+      LOG(INFO) << "Admin queue";
+    } else {
+      LOG(ERROR) << "Unknown queue type";
+      return Error(ErrorCode::InvalidValue, "Unknown queue type");
+    }
+    return vector<TResultOpt>(trkids.size());
+  }
+
+  TResultOpt voteTracks(TSessionID const &sid,
+                        vector<pair<TTrackID, TVote>> const &votes) override {
+    LOG(INFO) << "Session ID: " << sid;
+    for (auto const &[trkid, vote] : votes) {
+      LOG(INFO) << "Track ID: " << trkid << (vote ? " voted" : " revoked");
+    }
+    return nullopt;
+  }
+
   TResultOpt controlPlayer(TSessionID const &sid,
                            PlayerAction action) override {
     LOG(INFO) << "Session ID: " << sid;
@@ -123,6 +182,14 @@ class EmptyNetworkListener : public NetworkListener {
     LOG(INFO) << "Track ID: " << trkid;
     return nullopt;
   }
+  TResult<vector<TResultOpt>> removeTracks(
+      TSessionID const &sid, vector<TTrackID> const &trkids) override {
+    LOG(INFO) << "Session ID: " << sid;
+    for (auto const &trkid : trkids) {
+      LOG(INFO) << "Track ID: " << trkid;
+    }
+    return vector<TResultOpt>(trkids.size());
+  }
   TResultOpt moveTrack(TSessionID const &sid,
                        TTrackID const &trkid,
                        QueueType type) override {
@@ -130,6 +197,9 @@ class EmptyNetworkListener : public NetworkListener {
     LOG(INFO) << "Track ID: " << trkid;
     return nullopt;
   }
+
+ private:
+  EventBroadcaster mEvents;
 };
 
 int main(int argc, char *argv[]) {
@@ -9,11 +9,15 @@
 #ifndef _DATASTORE_H_
 #define _DATASTORE_H_
 
+#include <utility>
+#include <vector>
+
 #include "Types/GlobalTypes.h"
 #include "Types/Queue.h"
 #include "Types/Result.h"
 #include "Types/Tracks.h"
 #include "Types/User.h"
+#include "Utils/ChangeNotifier.h"
 
 /**
  * @class   DataStore
@@ -47,7 +51,10 @@ class DataStore {
   virtual TResult<User> removeUser(TSessionID const &sID) = 0;
 
   /**
-   * @brief    Check if user session is expired.
+   * @brief    Check if user session is expired. If not, the session is
+   * extended, since the user is active right now.
+   * @details  Sessions which are expired for more than
+   * cSessionRemovedAfterSeconds get removed together with their votes.
    * @param    sID Session ID of the user to check
    * @retval   Returns false if session is not expired yet. Returns an Error
    * object on session expiration or error.
@@ -72,6 +79,31 @@ class DataStore {
    */
   virtual TResult<BaseTrack> removeTrack(TTrackID const &tID, QueueType q) = 0;
 
+  /**
+   * @brief    Add multiple Tracks to one of the internal Queues at once
+   * @details  The Queues are locked and reordered only once for all Tracks.
+   * Tracks which are already queued or listed more than once are not added.
+   * @param    tracks The Tracks to add
+   * @param    q Identifier for determining which Queue the Tracks should
+   * be added to
+   * @return   Either the result for each Track (in the given order) or an
+   * Error message.
+   */
+  virtual TResult<std::vector<TResultOpt>> addTracks(
+      std::vector<BaseTrack> const &tracks, QueueType q) = 0;
+
+  /**
+   * @brief    Remove multiple Tracks from one of the internal Queues at once
+   * @details  The Queues are locked and reordered only once for all Tracks.
+   * @param    tIDs The IDs of the Tracks to remove
+   * @param    q Identifier for determining which Queue the Tracks should
+   * be removed from
+   * @return   Either the result for each Track (in the given order) or an
+   * Error message.
+   */
+  virtual TResult<std::vector<TResultOpt>> removeTracks(
+      std::vector<TTrackID> const &tIDs, QueueType q) = 0;
+
   /**
    * @brief    Check for Track in one of the internal Queues
    * @param    tID The ID of the Track to check for
@@ -81,6 +113,33 @@ class DataStore {
    */
   virtual TResult<bool> hasTrack(TTrackID const &tID, QueueType q) = 0;
 
+  /**
+   * @brief    Find the Queue which contains a Track
+   * @details  Tracks can only be queued in one Queue at a time, so a single
+   * lookup answers the question for both Queues.
+   * @param    tID The ID of the Track to look for
+   * @return   Either the Queue containing the Track, `nullopt` if the Track
+   * is not queued at all or an Error message.
+   */
+  virtual TResult<std::optional<QueueType>> locateTrack(
+      TTrackID const &tID) = 0;
+
+  /**
+   * @brief    Move a Track from one of the internal Queues to the other one
+   * @details  The Track is moved at once, it keeps its insertion time and
+   * never disappears from both Queues in between.
+   * @param    tID The ID of the Track to move
+   * @param    from Identifier of the Queue which contains the Track
+   * @param    to Identifier of the Queue the Track is moved to
+   * @param    keepVotes Determines whether the votes for the Track are kept,
+   * otherwise they are revoked like for a removed Track
+   * @return   An Error message or nothing at all (at success).
+   */
+  virtual TResultOpt moveTrack(TTrackID const &tID,
+                               QueueType from,
+                               QueueType to,
+                               bool keepVotes) = 0;
+
   /**
    * @brief    Upvote/remove Upvote from a track
    * @param    sID The ID of the User who wants to vote
@@ -93,6 +152,18 @@ class DataStore {
                                TTrackID const &tID,
                                TVote vote) = 0;
 
+  /**
+   * @brief    Upvote/remove Upvotes from multiple tracks at once
+   * @details  Same as voteTrack for every entry, but the Queues are locked
+   * and reordered only once.
+   * @param    sID The ID of the User who wants to vote
+   * @param    votes Pairs of the ID of the Track and the Vote
+   * @return   An Error message or nothing at all (at success).
+   */
+  virtual TResultOpt voteTracks(
+      TSessionID const &sID,
+      std::vector<std::pair<TTrackID, TVote>> const &votes) = 0;
+
   /**
    * @brief    Get entire Queue
    * @param    q Identifier for determining which Queue should be
@@ -101,6 +172,31 @@ class DataStore {
    */
   virtual TResult<Queue> getQueue(QueueType q) = 0;
 
+  /**
+   * @brief    Get an immutable snapshot of both Queues and the current Track
+   * @details  Snapshots are shared and must not be modified. As long as the
+   * Queues do not change, the same snapshot is returned to all callers, so
+   * reading it neither copies any Track nor blocks writers.
+   * @return   Either the current snapshot or an Error message.
+   */
+  virtual TResult<TQueueSnapshot> getQueueSnapshot() = 0;
+
+  /**
+   * @brief    Get the number of Tracks in one of the internal Queues
+   * @details  Constant time, no Queue is copied.
+   * @param    q Identifier for determining which Queue should be
+   * counted
+   * @return   Either the number of Tracks or an Error message.
+   */
+  virtual TResult<size_t> getQueueSize(QueueType q) = 0;
+
+  /**
+   * @brief    Check whether both internal Queues are empty
+   * @details  Constant time, no Queue is copied.
+   * @return   `true` if there is no Track left to play, `false` otherwise
+   */
+  virtual bool isEmpty() = 0;
+
   /**
    * @brief    Get the currently playing track.
    * @return   Returns the currently playing track (if any) or an Error message.
@@ -120,7 +216,17 @@ class DataStore {
    */
   virtual TResultOpt nextTrack() = 0;
 
+  /**
+   * @brief    Set a notifier which is notified whenever the queues or the
+   *           current track change.
+   * @param    notifier The notifier or `nullptr`, it is not owned.
+   */
+  virtual void setChangeNotifier(ChangeNotifier *notifier) = 0;
+
   static unsigned const cSessionTimeoutAfterSeconds = 3600;
+  /* Expired sessions are kept for this long, so their users are told that the
+   * session expired instead of it being unknown */
+  static unsigned const cSessionRemovedAfterSeconds = 3600;
 };
 
 #endif /* _DATASTORE_H_ */
@@ -0,0 +1,494 @@
+/*****************************************************************************/
+/**
+ * @file    Journal.cpp
+ * @author  Team Server
+ * @brief   Class Journal implementation
+ */
+/*****************************************************************************/
+
+#include "Datastore/Journal.h"
+
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "Utils/LoggingHandler.h"
+
+using namespace std;
+
+/*****************************************************************************
+ * Binary encoding
+ *
+ * All integers are stored in little endian byte order, strings are prefixed
+ * by their length. A framed record consists of the payload length (u32), the
+ * CRC32 of the payload (u32) and the payload itself.
+ *****************************************************************************/
+
+static array<uint32_t, 256> makeCrcTable() {
+  array<uint32_t, 256> table;
+  for (uint32_t i = 0; i < table.size(); i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++) {
+      c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+    }
+    table[i] = c;
+  }
+  return table;
+}
+
+static uint32_t crc32(char const *data, size_t size) {
+  static auto const table = makeCrcTable();
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < size; i++) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+static void putUInt(string &out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; i++) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+static void putString(string &out, string const &value) {
+  putUInt(out, value.size(), 4);
+  out.append(value);
+}
+
+static void putTrack(string &out, QueuedTrack const &track) {
+  putString(out, track.trackId);
+  putString(out, track.title);
+  putString(out, track.album);
+  putString(out, track.artist);
+  putUInt(out, track.durationMs, 4);
+  putString(out, track.iconUri);
+  putString(out, track.addedBy);
+  putUInt(out, static_cast<uint32_t>(track.votes), 4);
+  putUInt(out, track.insertedAt, 8);
+}
+
+namespace {
+/**
+ * @brief Reads the encoded values, fails on reads beyond the end.
+ */
+class Reader {
+ public:
+  Reader(char const *data, size_t size) : mData(data), mSize(size) {
+  }
+
+  bool getUInt(uint64_t &value, size_t bytes) {
+    if (mSize - mPos < bytes) {
+      return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+      value |= uint64_t(static_cast<uint8_t>(mData[mPos + i])) << (8 * i);
+    }
+    mPos += bytes;
+    return true;
+  }
+
+  bool getString(string &value) {
+    uint64_t size;
+    if (!getUInt(size, 4) || mSize - mPos < size) {
+      return false;
+    }
+    value.assign(mData + mPos, size);
+    mPos += size;
+    return true;
+  }
+
+  bool getTrack(QueuedTrack &track) {
+    uint64_t durationMs = 0, votes = 0, insertedAt = 0;
+    bool ok = getString(track.trackId) && getString(track.title) &&
+              getString(track.album) && getString(track.artist) &&
+              getUInt(durationMs, 4) && getString(track.iconUri) &&
+              getString(track.addedBy) && getUInt(votes, 4) &&
+              getUInt(insertedAt, 8);
+    track.durationMs = static_cast<unsigned>(durationMs);
+    track.votes = static_cast<int32_t>(static_cast<uint32_t>(votes));
+    track.insertedAt = insertedAt;
+    return ok;
+  }
+
+  bool atEnd() const {
+    return mPos == mSize;
+  }
+
+ private:
+  char const *mData;
+  size_t mSize;
+  size_t mPos = 0;
+};
+}  // namespace
+
+static bool decodePayload(char const *data, size_t size, JournalRecord &rec) {
+  Reader reader(data, size);
+  uint64_t type = 0, value = 0;
+  if (!reader.getUInt(type, 1) || !reader.getUInt(rec.lsn, 8)) {
+    return false;
+  }
+  rec.type = static_cast<JournalRecord::Type>(type);
+
+  bool ok = true;
+  switch (rec.type) {
+    case JournalRecord::Type::AddUser: {
+      uint64_t nrVotes;
+      ok = reader.getString(rec.user.SessionID) &&
+           reader.getUInt(value, 8) && reader.getString(rec.user.Name);
+      rec.user.ExpirationDate = static_cast<time_t>(value);
+      ok = ok && reader.getUInt(value, 1) && reader.getUInt(nrVotes, 4);
+      rec.user.isAdmin = value != 0;
+      for (uint64_t i = 0; ok && i < nrVotes; i++) {
+        string tID;
+        ok = reader.getString(tID);
+        rec.user.votes.insert(move(tID));
+      }
+    } break;
+    case JournalRecord::Type::RemoveUser:
+      ok = reader.getString(rec.sessionId);
+      break;
+    case JournalRecord::Type::SetSessionExpiration:
+      ok = reader.getString(rec.sessionId) && reader.getUInt(value, 8);
+      rec.expirationDate = static_cast<time_t>(value);
+      break;
+    case JournalRecord::Type::AddTrack:
+    case JournalRecord::Type::RemoveTrack:
+      ok = reader.getTrack(rec.track) && reader.getUInt(value, 1);
+      rec.queue = value ? QueueType::Admin : QueueType::Normal;
+      break;
+    case JournalRecord::Type::VoteTrack:
+      ok = reader.getString(rec.sessionId) &&
+           reader.getString(rec.track.trackId) && reader.getUInt(value, 1);
+      rec.vote = value != 0;
+      break;
+    case JournalRecord::Type::NextTrack:
+      break;
+    case JournalRecord::Type::MoveTrack:
+      ok = reader.getString(rec.track.trackId) && reader.getUInt(value, 1);
+      rec.queue = value ? QueueType::Admin : QueueType::Normal;
+      ok = ok && reader.getUInt(value, 1);
+      rec.vote = value != 0;
+      break;
+    default:
+      return false;
+  }
+  return ok && reader.atEnd();
+}
+
+JournalRecord::JournalRecord() : JournalRecord(Type::NextTrack) {
+}
+
+JournalRecord::JournalRecord(Type t) : type(t) {
+  user.ExpirationDate = 0;
+  user.isAdmin = false;
+  track.durationMs = 0;
+  track.votes = 0;
+  track.userHasVoted = false;
+  track.insertedAt = 0;
+}
+
+void Journal::encode(JournalRecord const &rec, string &out) {
+  string payload;
+  putUInt(payload, static_cast<uint8_t>(rec.type), 1);
+  putUInt(payload, rec.lsn, 8);
+
+  switch (rec.type) {
+    case JournalRecord::Type::AddUser:
+      putString(payload, rec.user.SessionID);
+      putUInt(payload, static_cast<uint64_t>(rec.user.ExpirationDate), 8);
+      putString(payload, rec.user.Name);
+      putUInt(payload, rec.user.isAdmin, 1);
+      putUInt(payload, rec.user.votes.size(), 4);
+      for (auto &&tID : rec.user.votes) {
+        putString(payload, tID);
+      }
+      break;
+    case JournalRecord::Type::RemoveUser:
+      putString(payload, rec.sessionId);
+      break;
+    case JournalRecord::Type::SetSessionExpiration:
+      putString(payload, rec.sessionId);
+      putUInt(payload, static_cast<uint64_t>(rec.expirationDate), 8);
+      break;
+    case JournalRecord::Type::AddTrack:
+    case JournalRecord::Type::RemoveTrack:
+      putTrack(payload, rec.track);
+      putUInt(payload, rec.queue == QueueType::Admin, 1);
+      break;
+    case JournalRecord::Type::VoteTrack:
+      putString(payload, rec.sessionId);
+      putString(payload, rec.track.trackId);
+      putUInt(payload, rec.vote, 1);
+      break;
+    case JournalRecord::Type::NextTrack:
+      break;
+    case JournalRecord::Type::MoveTrack:
+      putString(payload, rec.track.trackId);
+      putUInt(payload, rec.queue == QueueType::Admin, 1);
+      putUInt(payload, rec.vote, 1);
+      break;
+  }
+
+  putUInt(out, payload.size(), 4);
+  putUInt(out, crc32(payload.data(), payload.size()), 4);
+  out.append(payload);
+}
+
+size_t Journal::decode(string const &data,
+                       size_t offset,
+                       function<void(JournalRecord const &)> const &func) {
+  size_t const cFrameSize = 8;
+  while (data.size() - offset >= cFrameSize) {
+    Reader frame(data.data() + offset, cFrameSize);
+    uint64_t size, crc;
+    frame.getUInt(size, 4);
+    frame.getUInt(crc, 4);
+
+    char const *payload = data.data() + offset + cFrameSize;
+    if (data.size() - offset - cFrameSize < size ||
+        crc32(payload, size) != crc) {
+      // torn or corrupt record
+      break;
+    }
+
+    JournalRecord rec;
+    if (!decodePayload(payload, size, rec)) {
+      break;
+    }
+    func(rec);
+    offset += cFrameSize + size;
+  }
+  return offset;
+}
+
+/*****************************************************************************
+ * Journal file
+ *****************************************************************************/
+
+Journal::~Journal() {
+  close();
+}
+
+/**
+ * @brief Opens a journal file for appending, creates it if needed.
+ * @param validSize Size of the valid part of the file, everything behind is
+ * discarded.
+ * @return Either the file descriptor or an Error message.
+ */
+static TResult<int> openFile(string const &path, size_t validSize) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd < 0) {
+    return Error(ErrorCode::FileNotFound,
+                 "Failed to open journal '" + path + "': " + strerror(errno));
+  }
+
+  // discard a torn record at the end and write the header into new files
+  bool ok = true;
+  if (validSize < Journal::cHeaderSize) {
+    ok = ftruncate(fd, 0) == 0 &&
+         write(fd, Journal::cMagic, Journal::cHeaderSize) ==
+             ssize_t(Journal::cHeaderSize);
+  } else {
+    ok = ftruncate(fd, validSize) == 0;
+  }
+  ok = ok && fsync(fd) == 0;
+
+  // make a new file itself durable
+  string dir = path;
+  int dirFd = ::open(dirname(&dir[0]), O_RDONLY);
+  ok = ok && dirFd >= 0 && fsync(dirFd) == 0;
+  string reason = strerror(errno);
+  if (dirFd >= 0) {
+    ::close(dirFd);
+  }
+
+  if (!ok) {
+    ::close(fd);
+    return Error(ErrorCode::InvalidFormat,
+                 "Failed to prepare journal '" + path + "': " + reason);
+  }
+  return fd;
+}
+
+TResultOpt Journal::open(string const &path,
+                         size_t validSize,
+                         uint64_t nextLsn) {
+  close();
+
+  auto fd = openFile(path, validSize);
+  if (holds_alternative<Error>(fd)) {
+    return get<Error>(fd);
+  }
+
+  mFd = get<int>(fd);
+  mPath = path;
+  mLastLsn = nextLsn - 1;
+  mDurableLsn = mLastLsn;
+  mRecordCount = 0;
+  mStop = false;
+  mError = nullopt;
+  mWriter = thread(&Journal::writerThread, this);
+  return nullopt;
+}
+
+bool Journal::isOpen() const {
+  return mFd >= 0;
+}
+
+void Journal::close() {
+  if (mWriter.joinable()) {
+    {
+      unique_lock<mutex> lock(mMutex);
+      mStop = true;
+    }
+    mDataAvailable.notify_all();
+    mWriter.join();
+  }
+  for (int fd : mRetiredFds) {
+    ::close(fd);
+  }
+  mRetiredFds.clear();
+  if (mNextFd >= 0) {
+    ::close(mNextFd);
+    mNextFd = -1;
+  }
+  if (mFd >= 0) {
+    ::close(mFd);
+    mFd = -1;
+  }
+}
+
+uint64_t Journal::append(JournalRecord record) {
+  unique_lock<mutex> lock(mMutex);
+  record.lsn = ++mLastLsn;
+  encode(record, mBuffer);
+  mRecordCount++;
+  lock.unlock();
+
+  mDataAvailable.notify_one();
+  return record.lsn;
+}
+
+TResultOpt Journal::waitDurable(uint64_t lsn) {
+  unique_lock<mutex> lock(mMutex);
+  mDataWritten.wait(lock, [&]() { return mDurableLsn >= lsn || mError; });
+  return mError;
+}
+
+TResultOpt Journal::prepareRotation(string const &path) {
+  auto fd = openFile(path, 0);
+  if (holds_alternative<Error>(fd)) {
+    return get<Error>(fd);
+  }
+
+  unique_lock<mutex> lock(mMutex);
+  if (mNextFd >= 0) {
+    ::close(mNextFd);
+  }
+  mNextFd = get<int>(fd);
+  mNextPath = path;
+  return nullopt;
+}
+
+uint64_t Journal::rotate() {
+  unique_lock<mutex> lock(mMutex);
+  if (mNextFd < 0) {
+    return mLastLsn;
+  }
+
+  // the writer closes the old file once it is done with it
+  if (mWriting) {
+    mRetiredFds.push_back(mFd);
+  } else {
+    ::close(mFd);
+  }
+  mFd = mNextFd;
+  mPath = mNextPath;
+  mNextFd = -1;
+  mRecordCount = 0;
+  return mLastLsn;
+}
+
+size_t Journal::getRecordCount() {
+  unique_lock<mutex> lock(mMutex);
+  return mRecordCount;
+}
+
+uint64_t Journal::getLastLsn() {
+  unique_lock<mutex> lock(mMutex);
+  return mLastLsn;
+}
+
+void Journal::writerThread() {
+  unique_lock<mutex> lock(mMutex);
+  while (true) {
+    mDataAvailable.wait(lock, [&]() { return mStop || !mBuffer.empty(); });
+    if (mBuffer.empty()) {
+      break;
+    }
+
+    // everything appended so far gets committed at once
+    string data;
+    data.swap(mBuffer);
+    uint64_t lsn = mLastLsn;
+    int fd = mFd;
+    string path = mPath;
+    mWriting = true;
+    lock.unlock();
+
+    bool ok = true;
+    size_t written = 0;
+    while (ok && written < data.size()) {
+      auto ret = write(fd, data.data() + written, data.size() - written);
+      ok = ret > 0 || (ret < 0 && errno == EINTR);
+      written += (ret > 0) ? ret : 0;
+    }
+    ok = ok && fdatasync(fd) == 0;
+    string reason = ok ? "" : strerror(errno);
+
+    lock.lock();
+    mWriting = false;
+    for (int retiredFd : mRetiredFds) {
+      ::close(retiredFd);
+    }
+    mRetiredFds.clear();
+    if (ok) {
+      mDurableLsn = lsn;
+    } else if (!mError) {
+      mError = Error(ErrorCode::InvalidFormat,
+                     "Failed to write journal '" + path + "': " + reason);
+      LOG(ERROR) << mError->getErrorMessage();
+    }
+    mDataWritten.notify_all();
+  }
+}
+
+TResult<size_t> Journal::read(
+    string const &path,
+    function<void(JournalRecord const &)> const &func) {
+  ifstream file(path, ios::binary);
+  if (!file.is_open()) {
+    return size_t(0);
+  }
+  stringstream content;
+  content << file.rdbuf();
+  string data = content.str();
+
+  if (data.size() < cHeaderSize) {
+    // crashed while creating the file
+    return size_t(0);
+  }
+  if (data.compare(0, cHeaderSize, cMagic) != 0) {
+    return Error(ErrorCode::InvalidFormat,
+                 "File '" + path + "' is not a journal");
+  }
+  return decode(data, cHeaderSize, func);
+}
@@ -0,0 +1,176 @@
+/*****************************************************************************/
+/**
+ * @file    Journal.h
+ * @author  Team Server
+ * @brief   Class Journal definition
+ */
+/*****************************************************************************/
+
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Types/GlobalTypes.h"
+#include "Types/Result.h"
+#include "Types/Tracks.h"
+#include "Types/User.h"
+
+/**
+ * @brief Single mutation of a DataStore, as written to the journal.
+ * @details Only the fields belonging to the record type are used.
+ */
+struct JournalRecord {
+  enum class Type : uint8_t {
+    AddUser = 1,           // user
+    RemoveUser,            // sessionId
+    SetSessionExpiration,  // sessionId, expirationDate
+    AddTrack,              // track (incl. votes and insertedAt), queue
+    RemoveTrack,           // track.trackId, queue
+    VoteTrack,             // sessionId, track.trackId, vote
+    NextTrack,             // -
+    MoveTrack              // track.trackId, queue (target), vote (keep votes)
+  };
+
+  Type type = Type::NextTrack;
+  // log sequence number, assigned by the journal
+  uint64_t lsn = 0;
+
+  User user;
+  TSessionID sessionId;
+  std::time_t expirationDate = 0;
+  QueuedTrack track;
+  QueueType queue = QueueType::Normal;
+  TVote vote = false;
+
+  JournalRecord();
+  explicit JournalRecord(Type t);
+};
+
+/**
+ * @brief Append-only, checksummed journal file with group commit.
+ * @details Records are appended to an in-memory buffer. A background thread
+ * writes the buffer and syncs it to disk, all records which have been appended
+ * in the meantime are committed together with a single sync. Every record is
+ * framed by its length and a CRC32 checksum, so a torn write at the end of the
+ * file is detected and discarded while reading.
+ */
+class Journal {
+ public:
+  Journal() = default;
+  ~Journal();
+
+  /**
+   * @brief Opens (or creates) the journal file for appending and starts the
+   * background writer.
+   * @param path Path of the journal file.
+   * @param validSize Size of the valid part of an existing file (as returned
+   * by read), everything behind is discarded.
+   * @param nextLsn Sequence number of the next appended record.
+   * @return An Error message or nothing at all (at success).
+   */
+  TResultOpt open(std::string const &path, size_t validSize, uint64_t nextLsn);
+
+  bool isOpen() const;
+
+  /**
+   * @brief Appends a record, it gets written asynchronously.
+   * @return The sequence number assigned to the record.
+   */
+  uint64_t append(JournalRecord record);
+
+  /**
+   * @brief Blocks until all records up to `lsn` are synced to disk.
+   * @return An Error message if writing the journal failed.
+   */
+  TResultOpt waitDurable(uint64_t lsn);
+
+  /**
+   * @brief Creates the file which the journal continues in after the next
+   * rotate. Nothing is locked, appending continues meanwhile.
+   * @param path Path of the new journal file.
+   * @return An Error message or nothing at all (at success).
+   */
+  TResultOpt prepareRotation(std::string const &path);
+
+  /**
+   * @brief Continues the journal in the file created by prepareRotation.
+   * @details Does not wait for any I/O. Records which have not been written
+   * yet go to the new file, so it may start with some records of the old
+   * one.
+   * @return Sequence number of the last record appended before rotating,
+   * all later records are in the new file.
+   */
+  uint64_t rotate();
+
+  /**
+   * @brief Number of records appended since opening or the last rotation.
+   */
+  size_t getRecordCount();
+
+  /**
+   * @brief Sequence number of the last appended record.
+   */
+  uint64_t getLastLsn();
+
+  /**
+   * @brief Reads all valid records of a journal file.
+   * @param path Path of the journal file, a missing file is treated as empty.
+   * @param func Called for every record in order.
+   * @return Either the size of the valid part of the file or an Error message.
+   */
+  static TResult<size_t> read(
+      std::string const &path,
+      std::function<void(JournalRecord const &)> const &func);
+
+  /**
+   * @brief Appends the framed binary representation of a record to `out`.
+   */
+  static void encode(JournalRecord const &record, std::string &out);
+
+  /**
+   * @brief Decodes all framed records in `data`, stops at the first
+   * incomplete or corrupt record.
+   * @return Number of valid bytes.
+   */
+  static size_t decode(std::string const &data,
+                       size_t offset,
+                       std::function<void(JournalRecord const &)> const &func);
+
+  // Magic number at the beginning of every journal file
+  static constexpr char cMagic[] = "VJBJRNL1";
+  static size_t const cHeaderSize = 8;
+
+ private:
+  void writerThread();
+  void close();
+
+  int mFd = -1;
+  std::string mPath;
+  // file prepared for the next rotation
+  int mNextFd = -1;
+  std::string mNextPath;
+  // files rotated away while the writer was still using them
+  std::vector<int> mRetiredFds;
+
+  std::mutex mMutex;
+  std::condition_variable mDataAvailable;
+  std::condition_variable mDataWritten;
+  std::string mBuffer;
+  uint64_t mLastLsn = 0;
+  uint64_t mDurableLsn = 0;
+  size_t mRecordCount = 0;
+  bool mWriting = false;
+  bool mStop = false;
+  std::optional<Error> mError;
+  std::thread mWriter;
+};
+
+#endif /* _JOURNAL_H_ */
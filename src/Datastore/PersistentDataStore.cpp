@@ -0,0 +1,684 @@
+/*****************************************************************************/
+/**
+ * @file    PersistentDataStore.cpp
+ * @author  Team Server
+ * @brief   Class PersistentDataStore implementation
+ */
+/*****************************************************************************/
+
+#include "Datastore/PersistentDataStore.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+#include "Datastore/SnapshotFile.h"
+#include "Utils/LoggingHandler.h"
+
+using namespace std;
+
+PersistentDataStore::~PersistentDataStore() {
+  if (mLoader.joinable()) {
+    mLoader.join();
+  }
+  if (mCompactor.joinable()) {
+    {
+      unique_lock<mutex> lock(mCompactorMutex);
+      mStopCompactor = true;
+    }
+    mCompactorWakeup.notify_all();
+    mCompactor.join();
+  }
+}
+
+string PersistentDataStore::getSnapshotPath() const {
+  return mDirectory + "/snapshot.bin";
+}
+
+string PersistentDataStore::getJournalPath(uint64_t generation) const {
+  return mDirectory + "/journal." + to_string(generation) + ".bin";
+}
+
+vector<uint64_t> PersistentDataStore::getJournalGenerations() const {
+  vector<uint64_t> generations;
+  DIR *dir = opendir(mDirectory.c_str());
+  if (dir == nullptr) {
+    return generations;
+  }
+
+  // journal files are named journal.<generation>.bin
+  string const prefix = "journal.";
+  string const suffix = ".bin";
+  while (auto entry = readdir(dir)) {
+    string name = entry->d_name;
+    if (name.size() <= prefix.size() + suffix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) !=
+            0) {
+      continue;
+    }
+    auto number = name.substr(prefix.size(),
+                              name.size() - prefix.size() - suffix.size());
+    if (all_of(number.begin(), number.end(),
+               [](unsigned char c) { return isdigit(c); })) {
+      generations.push_back(stoull(number));
+    }
+  }
+  closedir(dir);
+
+  sort(generations.begin(), generations.end());
+  return generations;
+}
+
+TResultOpt PersistentDataStore::open(string const &directory) {
+  unique_lock<mutex> MyLock(mWriteMutex);
+
+  if (mJournal.isOpen()) {
+    return Error(ErrorCode::AlreadyExists, "DataStore is already opened");
+  }
+  if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    return Error(ErrorCode::FileNotFound, "Failed to create directory '" +
+                                              directory +
+                                              "': " + strerror(errno));
+  }
+  mDirectory = directory;
+
+  // replaying must not depend on the current time: a session whose
+  // expiration date has passed may still be extended by a later record
+  mStore.suspendSessionReaping();
+  auto ret = restore();
+  if (ret.has_value()) {
+    mStore.resumeSessionReaping();
+    return ret;
+  }
+
+  mCompactor = thread(&PersistentDataStore::compactionThread, this);
+  return nullopt;
+}
+
+TResultOpt PersistentDataStore::restore() {
+  auto start = chrono::steady_clock::now();
+  size_t nrRecords = 0;
+
+  auto loading = make_shared<LoadingState>();
+  auto &snapshot = loading->snapshot;
+  auto ret = snapshot.open(getSnapshotPath());
+  if (ret.has_value() &&
+      ret.value().getErrorCode() != ErrorCode::FileNotFound) {
+    return ret;
+  }
+  uint64_t snapshotLsn = snapshot.getLsn();
+
+  // replay all modifications which happened after the snapshot, older
+  // journal files are left behind if compacting did not finish. The snapshot
+  // has to be loaded before the first modification is replayed.
+  bool loaded = false;
+  uint64_t lastLsn = snapshotLsn;
+  size_t validSize = 0;
+  auto generations = getJournalGenerations();
+  for (auto generation : generations) {
+    auto size = Journal::read(
+        getJournalPath(generation), [&](JournalRecord const &rec) {
+          // a journal may start with records of the previous one
+          if (rec.lsn <= lastLsn) {
+            return;
+          }
+          if (!loaded) {
+            mStore.loadSnapshot(snapshot);
+            loaded = true;
+          }
+          apply(rec);
+          lastLsn = rec.lsn;
+          nrRecords++;
+        });
+    if (holds_alternative<Error>(size)) {
+      return get<Error>(size);
+    }
+    validSize = get<size_t>(size);
+  }
+
+  // appending continues in the newest journal
+  mJournalGeneration = generations.empty() ? 1 : generations.back();
+  ret = mJournal.open(getJournalPath(mJournalGeneration), validSize,
+                      lastLsn + 1);
+  if (ret.has_value()) {
+    return ret;
+  }
+
+  if (!loaded) {
+    // the snapshot is the current state, it is served from the mapping
+    // while it gets loaded
+    auto queues = make_shared<QueueSnapshot>(snapshot.getQueues());
+    queues->version = 1;
+    loading->queues = queues;
+    atomic_store(&mLoading, shared_ptr<LoadingState const>(loading));
+    mLoader = thread(&PersistentDataStore::loaderThread, this, loading, start);
+    return nullopt;
+  }
+
+  // sessions which expired while the server was down are removed now
+  mStore.resumeSessionReaping();
+
+  auto duration = chrono::duration_cast<chrono::milliseconds>(
+      chrono::steady_clock::now() - start);
+  LOG(INFO) << "PersistentDataStore: Restored "
+            << snapshot.getTrackCount(QueueType::Admin) +
+                   snapshot.getTrackCount(QueueType::Normal) +
+                   snapshot.getUserCount() + nrRecords
+            << " records from '" << mDirectory << "' in " << duration.count()
+            << " ms";
+  return nullopt;
+}
+
+void PersistentDataStore::loaderThread(shared_ptr<LoadingState const> loading,
+                                       chrono::steady_clock::time_point start) {
+  auto const &snapshot = loading->snapshot;
+  mStore.loadSnapshot(snapshot);
+  // sessions which expired while the server was down are removed now
+  mStore.resumeSessionReaping();
+
+  {
+    unique_lock<mutex> lock(mLoaderMutex);
+    atomic_store(&mLoading, shared_ptr<LoadingState const>());
+  }
+  mLoaded.notify_all();
+
+  auto duration = chrono::duration_cast<chrono::milliseconds>(
+      chrono::steady_clock::now() - start);
+  LOG(INFO) << "PersistentDataStore: Loaded "
+            << snapshot.getTrackCount(QueueType::Admin) +
+                   snapshot.getTrackCount(QueueType::Normal) +
+                   snapshot.getUserCount()
+            << " records from '" << mDirectory << "' in " << duration.count()
+            << " ms";
+}
+
+shared_ptr<PersistentDataStore::LoadingState const>
+PersistentDataStore::getLoadingState() {
+  return atomic_load(&mLoading);
+}
+
+void PersistentDataStore::waitUntilLoaded() {
+  if (!getLoadingState()) {
+    return;
+  }
+  unique_lock<mutex> lock(mLoaderMutex);
+  mLoaded.wait(lock, [&]() { return !getLoadingState(); });
+}
+
+TResultOpt PersistentDataStore::compact() {
+  waitUntilLoaded();
+
+  // only one compaction at a time
+  unique_lock<mutex> MyCompactLock(mCompactMutex);
+
+  uint64_t generation;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    if (!mJournal.isOpen()) {
+      return Error(ErrorCode::NotInitialized, "DataStore is not opened");
+    }
+    generation = mJournalGeneration + 1;
+  }
+
+  auto ret = mJournal.prepareRotation(getJournalPath(generation));
+  if (ret.has_value()) {
+    return ret;
+  }
+
+  // writers are only blocked while the state is copied, the journal
+  // continues in the new file afterwards
+  TQueueSnapshot queues;
+  vector<User> users;
+  uint64_t lsn;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    mStore.getState(queues, users);
+    lsn = mJournal.rotate();
+    mJournalGeneration = generation;
+  }
+
+  ret = SnapshotFile::write(getSnapshotPath(), *queues, users, lsn);
+  if (ret.has_value()) {
+    // the old journals are still needed to restore the state
+    return ret;
+  }
+
+  // older journals are contained in the snapshot once it is on disk
+  for (auto oldGeneration : getJournalGenerations()) {
+    if (oldGeneration < generation) {
+      unlink(getJournalPath(oldGeneration).c_str());
+    }
+  }
+  return nullopt;
+}
+
+uint64_t PersistentDataStore::journal(JournalRecord const &record) {
+  // must be called with mWriteMutex held
+  if (!mJournal.isOpen()) {
+    return 0;
+  }
+  return mJournal.append(record);
+}
+
+void PersistentDataStore::commit(uint64_t lsn, bool wait) {
+  if (lsn == 0) {
+    return;
+  }
+
+  if (wait) {
+    auto ret = mJournal.waitDurable(lsn);
+    if (ret.has_value()) {
+      // the modification has been done already, only persisting it failed
+      LOG(ERROR) << "PersistentDataStore: " << ret->getErrorMessage();
+    }
+  }
+
+  if (mJournal.getRecordCount() >= cCompactAfterRecords) {
+    {
+      unique_lock<mutex> lock(mCompactorMutex);
+      mCompactionRequested = true;
+    }
+    mCompactorWakeup.notify_one();
+  }
+}
+
+void PersistentDataStore::compactionThread() {
+  unique_lock<mutex> lock(mCompactorMutex);
+  while (true) {
+    mCompactorWakeup.wait(
+        lock, [&]() { return mStopCompactor || mCompactionRequested; });
+    if (mStopCompactor) {
+      break;
+    }
+    mCompactionRequested = false;
+    lock.unlock();
+
+    // requests which came in while compacting are done already
+    if (mJournal.getRecordCount() >= cCompactAfterRecords) {
+      auto ret = compact();
+      if (ret.has_value()) {
+        LOG(ERROR) << "PersistentDataStore: " << ret->getErrorMessage();
+      }
+    }
+
+    lock.lock();
+  }
+}
+
+void PersistentDataStore::apply(JournalRecord const &rec) {
+  // errors are ignored, the same modification failed before as well
+  switch (rec.type) {
+    case JournalRecord::Type::AddUser:
+      mStore.addUser(rec.user);
+      break;
+    case JournalRecord::Type::RemoveUser:
+      mStore.removeUser(rec.sessionId);
+      break;
+    case JournalRecord::Type::SetSessionExpiration:
+      mStore.setSessionExpiration(rec.sessionId, rec.expirationDate);
+      break;
+    case JournalRecord::Type::AddTrack:
+      mStore.addTrack(rec.track, rec.queue, rec.track.insertedAt,
+                      rec.track.votes);
+      break;
+    case JournalRecord::Type::RemoveTrack:
+      mStore.removeTrack(rec.track.trackId, rec.queue);
+      break;
+    case JournalRecord::Type::VoteTrack:
+      mStore.voteTrack(rec.sessionId, rec.track.trackId, rec.vote);
+      break;
+    case JournalRecord::Type::NextTrack:
+      mStore.nextTrack();
+      break;
+    case JournalRecord::Type::MoveTrack: {
+      // a track can only be moved from the other queue
+      QueueType from = rec.queue == QueueType::Admin ? QueueType::Normal
+                                                     : QueueType::Admin;
+      mStore.moveTrack(rec.track.trackId, from, rec.queue, rec.vote);
+    } break;
+  }
+}
+
+TResultOpt PersistentDataStore::addUser(User const &user) {
+  waitUntilLoaded();
+  uint64_t lsn;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    auto ret = mStore.addUser(user);
+    if (ret.has_value()) {
+      return ret;
+    }
+
+    JournalRecord rec(JournalRecord::Type::AddUser);
+    rec.user = user;
+    lsn = journal(rec);
+  }
+  commit(lsn, true);
+  return nullopt;
+}
+
+TResult<User> PersistentDataStore::getUser(TSessionID const &ID) {
+  auto loading = getLoadingState();
+  if (loading) {
+    auto user = loading->snapshot.findUser(ID);
+    if (!user.has_value()) {
+      return Error(ErrorCode::DoesntExist, "User doesn't exist");
+    }
+    return user.value();
+  }
+  return mStore.getUser(ID);
+}
+
+TResult<User> PersistentDataStore::removeUser(TSessionID const &ID) {
+  waitUntilLoaded();
+  uint64_t lsn;
+  TResult<User> ret;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    ret = mStore.removeUser(ID);
+    if (holds_alternative<Error>(ret)) {
+      return ret;
+    }
+
+    JournalRecord rec(JournalRecord::Type::RemoveUser);
+    rec.sessionId = ID;
+    lsn = journal(rec);
+  }
+  commit(lsn, true);
+  return ret;
+}
+
+TResult<bool> PersistentDataStore::isSessionExpired(TSessionID const &ID) {
+  auto loading = getLoadingState();
+  if (loading) {
+    // sessions are only checked, they are extended again after loading
+    auto user = loading->snapshot.findUser(ID);
+    if (!user.has_value()) {
+      return Error(ErrorCode::DoesntExist, "User doesn't exist");
+    }
+    if (time(nullptr) >= user->ExpirationDate) {
+      return Error(ErrorCode::SessionExpired,
+                   "Session expired for user ID '" + ID + "'.");
+    }
+    return false;
+  }
+
+  auto ret = mStore.extendSession(ID);
+  if (holds_alternative<Error>(ret)) {
+    return get<Error>(ret);
+  }
+
+  auto expirationDate = get<optional<time_t>>(ret);
+  if (expirationDate.has_value()) {
+    uint64_t lsn;
+    {
+      unique_lock<mutex> MyLock(mWriteMutex);
+      JournalRecord rec(JournalRecord::Type::SetSessionExpiration);
+      rec.sessionId = ID;
+      rec.expirationDate = expirationDate.value();
+      lsn = journal(rec);
+    }
+    // losing an extension only shortens the session, no need to wait
+    commit(lsn, false);
+  }
+  return false;
+}
+
+TResultOpt PersistentDataStore::addTrack(BaseTrack const &track, QueueType q) {
+  waitUntilLoaded();
+  uint64_t lsn;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    uint64_t insertedAt = time(nullptr);
+    auto ret = mStore.addTrack(track, q, insertedAt, 0);
+    if (ret.has_value()) {
+      return ret;
+    }
+
+    JournalRecord rec(JournalRecord::Type::AddTrack);
+    static_cast<BaseTrack &>(rec.track) = track;
+    rec.track.insertedAt = insertedAt;
+    rec.queue = q;
+    lsn = journal(rec);
+  }
+  commit(lsn, true);
+  return nullopt;
+}
+
+TResult<BaseTrack> PersistentDataStore::removeTrack(TTrackID const &ID,
+                                                    QueueType q) {
+  waitUntilLoaded();
+  uint64_t lsn;
+  TResult<BaseTrack> ret;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    ret = mStore.removeTrack(ID, q);
+    if (holds_alternative<Error>(ret)) {
+      return ret;
+    }
+
+    JournalRecord rec(JournalRecord::Type::RemoveTrack);
+    rec.track.trackId = ID;
+    rec.queue = q;
+    lsn = journal(rec);
+  }
+  commit(lsn, true);
+  return ret;
+}
+
+TResultOpt PersistentDataStore::moveTrack(TTrackID const &ID,
+                                          QueueType from,
+                                          QueueType to,
+                                          bool keepVotes) {
+  waitUntilLoaded();
+  uint64_t lsn;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    auto ret = mStore.moveTrack(ID, from, to, keepVotes);
+    if (ret.has_value()) {
+      return ret;
+    }
+
+    JournalRecord rec(JournalRecord::Type::MoveTrack);
+    rec.track.trackId = ID;
+    rec.queue = to;
+    rec.vote = keepVotes;
+    lsn = journal(rec);
+  }
+  commit(lsn, true);
+  return nullopt;
+}
+
+TResult<vector<TResultOpt>> PersistentDataStore::addTracks(
+    vector<BaseTrack> const &tracks, QueueType q) {
+  waitUntilLoaded();
+  uint64_t lsn = 0;
+  TResult<vector<TResultOpt>> ret;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    uint64_t insertedAt = time(nullptr);
+    ret = mStore.addTracks(tracks, q, insertedAt);
+    if (holds_alternative<Error>(ret)) {
+      return ret;
+    }
+
+    auto const &results = get<vector<TResultOpt>>(ret);
+    for (size_t i = 0; i < tracks.size(); i++) {
+      if (results[i].has_value()) {
+        continue;
+      }
+      JournalRecord rec(JournalRecord::Type::AddTrack);
+      static_cast<BaseTrack &>(rec.track) = tracks[i];
+      rec.track.insertedAt = insertedAt;
+      rec.queue = q;
+      lsn = journal(rec);
+    }
+  }
+  // the whole batch is committed together
+  commit(lsn, true);
+  return ret;
+}
+
+TResult<vector<TResultOpt>> PersistentDataStore::removeTracks(
+    vector<TTrackID> const &IDs, QueueType q) {
+  waitUntilLoaded();
+  uint64_t lsn = 0;
+  TResult<vector<TResultOpt>> ret;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    ret = mStore.removeTracks(IDs, q);
+    if (holds_alternative<Error>(ret)) {
+      return ret;
+    }
+
+    auto const &results = get<vector<TResultOpt>>(ret);
+    for (size_t i = 0; i < IDs.size(); i++) {
+      if (results[i].has_value()) {
+        continue;
+      }
+      JournalRecord rec(JournalRecord::Type::RemoveTrack);
+      rec.track.trackId = IDs[i];
+      rec.queue = q;
+      lsn = journal(rec);
+    }
+  }
+  commit(lsn, true);
+  return ret;
+}
+
+TResult<bool> PersistentDataStore::hasTrack(TTrackID const &ID, QueueType q) {
+  waitUntilLoaded();
+  return mStore.hasTrack(ID, q);
+}
+
+TResult<optional<QueueType>> PersistentDataStore::locateTrack(
+    TTrackID const &ID) {
+  waitUntilLoaded();
+  return mStore.locateTrack(ID);
+}
+
+TResultOpt PersistentDataStore::voteTrack(TSessionID const &sID,
+                                          TTrackID const &tID,
+                                          TVote vote) {
+  waitUntilLoaded();
+  uint64_t lsn;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    auto ret = mStore.voteTrack(sID, tID, vote);
+    if (ret.has_value()) {
+      return ret;
+    }
+
+    JournalRecord rec(JournalRecord::Type::VoteTrack);
+    rec.sessionId = sID;
+    rec.track.trackId = tID;
+    rec.vote = vote;
+    lsn = journal(rec);
+  }
+  commit(lsn, true);
+  return nullopt;
+}
+
+TResultOpt PersistentDataStore::voteTracks(
+    TSessionID const &sID, vector<pair<TTrackID, TVote>> const &votes) {
+  waitUntilLoaded();
+  uint64_t lsn = 0;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    auto ret = mStore.voteTracks(sID, votes);
+    if (ret.has_value()) {
+      return ret;
+    }
+
+    for (auto &&[tID, vote] : votes) {
+      JournalRecord rec(JournalRecord::Type::VoteTrack);
+      rec.sessionId = sID;
+      rec.track.trackId = tID;
+      rec.vote = vote;
+      lsn = journal(rec);
+    }
+  }
+  commit(lsn, true);
+  return nullopt;
+}
+
+TResult<Queue> PersistentDataStore::getQueue(QueueType q) {
+  auto loading = getLoadingState();
+  if (loading) {
+    if (q == QueueType::Admin) {
+      return loading->queues->adminQueue;
+    } else if (q == QueueType::Normal) {
+      return loading->queues->normalQueue;
+    }
+  }
+  return mStore.getQueue(q);
+}
+
+TResult<TQueueSnapshot> PersistentDataStore::getQueueSnapshot() {
+  auto loading = getLoadingState();
+  if (loading) {
+    return loading->queues;
+  }
+  return mStore.getQueueSnapshot();
+}
+
+TResult<size_t> PersistentDataStore::getQueueSize(QueueType q) {
+  auto loading = getLoadingState();
+  if (loading && (q == QueueType::Admin || q == QueueType::Normal)) {
+    return loading->snapshot.getTrackCount(q);
+  }
+  return mStore.getQueueSize(q);
+}
+
+bool PersistentDataStore::isEmpty() {
+  auto loading = getLoadingState();
+  if (loading) {
+    return loading->snapshot.getTrackCount(QueueType::Admin) == 0 &&
+           loading->snapshot.getTrackCount(QueueType::Normal) == 0;
+  }
+  return mStore.isEmpty();
+}
+
+TResult<optional<QueuedTrack>> PersistentDataStore::getPlayingTrack() {
+  auto loading = getLoadingState();
+  if (loading) {
+    return loading->queues->currentTrack;
+  }
+  return mStore.getPlayingTrack();
+}
+
+bool PersistentDataStore::hasUser(TSessionID const &ID) {
+  auto loading = getLoadingState();
+  if (loading) {
+    return loading->snapshot.findUser(ID).has_value();
+  }
+  return mStore.hasUser(ID);
+}
+
+void PersistentDataStore::setChangeNotifier(ChangeNotifier *notifier) {
+  mStore.setChangeNotifier(notifier);
+}
+
+TResultOpt PersistentDataStore::nextTrack() {
+  waitUntilLoaded();
+  uint64_t lsn;
+  {
+    unique_lock<mutex> MyLock(mWriteMutex);
+    auto ret = mStore.nextTrack();
+    if (ret.has_value()) {
+      return ret;
+    }
+
+    lsn = journal(JournalRecord(JournalRecord::Type::NextTrack));
+  }
+  commit(lsn, true);
+  return nullopt;
+}
@@ -0,0 +1,156 @@
+/*****************************************************************************/
+/**
+ * @file    PersistentDataStore.h
+ * @author  Team Server
+ * @brief   Class PersistentDataStore definition
+ */
+/*****************************************************************************/
+
+#ifndef _PERSISTENTDATASTORE_H_
+#define _PERSISTENTDATASTORE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DataStore.h"
+#include "Datastore/Journal.h"
+#include "Datastore/RAMDataStore.h"
+#include "Datastore/SnapshotFile.h"
+#include "Types/GlobalTypes.h"
+#include "Types/Queue.h"
+#include "Types/Result.h"
+#include "Types/Tracks.h"
+#include "Types/User.h"
+
+/**
+ * @brief Implements a DataStore which keeps all data in RAM (see RAMDataStore)
+ * and persists every modification, so the state survives a restart.
+ * @details Modifications are appended to a checksummed journal and committed
+ * in groups (see Journal). Once the journal grows too large, a compacted
+ * snapshot of the whole state is written (see SnapshotFile) and the journal
+ * continues in a new file. On startup the snapshot is loaded and the
+ * journals are replayed.
+ *
+ * Modifications are applied and appended to the journal under a single
+ * mutex, so the journal reflects the exact order of modifications. Waiting
+ * for the journal to be synced to disk happens outside of this mutex.
+ *
+ * If no modifications have to be replayed, the snapshot is loaded in the
+ * background: until it is loaded, the queues and users are read directly
+ * from the mapped snapshot and all other calls wait for the loading.
+ *
+ * Expired sessions are not journaled, they are removed again after
+ * restoring. While restoring, no sessions are removed, so the restored state
+ * does not depend on how long restoring takes.
+ */
+class PersistentDataStore : public DataStore {
+ public:
+  PersistentDataStore() = default;
+  ~PersistentDataStore();
+
+  /**
+   * @brief Restores the state saved in `directory` and persists all further
+   * modifications there. Without calling open, nothing is persisted.
+   * @param directory Directory for the snapshot and the journal, it is
+   * created if it does not exist.
+   * @return An Error message or nothing at all (at success).
+   */
+  TResultOpt open(std::string const &directory);
+
+  /**
+   * @brief Writes a snapshot of the current state and deletes the journals
+   * contained in it.
+   * @details Called automatically after cCompactAfterRecords modifications.
+   * Modifications are only blocked while the state is copied, the snapshot
+   * is written concurrently.
+   * @return An Error message or nothing at all (at success).
+   */
+  TResultOpt compact();
+
+  TResultOpt addUser(User const &user) override;
+  TResult<User> getUser(TSessionID const &ID) override;
+  TResult<User> removeUser(TSessionID const &ID) override;
+  TResult<bool> isSessionExpired(TSessionID const &ID) override;
+  TResultOpt addTrack(BaseTrack const &track, QueueType q) override;
+  TResult<BaseTrack> removeTrack(TTrackID const &ID, QueueType q) override;
+  TResult<std::vector<TResultOpt>> addTracks(
+      std::vector<BaseTrack> const &tracks, QueueType q) override;
+  TResult<std::vector<TResultOpt>> removeTracks(
+      std::vector<TTrackID> const &IDs, QueueType q) override;
+  TResult<bool> hasTrack(TTrackID const &ID, QueueType q) override;
+  TResult<std::optional<QueueType>> locateTrack(TTrackID const &ID) override;
+  TResultOpt moveTrack(TTrackID const &ID,
+                       QueueType from,
+                       QueueType to,
+                       bool keepVotes) override;
+  TResultOpt voteTrack(TSessionID const &sID,
+                       TTrackID const &tID,
+                       TVote vote) override;
+  TResultOpt voteTracks(
+      TSessionID const &sID,
+      std::vector<std::pair<TTrackID, TVote>> const &votes) override;
+  TResult<Queue> getQueue(QueueType q) override;
+  TResult<TQueueSnapshot> getQueueSnapshot() override;
+  TResult<size_t> getQueueSize(QueueType q) override;
+  bool isEmpty() override;
+  TResult<std::optional<QueuedTrack>> getPlayingTrack() override;
+  bool hasUser(TSessionID const &ID) override;
+  TResultOpt nextTrack() override;
+  void setChangeNotifier(ChangeNotifier *notifier) override;
+
+  static size_t const cCompactAfterRecords = 100000;
+
+ private:
+  /**
+   * @brief State which is served while the snapshot is loaded.
+   */
+  struct LoadingState {
+    SnapshotFile snapshot;
+    TQueueSnapshot queues;
+  };
+
+  TResultOpt restore();
+  void loaderThread(std::shared_ptr<LoadingState const> loading,
+                    std::chrono::steady_clock::time_point start);
+  std::shared_ptr<LoadingState const> getLoadingState();
+  void waitUntilLoaded();
+  uint64_t journal(JournalRecord const &record);
+  void commit(uint64_t lsn, bool wait);
+  void apply(JournalRecord const &record);
+  void compactionThread();
+
+  std::string getSnapshotPath() const;
+  std::string getJournalPath(uint64_t generation) const;
+  std::vector<uint64_t> getJournalGenerations() const;
+
+  RAMDataStore mStore;
+  Journal mJournal;
+  std::string mDirectory;
+  // journal file which is currently appended to
+  uint64_t mJournalGeneration = 1;
+  // guards applying modifications together with appending them
+  std::mutex mWriteMutex;
+  std::mutex mCompactMutex;
+
+  // only accessed using std::atomic_load/store, empty once the snapshot has
+  // been loaded
+  std::shared_ptr<LoadingState const> mLoading;
+  std::thread mLoader;
+  std::mutex mLoaderMutex;
+  std::condition_variable mLoaded;
+
+  std::thread mCompactor;
+  std::mutex mCompactorMutex;
+  std::condition_variable mCompactorWakeup;
+  bool mCompactionRequested = false;
+  bool mStopCompactor = false;
+};
+
+#endif /* _PERSISTENTDATASTORE_H_ */
@@ -11,90 +11,348 @@
 
 #include <algorithm>
 #include <ctime>
+#include <memory>
+#include <string_view>
+#include <utility>
 
 #include "Types/GlobalTypes.h"
 #include "Types/Result.h"
 #include "Utils/LoggingHandler.h"
+#include "Utils/Metrics.h"
 
 using namespace std;
 
-void RAMDataStore::removeVotesForTrack(TTrackID const &id) {
-  unique_lock<recursive_mutex> MyUserLock(mUserMutex);
-  for (auto &&user : mUsers) {
-    auto it = find(user.votes.begin(), user.votes.end(), id);
-    if (it != user.votes.end()) {
-      user.votes.erase(it);
+// gauges exported by the DataStore, they are read without locking the
+// DataStore
+static Metrics::TMetricID const cAdminQueueLength =
+    Metrics::getInstance().registerGauge("jukebox_queue_length",
+                                         "queue=\"admin\"");
+static Metrics::TMetricID const cNormalQueueLength =
+    Metrics::getInstance().registerGauge("jukebox_queue_length",
+                                         "queue=\"normal\"");
+static Metrics::TMetricID const cUserCount =
+    Metrics::getInstance().registerGauge("jukebox_users");
+
+RAMDataStore::RAMDataStore() : mSessionsReapedAt(time(nullptr)) {
+}
+
+RAMDataStore::UserShard &RAMDataStore::getShard(TSessionID const &sID) {
+  return mUserShards[hash<TSessionID>{}(sID) % cUserShards];
+}
+
+void RAMDataStore::removeVotesForTracks(vector<TTrackID> const &IDs) {
+  for (auto &&shard : mUserShards) {
+    // Exclusive Access to this part of the User List
+    unique_lock<MeasuredSharedMutex> MyUserLock(shard.mutex);
+
+    for (auto &&id : IDs) {
+      // only visit the users which actually voted for this track
+      auto votersIt = shard.trackVoters.find(id);
+      if (votersIt == shard.trackVoters.end()) {
+        continue;
+      }
+
+      for (auto &&sid : votersIt->second) {
+        auto userIt = shard.users.find(sid);
+        if (userIt == shard.users.end()) {
+          continue;
+        }
+        userIt->second.votes.erase(id);
+      }
+      shard.trackVoters.erase(votersIt);
     }
   }
 }
 
-TResultOpt RAMDataStore::addUser(User const &user) {
-  // Exclusive Access to User List
-  unique_lock<recursive_mutex> MyLock(mUserMutex);
-
-  // check for existing user
-  auto it = find(mUsers.begin(), mUsers.end(), user);
-  if (it == mUsers.end()) {
-    // User is unique, insert it into vector
-    mUsers.emplace_back(user);
+void RAMDataStore::removeVoter(UserShard &shard,
+                               TTrackID const &tID,
+                               TSessionID const &sID) {
+  auto votersIt = shard.trackVoters.find(tID);
+  if (votersIt == shard.trackVoters.end()) {
+    return;
+  }
+  votersIt->second.erase(sID);
+  if (votersIt->second.empty()) {
+    shard.trackVoters.erase(votersIt);
+  }
+}
+
+void RAMDataStore::reapExpiredSessions() {
+  if (mReapingSuspended) {
+    return;
+  }
+
+  // the session timers have a resolution of one second, so most calls
+  // don't need to lock anything
+  time_t now = time(nullptr);
+  time_t reapedAt = mSessionsReapedAt;
+  if (now <= reapedAt ||
+      !mSessionsReapedAt.compare_exchange_strong(reapedAt, now)) {
+    // already done (or in progress) in another thread
+    return;
+  }
+  reapSessionsUntil(now);
+}
+
+void RAMDataStore::reapSessionsUntil(time_t now) {
+  for (auto &&shard : mUserShards) {
+    // Exclusive Access to this part of the User List
+    unique_lock<MeasuredSharedMutex> MyUserLock(shard.mutex);
+
+    vector<TTrackID> revokedVotes;
+    for (auto &&sID : shard.sessionTimers.advance(now)) {
+      auto userIt = shard.users.find(sID);
+      if (userIt == shard.users.end()) {
+        continue;
+      }
+      for (auto &&tID : userIt->second.votes) {
+        removeVoter(shard, tID, sID);
+        revokedVotes.push_back(tID);
+      }
+      VLOG(1) << "Removed expired session of user '" << userIt->second.Name
+              << "'.";
+      shard.users.erase(userIt);
+      usersModified(-1);
+    }
+
+    if (revokedVotes.empty()) {
+      continue;
+    }
+
+    // Exclusive Access to Song Queue, the votes of removed users are revoked
+    unique_lock<MeasuredSharedMutex> MyQueueLock(mQueueMutex);
+    bool queuesChanged = false;
+    for (auto &&tID : revokedVotes) {
+      queuesChanged |= mNormalQueue.changeVotes(tID, -1);
+    }
+    if (queuesChanged) {
+      queuesModified();
+    }
+  }
+}
+
+void RAMDataStore::queuesModified() {
+  // must be called with exclusive access to the Song Queues
+  mVersion++;
+  atomic_store(&mSnapshot, TQueueSnapshot());
+  mAdminQueueSize = mAdminQueue.size() - mAdminRemoved;
+  mNormalQueueSize = mNormalQueue.size();
+
+  auto &metrics = Metrics::getInstance();
+  metrics.set(cAdminQueueLength, mAdminQueueSize);
+  metrics.set(cNormalQueueLength, mNormalQueueSize);
+
+  auto notifier = mChangeNotifier.load();
+  if (notifier != nullptr) {
+    notifier->notify();
+  }
+}
+
+void RAMDataStore::usersModified(int64_t delta) {
+  Metrics::getInstance().set(cUserCount, mUserCount += delta);
+}
+
+void RAMDataStore::changeVotes(TTrackID const &tID, int delta) {
+  // Exclusive Access to Song Queue
+  unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+  if (mNormalQueue.changeVotes(tID, delta)) {
+    queuesModified();
+  }
+}
+
+void RAMDataStore::changeVotes(unordered_map<TTrackID, int> const &deltas) {
+  // Exclusive Access to Song Queue
+  unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+  bool queuesChanged = false;
+  for (auto &&[tID, delta] : deltas) {
+    if (delta != 0) {
+      queuesChanged |= mNormalQueue.changeVotes(tID, delta);
+    }
+  }
+  if (queuesChanged) {
+    queuesModified();
+  }
+}
+
+RAMDataStore::TrackLocation const *RAMDataStore::findTrack(
+    TTrackID const &ID) const {
+  // must be called with access to the Song Queues
+  auto it = mTrackIndex.find(ID);
+  if (it == mTrackIndex.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void RAMDataStore::pushTrack(TrackEntry &&entry, QueueType q) {
+  // must be called with exclusive access to the Song Queues
+  string_view ID = entry.trackId();
+  if (q == QueueType::Admin) {
+    uint64_t slot = mAdminFirstSlot + mAdminQueue.size();
+    mTrackIndex.emplace(ID, TrackLocation{q, slot});
+    mAdminQueue.push_back(move(entry));
   } else {
+    mTrackIndex.emplace(ID, TrackLocation{q, 0});
+    mNormalQueue.push(entry);
+  }
+}
+
+TrackEntry RAMDataStore::takeTrack(TTrackID const &ID) {
+  // must be called with exclusive access to the Song Queues for a track which
+  // is queued
+  auto it = mTrackIndex.find(ID);
+  TrackLocation location = it->second;
+  mTrackIndex.erase(it);
+
+  if (location.queue == QueueType::Normal) {
+    return mNormalQueue.remove(ID).value();
+  }
+
+  // leaves an empty entry behind, so the other slots stay valid
+  TrackEntry entry = move(mAdminQueue[location.slot - mAdminFirstSlot]);
+  mAdminQueue[location.slot - mAdminFirstSlot].track = nullptr;
+  mAdminRemoved++;
+  compactAdminQueue();
+  return entry;
+}
+
+void RAMDataStore::compactAdminQueue() {
+  // removed entries at the front are dropped right away
+  while (!mAdminQueue.empty() && !mAdminQueue.front().track) {
+    mAdminQueue.pop_front();
+    mAdminFirstSlot++;
+    mAdminRemoved--;
+  }
+
+  // the others as soon as they make up half of the queue, which renumbers
+  // the remaining slots
+  if (mAdminRemoved == 0 || mAdminRemoved * 2 < mAdminQueue.size()) {
+    return;
+  }
+  auto end = remove_if(mAdminQueue.begin(), mAdminQueue.end(),
+                       [](TrackEntry const &entry) { return !entry.track; });
+  mAdminQueue.erase(end, mAdminQueue.end());
+  mAdminRemoved = 0;
+  for (size_t i = 0; i < mAdminQueue.size(); i++) {
+    mTrackIndex.at(mAdminQueue[i].trackId()).slot = mAdminFirstSlot + i;
+  }
+}
+
+TResultOpt RAMDataStore::addUser(User const &user) {
+  reapExpiredSessions();
+
+  // Exclusive Access to this part of the User List
+  auto &shard = getShard(user.SessionID);
+  unique_lock<MeasuredSharedMutex> MyLock(shard.mutex);
+
+  // insert user, fails if the session ID is already taken
+  auto inserted = shard.users.emplace(user.SessionID, user).second;
+  if (!inserted) {
     return Error(ErrorCode::AlreadyExists, "User already exists");
   }
+  usersModified(1);
+  shard.sessionTimers.schedule(
+      user.SessionID, user.ExpirationDate + cSessionRemovedAfterSeconds);
+  for (auto &&tID : user.votes) {
+    shard.trackVoters[tID].insert(user.SessionID);
+  }
   return nullopt;
 }
 
 TResult<User> RAMDataStore::getUser(TSessionID const &ID) {
-  // Exclusive Access to User List
-  unique_lock<recursive_mutex> MyLock(mUserMutex);
+  // Shared Access to this part of the User List
+  auto &shard = getShard(ID);
+  shared_lock<MeasuredSharedMutex> MyLock(shard.mutex);
 
   // find user
-  User user;
-  user.SessionID = ID;
-  auto it = find(mUsers.begin(), mUsers.end(), user);
-  if (it == mUsers.end()) {
+  auto it = shard.users.find(ID);
+  if (it == shard.users.end()) {
     return Error(ErrorCode::DoesntExist, "User doesn't exist");
   } else {
     // copy user for return type
-    user = *it;
-    return user;
+    return it->second;
   }
 }
 
 // doesn't remove votes taken by this user
 TResult<User> RAMDataStore::removeUser(TSessionID const &ID) {
-  // Exclusive Access to User List
-  unique_lock<recursive_mutex> MyLock(mUserMutex);
+  // Exclusive Access to this part of the User List
+  auto &shard = getShard(ID);
+  unique_lock<MeasuredSharedMutex> MyLock(shard.mutex);
 
   // find user
-  User user;
-  user.SessionID = ID;
-  auto it = find(mUsers.begin(), mUsers.end(), user);
-  if (it == mUsers.end()) {
+  auto it = shard.users.find(ID);
+  if (it == shard.users.end()) {
     return Error(ErrorCode::DoesntExist, "User doesn't exist");
   } else {
-    // copy user for return type
-    user = *it;
+    // move user out for return type
+    User user = move(it->second);
     // delete User
-    mUsers.erase(it);
+    shard.users.erase(it);
+    shard.sessionTimers.cancel(ID);
+    usersModified(-1);
+
+    // the votes stay on the tracks, but the user is no voter anymore
+    for (auto &&tID : user.votes) {
+      removeVoter(shard, tID, ID);
+    }
     return user;
   }
 }
 
 // check expired sessions
 TResult<bool> RAMDataStore::isSessionExpired(TSessionID const &ID) {
-  // Exclusive Access to User List
-  unique_lock<recursive_mutex> MyLock(mUserMutex);
+  auto ret = extendSession(ID);
+  if (holds_alternative<Error>(ret)) {
+    return get<Error>(ret);
+  }
+  return false;
+}
 
-  auto retUser = getUser(ID);
-  if (holds_alternative<Error>(retUser))
-    return get<Error>(retUser);
+TResult<optional<time_t>> RAMDataStore::extendSession(TSessionID const &ID) {
+  reapExpiredSessions();
 
+  auto &shard = getShard(ID);
   time_t now = time(nullptr);
-  if (now < get<User>(retUser).ExpirationDate) {
+  time_t newExpirationDate = now + cSessionTimeoutAfterSeconds;
+
+  {
+    // Shared Access to this part of the User List
+    shared_lock<MeasuredSharedMutex> MyLock(shard.mutex);
+
+    auto it = shard.users.find(ID);
+    if (it == shard.users.end()) {
+      return Error(ErrorCode::DoesntExist, "User doesn't exist");
+    }
+    if (now < it->second.ExpirationDate &&
+        it->second.ExpirationDate + cSessionRenewalIntervalSeconds >=
+            newExpirationDate) {
+      // Session is not timed out and has been extended recently
+      return nullopt;
+    }
+  }
+
+  // Exclusive Access to this part of the User List
+  unique_lock<MeasuredSharedMutex> MyLock(shard.mutex);
+
+  auto it = shard.users.find(ID);
+  if (it == shard.users.end()) {
+    return Error(ErrorCode::DoesntExist, "User doesn't exist");
+  }
+
+  User &user = it->second;
+  if (now < user.ExpirationDate) {
     /* Session is not timed out. Advance expiration time, since user was active
      * right now. */
-    get<User>(retUser).ExpirationDate = now + cSessionTimeoutAfterSeconds;
-    return false;
+    if (user.ExpirationDate >= newExpirationDate) {
+      return nullopt;
+    }
+    user.ExpirationDate = newExpirationDate;
+    shard.sessionTimers.schedule(
+        ID, user.ExpirationDate + cSessionRemovedAfterSeconds);
+    return user.ExpirationDate;
   }
 
   string msg = "Session expired for user ID '" + ID + "'.";
@@ -102,238 +360,535 @@ TResult<bool> RAMDataStore::isSessionExpired(TSessionID const &ID) {
   return Error(ErrorCode::SessionExpired, msg);
 }
 
+TResultOpt RAMDataStore::setSessionExpiration(TSessionID const &ID,
+                                              time_t expirationDate) {
+  // Exclusive Access to this part of the User List
+  auto &shard = getShard(ID);
+  unique_lock<MeasuredSharedMutex> MyLock(shard.mutex);
+
+  auto it = shard.users.find(ID);
+  if (it == shard.users.end()) {
+    return Error(ErrorCode::DoesntExist, "User doesn't exist");
+  }
+  it->second.ExpirationDate = expirationDate;
+  shard.sessionTimers.schedule(ID,
+                               expirationDate + cSessionRemovedAfterSeconds);
+  return nullopt;
+}
+
+void RAMDataStore::getState(TQueueSnapshot &queues, vector<User> &users) {
+  // Shared Access to the whole User List and the Song Queue, the shards are
+  // locked first
+  vector<shared_lock<MeasuredSharedMutex>> shardLocks;
+  for (auto &&shard : mUserShards) {
+    shardLocks.emplace_back(shard.mutex);
+  }
+  shared_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+  queues = publishQueueSnapshot();
+  users.clear();
+  users.reserve(mUserCount);
+  for (auto &&shard : mUserShards) {
+    for (auto &&entry : shard.users) {
+      users.push_back(entry.second);
+    }
+  }
+}
+
+void RAMDataStore::loadSnapshot(SnapshotFile const &snapshot) {
+  // Exclusive Access to the whole User List and the Song Queue, the shards
+  // are locked first
+  vector<unique_lock<MeasuredSharedMutex>> shardLocks;
+  for (auto &&shard : mUserShards) {
+    shardLocks.emplace_back(shard.mutex);
+  }
+  unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+  auto toEntry = [this](QueuedTrack &&track) {
+    TrackEntry entry;
+    entry.votes = track.votes;
+    entry.insertedAt = track.insertedAt;
+    entry.track = mCatalog.intern(move(track));
+    return entry;
+  };
+
+  size_t nrAdmin = snapshot.getTrackCount(QueueType::Admin);
+  size_t nrNormal = snapshot.getTrackCount(QueueType::Normal);
+  mCatalog.reserve(nrAdmin + nrNormal + 1);
+
+  mCurrentTrack = nullopt;
+  auto current = snapshot.getCurrentTrack();
+  if (current.has_value()) {
+    mCurrentTrack = toEntry(move(current.value()));
+  }
+
+  mTrackIndex.clear();
+  mTrackIndex.reserve(nrAdmin + nrNormal);
+  mAdminQueue.clear();
+  mAdminFirstSlot = 0;
+  mAdminRemoved = 0;
+  for (size_t i = 0; i < nrAdmin; i++) {
+    pushTrack(toEntry(snapshot.getTrack(QueueType::Admin, i)),
+              QueueType::Admin);
+  }
+  mNormalQueue = TrackQueue();
+  mNormalQueue.reserve(nrNormal);
+  for (size_t i = 0; i < nrNormal; i++) {
+    pushTrack(toEntry(snapshot.getTrack(QueueType::Normal, i)),
+              QueueType::Normal);
+  }
+  queuesModified();
+
+  // sessions which are expired already are due with the next reaping
+  time_t now = time(nullptr);
+  size_t nrUsersPerShard = snapshot.getUserCount() / cUserShards + 1;
+  for (auto &&shard : mUserShards) {
+    shard.users.clear();
+    shard.users.reserve(nrUsersPerShard);
+    shard.trackVoters.clear();
+    shard.sessionTimers = TimerWheel(now - 1);
+    shard.sessionTimers.reserve(nrUsersPerShard);
+  }
+  for (size_t i = 0; i < snapshot.getUserCount(); i++) {
+    User user = snapshot.getUser(i);
+    auto &shard = getShard(user.SessionID);
+    shard.sessionTimers.schedule(
+        user.SessionID, user.ExpirationDate + cSessionRemovedAfterSeconds);
+    for (auto &&tID : user.votes) {
+      shard.trackVoters[tID].insert(user.SessionID);
+    }
+    shard.users.emplace(user.SessionID, move(user));
+  }
+  usersModified(static_cast<int64_t>(snapshot.getUserCount()) - mUserCount);
+}
+
+void RAMDataStore::suspendSessionReaping() {
+  mReapingSuspended = true;
+}
+
+void RAMDataStore::resumeSessionReaping() {
+  time_t now = time(nullptr);
+  mSessionsReapedAt = now;
+  mReapingSuspended = false;
+  reapSessionsUntil(now);
+}
+
 TResultOpt RAMDataStore::addTrack(BaseTrack const &track, QueueType q) {
+  return addTrack(track, q, time(nullptr), 0);
+}
+
+TResultOpt RAMDataStore::addTrack(BaseTrack const &track,
+                                  QueueType q,
+                                  uint64_t insertedAt,
+                                  int votes) {
   // Exclusive Access to Song Queue
-  unique_lock<shared_mutex> MyLock(mQueueMutex);
+  unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
 
-  // Get pointers for this Queue and for other Queue
-  Queue *pThisQueue = SelectQueue(q);
-  if (pThisQueue == nullptr) {
+  if (q != QueueType::Admin && q != QueueType::Normal) {
     return Error(ErrorCode::InvalidValue, "Invalid Parameter in Queue");
   }
-  Queue *pOtherQueue = q == QueueType::Admin ? &mNormalQueue : &mAdminQueue;
 
-  // check for existing Track in not selected Queue
-  QueuedTrack qtr;
-  qtr.trackId = track.trackId;
-  auto it = find(pOtherQueue->tracks.begin(), pOtherQueue->tracks.end(), qtr);
-  if (it != pOtherQueue->tracks.end()) {
+  // check for existing Track in both Queues
+  auto location = findTrack(track.trackId);
+  if (location && location->queue != q) {
     // This Track already exists in the other Queue, dont add it here
     return Error(ErrorCode::AlreadyExists,
                  "Track already exists in other Queue");
   }
-
-  // check for existing Track in selected Queue
-  qtr.trackId = track.trackId;
-  it = find(pThisQueue->tracks.begin(), pThisQueue->tracks.end(), qtr);
-  if (it == pThisQueue->tracks.end()) {
-    // Track is unique, insert it into vector
-    qtr.title = track.title;
-    qtr.album = track.album;
-    qtr.artist = track.artist;
-    qtr.durationMs = track.durationMs;
-    qtr.iconUri = track.iconUri;
-    qtr.addedBy = track.addedBy;
-    qtr.votes = 0;
-    qtr.insertedAt = time(nullptr);
-    pThisQueue->tracks.push_back(qtr);
-    return nullopt;
-  } else {
+  if (location) {
     return Error(ErrorCode::AlreadyExists, "Track already exists");
   }
+
+  // Track is unique, insert it into the selected Queue
+  TrackEntry entry;
+  entry.track = mCatalog.intern(track);
+  entry.votes = votes;
+  entry.insertedAt = insertedAt;
+  pushTrack(move(entry), q);
+  queuesModified();
+  return nullopt;
+}
+
+TResult<vector<TResultOpt>> RAMDataStore::addTracks(
+    vector<BaseTrack> const &tracks, QueueType q) {
+  return addTracks(tracks, q, time(nullptr));
+}
+
+TResult<vector<TResultOpt>> RAMDataStore::addTracks(
+    vector<BaseTrack> const &tracks, QueueType q, uint64_t insertedAt) {
+  // Exclusive Access to Song Queue
+  unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+  if (q != QueueType::Admin && q != QueueType::Normal) {
+    return Error(ErrorCode::InvalidValue, "Invalid Parameter in Queue");
+  }
+
+  vector<TResultOpt> results;
+  results.reserve(tracks.size());
+  bool queuesChanged = false;
+  for (auto &&track : tracks) {
+    // check for existing Track in both Queues (including the ones added by
+    // this batch)
+    auto location = findTrack(track.trackId);
+    if (location && location->queue != q) {
+      results.push_back(Error(ErrorCode::AlreadyExists,
+                              "Track already exists in other Queue"));
+      continue;
+    }
+    if (location) {
+      results.push_back(
+          Error(ErrorCode::AlreadyExists, "Track already exists"));
+      continue;
+    }
+
+    TrackEntry entry;
+    entry.track = mCatalog.intern(track);
+    entry.votes = 0;
+    entry.insertedAt = insertedAt;
+    pushTrack(move(entry), q);
+    results.push_back(nullopt);
+    queuesChanged = true;
+  }
+
+  if (queuesChanged) {
+    queuesModified();
+  }
+  return results;
+}
+
+TResult<vector<TResultOpt>> RAMDataStore::removeTracks(
+    vector<TTrackID> const &IDs, QueueType q) {
+  vector<TResultOpt> results;
+  vector<TTrackID> removed;
+
+  // remove tracks from queue
+  {
+    // Exclusive Access to Song Queue
+    unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+    if (q != QueueType::Admin && q != QueueType::Normal) {
+      return Error(ErrorCode::InvalidValue, "Invalid Parameter in Queue");
+    }
+
+    results.reserve(IDs.size());
+    for (auto &&ID : IDs) {
+      auto location = findTrack(ID);
+      if (location && location->queue == q) {
+        takeTrack(ID);
+        removed.push_back(ID);
+        results.push_back(nullopt);
+      } else {
+        results.push_back(Error(ErrorCode::DoesntExist,
+                                "Track doesn't exist in this Queue"));
+      }
+    }
+
+    if (!removed.empty()) {
+      queuesModified();
+    }
+  }
+
+  if (!removed.empty()) {
+    removeVotesForTracks(removed);
+  }
+  return results;
 }
 
 TResult<BaseTrack> RAMDataStore::removeTrack(TTrackID const &ID, QueueType q) {
-  QueuedTrack track;
+  TrackEntry track;
 
   // remove track from queue
   {
     // Exclusive Access to Song Queue
-    unique_lock<shared_mutex> MyLock(mQueueMutex);
+    unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
 
-    Queue *pQueue = SelectQueue(q);
-    if (pQueue == nullptr) {
+    if (q != QueueType::Admin && q != QueueType::Normal) {
       return Error(ErrorCode::InvalidValue, "Invalid Parameter in SelectQueue");
     }
 
-    // Deep copy track, then remove it
-    track.trackId = ID;
-    auto it = find(pQueue->tracks.begin(), pQueue->tracks.end(), track);
-    if (it == pQueue->tracks.end()) {
+    auto location = findTrack(ID);
+    if (!location || location->queue != q) {
       return Error(ErrorCode::DoesntExist, "Track doesn't exist in this Queue");
-    } else {
-      track = *it;
-      // Found track, remove it from vector
-      pQueue->tracks.erase(it);
     }
+    track = takeTrack(ID);
+    queuesModified();
   }
 
-  removeVotesForTrack(track.trackId);
+  removeVotesForTracks({ID});
 
-  return track;
+  return *track.track;
+}
+
+TResultOpt RAMDataStore::moveTrack(TTrackID const &ID,
+                                   QueueType from,
+                                   QueueType to,
+                                   bool keepVotes) {
+  if ((from != QueueType::Admin && from != QueueType::Normal) ||
+      (to != QueueType::Admin && to != QueueType::Normal)) {
+    return Error(ErrorCode::InvalidValue, "Invalid Parameter in Queue");
+  }
+  if (from == to) {
+    return Error(ErrorCode::InvalidValue, "Source and target Queue are equal");
+  }
+
+  // Only tracks in the Normal Queue count their votes, so they are recounted
+  // when a track is moved there. Shared Access to the whole User List, the
+  // shards are locked first.
+  vector<shared_lock<MeasuredSharedMutex>> shardLocks;
+  if (keepVotes && to == QueueType::Normal) {
+    for (auto &&shard : mUserShards) {
+      shardLocks.emplace_back(shard.mutex);
+    }
+  }
+
+  {
+    // Exclusive Access to Song Queue
+    unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+    auto location = findTrack(ID);
+    if (!location || location->queue != from) {
+      return Error(ErrorCode::DoesntExist, "Track doesn't exist in this Queue");
+    }
+
+    // the entry is moved, the metadata is neither copied nor interned again
+    TrackEntry entry = takeTrack(ID);
+    entry.votes = 0;
+    if (!shardLocks.empty()) {
+      for (auto &&shard : mUserShards) {
+        auto votersIt = shard.trackVoters.find(ID);
+        if (votersIt != shard.trackVoters.end()) {
+          entry.votes += static_cast<int>(votersIt->second.size());
+        }
+      }
+    }
+    pushTrack(move(entry), to);
+    queuesModified();
+  }
+  shardLocks.clear();
+
+  if (!keepVotes) {
+    removeVotesForTracks({ID});
+  }
+  return nullopt;
 }
 
 TResult<bool> RAMDataStore::hasTrack(TTrackID const &ID, QueueType q) {
   // Shared Access to Song Queue
-  shared_lock<shared_mutex> MyLock(mQueueMutex);
+  shared_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
 
-  // select Queue
-  Queue *pQueue = SelectQueue(q);
-  if (pQueue == nullptr) {
+  if (q != QueueType::Admin && q != QueueType::Normal) {
     return Error(ErrorCode::InvalidValue, "Invalid Parameter in Queue");
   }
 
-  // find Track
-  QueuedTrack track;
-  track.trackId = ID;
-  auto it = find(pQueue->tracks.begin(), pQueue->tracks.end(), track);
-  if (it == pQueue->tracks.end()) {
-    return false;
-  } else {
-    return true;
+  // find Track in selected Queue
+  auto location = findTrack(ID);
+  return location != nullptr && location->queue == q;
+}
+
+TResult<optional<QueueType>> RAMDataStore::locateTrack(TTrackID const &ID) {
+  // Shared Access to Song Queue
+  shared_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+
+  auto location = findTrack(ID);
+  if (!location) {
+    return optional<QueueType>();
   }
+  return optional<QueueType>(location->queue);
 }
 
 TResultOpt RAMDataStore::voteTrack(TSessionID const &sID,
                                    TTrackID const &tID,
                                    TVote vote) {
-  // Exclusive Access to Song Queue and User
-  unique_lock<shared_mutex> MyLockQueue(mQueueMutex, defer_lock);
-  unique_lock<recursive_mutex> MyLockUser(mUserMutex, defer_lock);
-  lock(MyLockQueue, MyLockUser);
+  // Exclusive Access to this part of the User List. The Song Queue is only
+  // locked when the votes of the track actually change.
+  auto &shard = getShard(sID);
+  unique_lock<MeasuredSharedMutex> MyLockUser(shard.mutex);
 
   // find user
-  User user;
-  user.SessionID = sID;
-  auto it = find(mUsers.begin(), mUsers.end(), user);
-  if (it == mUsers.end()) {
+  auto userIt = shard.users.find(sID);
+  if (userIt == shard.users.end()) {
     // User not found
     return Error(ErrorCode::DoesntExist, "User doesn't exist");
   }
+  User &user = userIt->second;
 
-  // find track in Queues
-  QueuedTrack track;
-  track.trackId = tID;
-  QueuedTrack *pNormalTrack = 0;
-  auto it_normal =
-      find(mNormalQueue.tracks.begin(), mNormalQueue.tracks.end(), track);
-  if (it_normal != mNormalQueue.tracks.end()) {
-    pNormalTrack = &(*it_normal);
-  }
-
-  // User found, look for Track in vote vector
-  auto it_track = find(it->votes.begin(), it->votes.end(), tID);
-  if (it_track != it->votes.end()) {
-    // Track already found in vote vector
+  // User found, look for Track in vote set
+  auto it_track = user.votes.find(tID);
+  if (it_track != user.votes.end()) {
+    // Track already found in vote set
     if (vote) {
-      // track already in vote vector and we want to upvote it: this is a
+      // track already in vote set and we want to upvote it: this is a
       // duplicate, do nothing
     } else {
-      // Track already in vote vector and we want to remove the upvote:
-      // we want to remove it from upvoted tracks, so remove it from vector of
+      // Track already in vote set and we want to remove the upvote:
+      // we want to remove it from upvoted tracks, so remove it from set of
       // upvoted tracks and update vote counter in track
-      it->votes.erase(it_track);
-      // decrement its upvote counter
-      if (pNormalTrack != nullptr) {
-        pNormalTrack->votes--;
-      }
+      user.votes.erase(it_track);
+      removeVoter(shard, tID, sID);
+      // decrement its upvote counter (only tracks in the Normal Queue are
+      // ordered by votes), this moves the track to its new position
+      changeVotes(tID, -1);
     }
   } else {
-    // Track not in vote vector
+    // Track not in vote set
     if (vote) {
-      // Track not in vote vector and we want to upvote it: add to vector and
+      // Track not in vote set and we want to upvote it: add to set and
       // update counter
-      it->votes.emplace_back(tID);
-      // increment its upvote counter
-      if (pNormalTrack != nullptr) {
-        pNormalTrack->votes++;
-      }
+      user.votes.insert(tID);
+      shard.trackVoters[tID].insert(sID);
+      // increment its upvote counter, this moves the track to its new position
+      changeVotes(tID, 1);
     } else {
-      // track not in vote vector and we want to remove upvote: cant remove
+      // track not in vote set and we want to remove upvote: cant remove
       // nonexistent upvote, so do nothing
     }
   }
 
-  // sort Normal Queue
-  sort(mNormalQueue.tracks.begin(), mNormalQueue.tracks.end());
+  return nullopt;
+}
+
+TResultOpt RAMDataStore::voteTracks(
+    TSessionID const &sID, vector<pair<TTrackID, TVote>> const &votes) {
+  // Exclusive Access to this part of the User List
+  auto &shard = getShard(sID);
+  unique_lock<MeasuredSharedMutex> MyLockUser(shard.mutex);
+
+  auto userIt = shard.users.find(sID);
+  if (userIt == shard.users.end()) {
+    return Error(ErrorCode::DoesntExist, "User doesn't exist");
+  }
+  User &user = userIt->second;
+
+  // same rules as voteTrack, but the vote counters are changed at once
+  unordered_map<TTrackID, int> deltas;
+  for (auto &&[tID, vote] : votes) {
+    if (vote) {
+      if (user.votes.insert(tID).second) {
+        shard.trackVoters[tID].insert(sID);
+        deltas[tID]++;
+      }
+    } else if (user.votes.erase(tID) > 0) {
+      removeVoter(shard, tID, sID);
+      deltas[tID]--;
+    }
+  }
+
+  if (!deltas.empty()) {
+    changeVotes(deltas);
+  }
   return nullopt;
 }
 
 TResult<Queue> RAMDataStore::getQueue(QueueType q) {
+  if (q != QueueType::Admin && q != QueueType::Normal) {
+    return Error(ErrorCode::InvalidValue, "Invalid Parameter in Queue");
+  }
+
+  // return a copy of the selected Queue
+  auto snapshot = get<TQueueSnapshot>(getQueueSnapshot());
+  if (q == QueueType::Admin) {
+    return snapshot->adminQueue;
+  } else {
+    return snapshot->normalQueue;
+  }
+}
+
+TResult<TQueueSnapshot> RAMDataStore::getQueueSnapshot() {
+  // No locking needed as long as the snapshot is up to date
+  auto snapshot = atomic_load(&mSnapshot);
+  if (snapshot) {
+    return snapshot;
+  }
+
   // Shared Access to Song Queue
-  shared_lock<shared_mutex> MyLock(mQueueMutex);
+  shared_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
+  return publishQueueSnapshot();
+}
+
+TQueueSnapshot RAMDataStore::publishQueueSnapshot() {
+  // must be called with access to the Song Queues
+
+  // The first reader after a modification publishes the new snapshot.
+  // Concurrent readers may build it twice, but with identical content.
+  auto snapshot = atomic_load(&mSnapshot);
+  if (!snapshot) {
+    auto newSnapshot = make_shared<QueueSnapshot>();
+    newSnapshot->version = mVersion;
+    newSnapshot->adminQueue.tracks.reserve(mAdminQueue.size() -
+                                           mAdminRemoved);
+    for (auto &&entry : mAdminQueue) {
+      if (entry.track) {
+        newSnapshot->adminQueue.tracks.push_back(entry.toQueuedTrack());
+      }
+    }
+    newSnapshot->normalQueue = mNormalQueue.toQueue();
+    if (mCurrentTrack.has_value()) {
+      newSnapshot->currentTrack = mCurrentTrack->toQueuedTrack();
+    }
+    snapshot = newSnapshot;
+    atomic_store(&mSnapshot, snapshot);
+  }
+  return snapshot;
+}
 
-  // select Queue
-  Queue *pQueue = SelectQueue(q);
-  if (pQueue == nullptr) {
+TResult<size_t> RAMDataStore::getQueueSize(QueueType q) {
+  if (q == QueueType::Admin) {
+    return mAdminQueueSize.load();
+  } else if (q == QueueType::Normal) {
+    return mNormalQueueSize.load();
+  } else {
     return Error(ErrorCode::InvalidValue, "Invalid Parameter in Queue");
   }
+}
 
-  // return read only access to Queue
-  return (const Queue)(*pQueue);
+bool RAMDataStore::isEmpty() {
+  return mAdminQueueSize == 0 && mNormalQueueSize == 0;
 }
 
 TResult<optional<QueuedTrack>> RAMDataStore::getPlayingTrack() {
-  // Shared Access to Song Queue
-  shared_lock<shared_mutex> MyLock(mQueueMutex);
-
-  return mCurrentTrack;
+  return get<TQueueSnapshot>(getQueueSnapshot())->currentTrack;
 }
 
 bool RAMDataStore::hasUser(TSessionID const &ID) {
-  // Shared Access to User List
-  unique_lock<recursive_mutex> MyLock(mUserMutex);
+  // Shared Access to this part of the User List
+  auto &shard = getShard(ID);
+  shared_lock<MeasuredSharedMutex> MyLock(shard.mutex);
 
   // find user
-  User user;
-  user.SessionID = ID;
-  auto it = find(mUsers.begin(), mUsers.end(), user);
-  if (it == mUsers.end()) {
-    return false;
-  } else {
-    return true;
-  }
+  return shard.users.find(ID) != shard.users.end();
 }
 
 TResultOpt RAMDataStore::nextTrack() {
-  QueuedTrack track;
+  TrackEntry track;
 
   {
     // Exclusive Access to Song Queue
-    unique_lock<shared_mutex> MyLock(mQueueMutex);
+    unique_lock<MeasuredSharedMutex> MyLock(mQueueMutex);
 
     // If there are songs in the Admin Queue, play the first of those
-    if (mAdminQueue.tracks.size()) {
-      track = mAdminQueue.tracks[0];
-      mAdminQueue.tracks.erase(mAdminQueue.tracks.begin());
-    } else if (mNormalQueue.tracks.size() != 0) {
+    // (removed entries never stay at the front of the Admin Queue)
+    if (mAdminQueue.size()) {
+      track = takeTrack(mAdminQueue.front().trackId());
+    } else if (!mNormalQueue.empty()) {
       // no songs in the admin queue, use the first one from the user queue
-      track = mNormalQueue.tracks[0];
-      mNormalQueue.tracks.erase(mNormalQueue.tracks.begin());
+      track = mNormalQueue.popFront().value();
+      mTrackIndex.erase(track.trackId());
     } else {
       // no next track available
       return Error(ErrorCode::DoesntExist,
                    "No more Tracks available in either Queue");
     }
 
-    // sort Normal Queue
-    sort(mNormalQueue.tracks.begin(), mNormalQueue.tracks.end());
-
     // Set Current Track
     mCurrentTrack = track;
+    queuesModified();
   }
 
-  removeVotesForTrack(track.trackId);
+  removeVotesForTracks({track.trackId()});
 
   return nullopt;
 }
 
-Queue *RAMDataStore::SelectQueue(QueueType q) {
-  if (q == QueueType::Admin) {
-    return &mAdminQueue;
-  } else if (q == QueueType::Normal) {
-    return &mNormalQueue;
-  } else {
-    return nullptr;
-  }
+void RAMDataStore::setChangeNotifier(ChangeNotifier *notifier) {
+  mChangeNotifier = notifier;
 }
@@ -9,18 +9,30 @@
 #ifndef _RAMDATASTORE_H_
 #define _RAMDATASTORE_H_
 
+#include <array>
+#include <atomic>
+#include <ctime>
+#include <deque>
 #include <mutex>
 #include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
 #include "DataStore.h"
+#include "Datastore/SnapshotFile.h"
+#include "Datastore/TimerWheel.h"
+#include "Datastore/TrackCatalog.h"
+#include "Datastore/TrackQueue.h"
 #include "Types/GlobalTypes.h"
 #include "Types/Queue.h"
 #include "Types/Result.h"
 #include "Types/Tracks.h"
 #include "Types/User.h"
+#include "Utils/MeasuredSharedMutex.h"
 
 /**
  * @brief Implements a DataStore which stores its data purly in RAM (no
@@ -28,31 +40,177 @@
  */
 class RAMDataStore : public DataStore {
  public:
+  RAMDataStore();
+
   TResultOpt addUser(User const &user) override;
   TResult<User> getUser(TSessionID const &ID) override;
   TResult<User> removeUser(TSessionID const &ID) override;
   TResult<bool> isSessionExpired(TSessionID const &ID) override;
   TResultOpt addTrack(BaseTrack const &track, QueueType q) override;
   TResult<BaseTrack> removeTrack(TTrackID const &ID, QueueType q) override;
+  TResult<std::vector<TResultOpt>> addTracks(
+      std::vector<BaseTrack> const &tracks, QueueType q) override;
+  TResult<std::vector<TResultOpt>> removeTracks(
+      std::vector<TTrackID> const &IDs, QueueType q) override;
   TResult<bool> hasTrack(TTrackID const &ID, QueueType q) override;
+  TResult<std::optional<QueueType>> locateTrack(TTrackID const &ID) override;
+  TResultOpt moveTrack(TTrackID const &ID,
+                       QueueType from,
+                       QueueType to,
+                       bool keepVotes) override;
   TResultOpt voteTrack(TSessionID const &sID,
                        TTrackID const &tID,
                        TVote vote) override;
+  TResultOpt voteTracks(
+      TSessionID const &sID,
+      std::vector<std::pair<TTrackID, TVote>> const &votes) override;
   TResult<Queue> getQueue(QueueType q) override;
+  TResult<TQueueSnapshot> getQueueSnapshot() override;
+  TResult<size_t> getQueueSize(QueueType q) override;
+  bool isEmpty() override;
   TResult<std::optional<QueuedTrack>> getPlayingTrack() override;
   bool hasUser(TSessionID const &ID) override;
   TResultOpt nextTrack() override;
+  void setChangeNotifier(ChangeNotifier *notifier) override;
+
+  /**
+   * @brief Same as isSessionExpired, but reports whether the session has been
+   * extended.
+   * @return The new expiration date, if the session has been extended,
+   * `nullopt` if it has not been changed or an Error message.
+   */
+  TResult<std::optional<std::time_t>> extendSession(TSessionID const &ID);
+
+  /*
+   * The following functions restore a previously saved state (see
+   * PersistentDataStore).
+   */
+
+  /**
+   * @brief Adds a track with the given votes and insertion time.
+   */
+  TResultOpt addTrack(BaseTrack const &track,
+                      QueueType q,
+                      uint64_t insertedAt,
+                      int votes);
+
+  /**
+   * @brief Adds tracks with the given insertion time.
+   */
+  TResult<std::vector<TResultOpt>> addTracks(
+      std::vector<BaseTrack> const &tracks,
+      QueueType q,
+      uint64_t insertedAt);
+
+  /**
+   * @brief Sets the expiration date of a session.
+   */
+  TResultOpt setSessionExpiration(TSessionID const &ID,
+                                  std::time_t expirationDate);
+
+  /**
+   * @brief Copies the queues and all users including their votes.
+   * @details Both are taken at the same time, so the votes of the users
+   * match the votes of the tracks.
+   */
+  void getState(TQueueSnapshot &queues, std::vector<User> &users);
+
+  /**
+   * @brief Replaces the whole state with the content of a snapshot.
+   */
+  void loadSnapshot(SnapshotFile const &snapshot);
+
+  /**
+   * @brief Stops removing expired sessions, so restoring a state does not
+   * depend on the current time.
+   */
+  void suspendSessionReaping();
+
+  /**
+   * @brief Removes all sessions which have expired in the meantime and
+   * resumes removing expired sessions.
+   */
+  void resumeSessionReaping();
 
  private:
-  void removeVotesForTrack(TTrackID const &);
-  Queue *SelectQueue(QueueType q);
-
-  Queue mAdminQueue;
-  Queue mNormalQueue;
-  std::optional<QueuedTrack> mCurrentTrack = std::nullopt;
-  std::vector<User> mUsers;
-  std::recursive_mutex mUserMutex;
-  std::shared_mutex mQueueMutex;
+  static size_t const cUserShards = 16;
+  // active sessions are extended at most once per interval
+  static unsigned const cSessionRenewalIntervalSeconds = 60;
+
+  /**
+   * @brief Part of the User List, selected by the hash of the session ID.
+   * @details Each shard is locked on its own. When both a shard and the Song
+   * Queue are locked, the shard has to be locked first.
+   */
+  struct alignas(64) UserShard {
+    MeasuredSharedMutex mutex{"jukebox_datastore_lock_wait_seconds",
+                              "lock=\"users\""};
+    std::unordered_map<TSessionID, User> users;
+    // reverse index of User::votes (which users voted for a track)
+    std::unordered_map<TTrackID, std::unordered_set<TSessionID>> trackVoters;
+    // deadlines after which expired sessions are removed
+    TimerWheel sessionTimers{std::time(nullptr)};
+  };
+
+  /**
+   * @brief Position of a queued track.
+   * @details `mAdminQueue[slot - mAdminFirstSlot]` is the entry of a slot in
+   * the Admin Queue.
+   * Tracks of the Normal Queue are looked up by TrackQueue itself, their slot
+   * is unused.
+   */
+  struct TrackLocation {
+    QueueType queue;
+    uint64_t slot;
+  };
+
+  UserShard &getShard(TSessionID const &sID);
+  void removeVotesForTracks(std::vector<TTrackID> const &IDs);
+  void removeVoter(UserShard &shard,
+                   TTrackID const &tID,
+                   TSessionID const &sID);
+  void reapExpiredSessions();
+  void reapSessionsUntil(std::time_t now);
+  void changeVotes(TTrackID const &tID, int delta);
+  void changeVotes(std::unordered_map<TTrackID, int> const &deltas);
+  void queuesModified();
+  TQueueSnapshot publishQueueSnapshot();
+  void usersModified(int64_t delta);
+  TrackLocation const *findTrack(TTrackID const &ID) const;
+  void pushTrack(TrackEntry &&entry, QueueType q);
+  TrackEntry takeTrack(TTrackID const &ID);
+  void compactAdminQueue();
+
+  // metadata shared by the queues and the current track
+  TrackCatalog mCatalog;
+  // removed tracks are left as empty entries until they are compacted, a
+  // deque allows to remove the first track in constant time
+  std::deque<TrackEntry> mAdminQueue;
+  uint64_t mAdminFirstSlot = 0;
+  size_t mAdminRemoved = 0;
+  TrackQueue mNormalQueue;
+  // location of every queued track, keys refer to the track IDs inside the
+  // shared metadata
+  std::unordered_map<std::string_view, TrackLocation> mTrackIndex;
+  std::optional<TrackEntry> mCurrentTrack = std::nullopt;
+  // version of the queues, incremented on every modification, 0 is never
+  // used (see QueueSnapshot)
+  uint64_t mVersion = 1;
+  // snapshot of the current version, only accessed using std::atomic_load/store
+  TQueueSnapshot mSnapshot;
+  // queue sizes, readable without locking the queues
+  std::atomic<size_t> mAdminQueueSize{0};
+  std::atomic<size_t> mNormalQueueSize{0};
+  std::atomic<ChangeNotifier *> mChangeNotifier{nullptr};
+  MeasuredSharedMutex mQueueMutex{"jukebox_datastore_lock_wait_seconds",
+                                  "lock=\"queue\""};
+
+  std::array<UserShard, cUserShards> mUserShards;
+  // number of users in all shards
+  std::atomic<int64_t> mUserCount{0};
+  // last time the session timers were advanced to
+  std::atomic<std::time_t> mSessionsReapedAt;
+  std::atomic<bool> mReapingSuspended{false};
 };
 
 #endif /* _RAMDATASTORE_H_ */
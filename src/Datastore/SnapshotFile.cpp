@@ -0,0 +1,471 @@
+/*****************************************************************************/
+/**
+ * @file    SnapshotFile.cpp
+ * @author  Team Server
+ * @brief   Class SnapshotFile implementation
+ */
+/*****************************************************************************/
+
+#include "Datastore/SnapshotFile.h"
+
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+using namespace std;
+
+/*****************************************************************************
+ * File layout
+ *
+ * All sections start at offsets aligned to 8 bytes, so the records can be
+ * accessed in place. The tracks section contains the currently playing track
+ * (if any), followed by the admin and the normal queue in queue order.
+ *****************************************************************************/
+
+struct SnapshotFile::StringRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct SnapshotFile::TrackRecord {
+  StringRef trackId;
+  StringRef title;
+  StringRef album;
+  StringRef artist;
+  StringRef iconUri;
+  StringRef addedBy;
+  uint32_t durationMs;
+  int32_t votes;
+  uint64_t insertedAt;
+};
+
+struct SnapshotFile::UserRecord {
+  StringRef sessionId;
+  StringRef name;
+  int64_t expirationDate;
+  uint32_t isAdmin;
+  // votes of the user are stored in the votes section
+  uint32_t nrVotes;
+  uint64_t firstVote;
+};
+
+namespace {
+struct Section {
+  uint64_t offset;
+  uint64_t count;
+};
+}  // namespace
+
+struct SnapshotFile::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t lsn;
+  uint64_t fileSize;
+  Section tracks;
+  Section users;
+  Section votes;
+  Section strings;
+  uint32_t adminCount;
+  uint32_t normalCount;
+  uint32_t hasCurrentTrack;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(SnapshotFile::StringRef) == 8, "unexpected padding");
+static_assert(sizeof(SnapshotFile::TrackRecord) == 64, "unexpected padding");
+static_assert(sizeof(SnapshotFile::UserRecord) == 40, "unexpected padding");
+static_assert(sizeof(SnapshotFile::Header) == 112, "unexpected padding");
+
+static uint32_t const cByteOrderMarker = 0x01020304;
+
+static uint64_t align(uint64_t offset) {
+  return (offset + 7) & ~uint64_t(7);
+}
+
+namespace {
+/**
+ * @brief Collects the strings of a snapshot, every distinct string is stored
+ * once.
+ */
+class StringTable {
+ public:
+  SnapshotFile::StringRef add(string const &value) {
+    auto [it, inserted] = mOffsets.try_emplace(value, mData.size());
+    if (inserted) {
+      mData.append(value);
+    }
+    return {static_cast<uint32_t>(it->second),
+            static_cast<uint32_t>(value.size())};
+  }
+
+  string const &data() const {
+    return mData;
+  }
+
+ private:
+  // the keys refer to the strings of the written state
+  unordered_map<string_view, size_t> mOffsets;
+  string mData;
+};
+}  // namespace
+
+static TResultOpt writeFileDurable(string const &path, string const &data) {
+  string tmpPath = path + ".tmp";
+  int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return Error(ErrorCode::FileNotFound,
+                 "Failed to create '" + tmpPath + "': " + strerror(errno));
+  }
+
+  bool ok = true;
+  size_t written = 0;
+  while (ok && written < data.size()) {
+    auto ret = write(fd, data.data() + written, data.size() - written);
+    ok = ret > 0 || (ret < 0 && errno == EINTR);
+    written += (ret > 0) ? ret : 0;
+  }
+  ok = ok && fsync(fd) == 0;
+  string reason = strerror(errno);
+  close(fd);
+
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    reason = ok ? strerror(errno) : reason;
+    unlink(tmpPath.c_str());
+    return Error(ErrorCode::InvalidFormat,
+                 "Failed to write '" + path + "': " + reason);
+  }
+
+  // make the rename itself durable
+  string dir = path;
+  int dirFd = open(dirname(&dir[0]), O_RDONLY);
+  if (dirFd >= 0) {
+    fsync(dirFd);
+    close(dirFd);
+  }
+  return nullopt;
+}
+
+TResultOpt SnapshotFile::write(string const &path,
+                               QueueSnapshot const &queues,
+                               vector<User> const &users,
+                               uint64_t lsn) {
+  StringTable strings;
+
+  vector<TrackRecord> tracks;
+  auto addTrack = [&](QueuedTrack const &track) {
+    TrackRecord rec;
+    rec.trackId = strings.add(track.trackId);
+    rec.title = strings.add(track.title);
+    rec.album = strings.add(track.album);
+    rec.artist = strings.add(track.artist);
+    rec.iconUri = strings.add(track.iconUri);
+    rec.addedBy = strings.add(track.addedBy);
+    rec.durationMs = track.durationMs;
+    rec.votes = track.votes;
+    rec.insertedAt = track.insertedAt;
+    tracks.push_back(rec);
+  };
+  if (queues.currentTrack.has_value()) {
+    addTrack(queues.currentTrack.value());
+  }
+  for (auto &&track : queues.adminQueue.tracks) {
+    addTrack(track);
+  }
+  for (auto &&track : queues.normalQueue.tracks) {
+    addTrack(track);
+  }
+
+  vector<User const *> sortedUsers;
+  sortedUsers.reserve(users.size());
+  for (auto &&user : users) {
+    sortedUsers.push_back(&user);
+  }
+  sort(sortedUsers.begin(),
+       sortedUsers.end(),
+       [](User const *a, User const *b) {
+         return a->SessionID < b->SessionID;
+       });
+
+  vector<UserRecord> userRecords;
+  vector<StringRef> votes;
+  for (auto &&userPtr : sortedUsers) {
+    User const &user = *userPtr;
+    UserRecord rec;
+    rec.sessionId = strings.add(user.SessionID);
+    rec.name = strings.add(user.Name);
+    rec.expirationDate = user.ExpirationDate;
+    rec.isAdmin = user.isAdmin;
+    rec.nrVotes = user.votes.size();
+    rec.firstVote = votes.size();
+    for (auto &&tID : user.votes) {
+      votes.push_back(strings.add(tID));
+    }
+    userRecords.push_back(rec);
+  }
+
+  if (strings.data().size() > numeric_limits<uint32_t>::max()) {
+    return Error(ErrorCode::InvalidValue, "Snapshot string table too large");
+  }
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, cMagic, sizeof(header.magic));
+  header.version = cVersion;
+  header.byteOrder = cByteOrderMarker;
+  header.lsn = lsn;
+  header.tracks = {align(sizeof(Header)), tracks.size()};
+  header.users = {
+      align(header.tracks.offset + tracks.size() * sizeof(TrackRecord)),
+      userRecords.size()};
+  header.votes = {
+      align(header.users.offset + userRecords.size() * sizeof(UserRecord)),
+      votes.size()};
+  header.strings = {
+      align(header.votes.offset + votes.size() * sizeof(StringRef)),
+      strings.data().size()};
+  header.fileSize = header.strings.offset + header.strings.count;
+  header.adminCount = queues.adminQueue.tracks.size();
+  header.normalCount = queues.normalQueue.tracks.size();
+  header.hasCurrentTrack = queues.currentTrack.has_value();
+
+  string data(header.fileSize, '\0');
+  memcpy(&data[0], &header, sizeof(header));
+  memcpy(&data[header.tracks.offset], tracks.data(),
+         tracks.size() * sizeof(TrackRecord));
+  memcpy(&data[header.users.offset], userRecords.data(),
+         userRecords.size() * sizeof(UserRecord));
+  memcpy(&data[header.votes.offset], votes.data(),
+         votes.size() * sizeof(StringRef));
+  memcpy(&data[header.strings.offset], strings.data().data(),
+         strings.data().size());
+
+  return writeFileDurable(path, data);
+}
+
+SnapshotFile::~SnapshotFile() {
+  close();
+}
+
+void SnapshotFile::close() {
+  if (mData != nullptr) {
+    munmap(const_cast<char *>(mData), mSize);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mHeader = nullptr;
+  mTracks = nullptr;
+  mUsers = nullptr;
+  mVotes = nullptr;
+  mStrings = nullptr;
+}
+
+TResultOpt SnapshotFile::open(string const &path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    auto code = (errno == ENOENT) ? ErrorCode::FileNotFound
+                                  : ErrorCode::AccessDenied;
+    return Error(code, "Failed to open '" + path + "': " + strerror(errno));
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    ::close(fd);
+    return Error(ErrorCode::InvalidFormat,
+                 "File '" + path + "' is not a snapshot");
+  }
+
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return Error(ErrorCode::InvalidFormat,
+                 "Failed to map '" + path + "': " + strerror(errno));
+  }
+  // the whole file is going to be read
+  madvise(data, st.st_size, MADV_WILLNEED);
+
+  mData = static_cast<char const *>(data);
+  mSize = st.st_size;
+  mHeader = reinterpret_cast<Header const *>(mData);
+
+  auto fail = [&](string const &reason) {
+    close();
+    return Error(ErrorCode::InvalidFormat,
+                 "Invalid snapshot '" + path + "': " + reason);
+  };
+
+  if (memcmp(mHeader->magic, cMagic, sizeof(mHeader->magic)) != 0) {
+    return fail("no snapshot file");
+  }
+  if (mHeader->version != cVersion) {
+    return fail("unsupported version " + to_string(mHeader->version));
+  }
+  if (mHeader->byteOrder != cByteOrderMarker) {
+    return fail("unsupported byte order");
+  }
+  if (mHeader->fileSize != mSize) {
+    return fail("file size mismatch");
+  }
+
+  auto isValidSection = [&](Section const &section, size_t recordSize) {
+    return section.offset % 8 == 0 && section.offset <= mSize &&
+           section.count <= (mSize - section.offset) / recordSize;
+  };
+  if (!isValidSection(mHeader->tracks, sizeof(TrackRecord)) ||
+      !isValidSection(mHeader->users, sizeof(UserRecord)) ||
+      !isValidSection(mHeader->votes, sizeof(StringRef)) ||
+      !isValidSection(mHeader->strings, 1)) {
+    return fail("section out of bounds");
+  }
+  if (mHeader->hasCurrentTrack > 1 ||
+      mHeader->tracks.count != uint64_t(mHeader->hasCurrentTrack) +
+                                   mHeader->adminCount +
+                                   mHeader->normalCount) {
+    return fail("track count mismatch");
+  }
+
+  mTracks =
+      reinterpret_cast<TrackRecord const *>(mData + mHeader->tracks.offset);
+  mUsers =
+      reinterpret_cast<UserRecord const *>(mData + mHeader->users.offset);
+  mVotes =
+      reinterpret_cast<StringRef const *>(mData + mHeader->votes.offset);
+  mStrings = mData + mHeader->strings.offset;
+
+  // check all references once, so they can be used without checks later on
+  for (size_t i = 0; i < mHeader->tracks.count; i++) {
+    auto const &t = mTracks[i];
+    if (!isValid(t.trackId) || !isValid(t.title) || !isValid(t.album) ||
+        !isValid(t.artist) || !isValid(t.iconUri) || !isValid(t.addedBy)) {
+      return fail("string out of bounds");
+    }
+  }
+  for (size_t i = 0; i < mHeader->users.count; i++) {
+    auto const &u = mUsers[i];
+    if (!isValid(u.sessionId) || !isValid(u.name) ||
+        u.firstVote > mHeader->votes.count ||
+        u.nrVotes > mHeader->votes.count - u.firstVote) {
+      return fail("user out of bounds");
+    }
+    // findUser relies on the order
+    if (i > 0 &&
+        getString(mUsers[i - 1].sessionId) >= getString(u.sessionId)) {
+      return fail("users not sorted");
+    }
+  }
+  for (size_t i = 0; i < mHeader->votes.count; i++) {
+    if (!isValid(mVotes[i])) {
+      return fail("vote out of bounds");
+    }
+  }
+
+  return nullopt;
+}
+
+bool SnapshotFile::isValid(StringRef const &ref) const {
+  return ref.offset <= mHeader->strings.count &&
+         ref.length <= mHeader->strings.count - ref.offset;
+}
+
+string_view SnapshotFile::getString(StringRef const &ref) const {
+  return string_view(mStrings + ref.offset, ref.length);
+}
+
+QueuedTrack SnapshotFile::toTrack(TrackRecord const &rec) const {
+  QueuedTrack track;
+  track.trackId = getString(rec.trackId);
+  track.title = getString(rec.title);
+  track.album = getString(rec.album);
+  track.artist = getString(rec.artist);
+  track.iconUri = getString(rec.iconUri);
+  track.addedBy = getString(rec.addedBy);
+  track.durationMs = rec.durationMs;
+  track.votes = rec.votes;
+  track.userHasVoted = false;
+  track.insertedAt = rec.insertedAt;
+  return track;
+}
+
+uint64_t SnapshotFile::getLsn() const {
+  return mHeader ? mHeader->lsn : 0;
+}
+
+optional<QueuedTrack> SnapshotFile::getCurrentTrack() const {
+  if (!mHeader || !mHeader->hasCurrentTrack) {
+    return nullopt;
+  }
+  return toTrack(mTracks[0]);
+}
+
+size_t SnapshotFile::getTrackCount(QueueType q) const {
+  if (!mHeader) {
+    return 0;
+  }
+  return (q == QueueType::Admin) ? mHeader->adminCount : mHeader->normalCount;
+}
+
+QueuedTrack SnapshotFile::getTrack(QueueType q, size_t index) const {
+  size_t first = mHeader->hasCurrentTrack;
+  if (q == QueueType::Normal) {
+    first += mHeader->adminCount;
+  }
+  return toTrack(mTracks[first + index]);
+}
+
+size_t SnapshotFile::getUserCount() const {
+  return mHeader ? mHeader->users.count : 0;
+}
+
+User SnapshotFile::getUser(size_t index) const {
+  auto const &rec = mUsers[index];
+  User user;
+  user.SessionID = getString(rec.sessionId);
+  user.Name = getString(rec.name);
+  user.ExpirationDate = rec.expirationDate;
+  user.isAdmin = rec.isAdmin != 0;
+  user.votes.reserve(rec.nrVotes);
+  for (size_t i = 0; i < rec.nrVotes; i++) {
+    user.votes.emplace(getString(mVotes[rec.firstVote + i]));
+  }
+  return user;
+}
+
+QueueSnapshot SnapshotFile::getQueues() const {
+  QueueSnapshot queues;
+  queues.currentTrack = getCurrentTrack();
+  size_t nrAdmin = getTrackCount(QueueType::Admin);
+  queues.adminQueue.tracks.reserve(nrAdmin);
+  for (size_t i = 0; i < nrAdmin; i++) {
+    queues.adminQueue.tracks.push_back(getTrack(QueueType::Admin, i));
+  }
+  size_t nrNormal = getTrackCount(QueueType::Normal);
+  queues.normalQueue.tracks.reserve(nrNormal);
+  for (size_t i = 0; i < nrNormal; i++) {
+    queues.normalQueue.tracks.push_back(getTrack(QueueType::Normal, i));
+  }
+  return queues;
+}
+
+optional<User> SnapshotFile::findUser(TSessionID const &ID) const {
+  auto end = mUsers + getUserCount();
+  auto it = lower_bound(mUsers, end, ID,
+                        [this](UserRecord const &rec, TSessionID const &ID) {
+                          return getString(rec.sessionId) < ID;
+                        });
+  if (it != end && getString(it->sessionId) == ID) {
+    return getUser(it - mUsers);
+  }
+  return nullopt;
+}
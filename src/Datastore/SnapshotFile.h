@@ -0,0 +1,108 @@
+/*****************************************************************************/
+/**
+ * @file    SnapshotFile.h
+ * @author  Team Server
+ * @brief   Class SnapshotFile definition
+ */
+/*****************************************************************************/
+
+#ifndef _SNAPSHOTFILE_H_
+#define _SNAPSHOTFILE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Types/GlobalTypes.h"
+#include "Types/Queue.h"
+#include "Types/Result.h"
+#include "Types/Tracks.h"
+#include "Types/User.h"
+
+/**
+ * @brief Flat, versioned binary snapshot of the whole DataStore state which is
+ * memory mapped for reading.
+ * @details The file consists of a fixed header followed by sections of fixed
+ * size records (tracks, users, votes) and a string table. Records refer to
+ * strings by offset and length into the string table, equal strings are
+ * stored only once. All values are stored in native byte order, a marker in
+ * the header rejects files written on a machine with different byte order.
+ *
+ * Opening a snapshot maps the file and validates the header and all offsets,
+ * the records are read directly from the mapping without parsing. Users are
+ * sorted by their session ID, so they can be looked up in the mapping as well,
+ * files with unsorted users are rejected.
+ * Snapshots are written to a temporary file and renamed, so a crash never
+ * leaves a partial snapshot behind.
+ */
+class SnapshotFile {
+ public:
+  SnapshotFile() = default;
+  ~SnapshotFile();
+  SnapshotFile(SnapshotFile const &) = delete;
+  SnapshotFile &operator=(SnapshotFile const &) = delete;
+
+  /**
+   * @brief Writes a snapshot of the given state.
+   * @param path Path of the snapshot file, an existing file is replaced
+   * atomically.
+   * @param queues Queues and the currently playing track.
+   * @param users All users including their votes.
+   * @param lsn Sequence number of the last modification contained.
+   * @return An Error message or nothing at all (at success).
+   */
+  static TResultOpt write(std::string const &path,
+                          QueueSnapshot const &queues,
+                          std::vector<User> const &users,
+                          uint64_t lsn);
+
+  /**
+   * @brief Maps and validates a snapshot file.
+   * @return An Error message or nothing at all (at success).
+   */
+  TResultOpt open(std::string const &path);
+
+  uint64_t getLsn() const;
+  std::optional<QueuedTrack> getCurrentTrack() const;
+  size_t getTrackCount(QueueType q) const;
+  QueuedTrack getTrack(QueueType q, size_t index) const;
+  size_t getUserCount() const;
+  User getUser(size_t index) const;
+
+  /**
+   * @brief Copies the queues and the currently playing track.
+   */
+  QueueSnapshot getQueues() const;
+
+  /**
+   * @brief Looks up a user by session ID, without loading all users.
+   */
+  std::optional<User> findUser(TSessionID const &ID) const;
+
+  static constexpr char cMagic[] = "VJBSNAP2";
+  static uint32_t const cVersion = 1;
+
+  // records of the file format, see the implementation
+  struct StringRef;
+  struct TrackRecord;
+  struct UserRecord;
+  struct Header;
+
+ private:
+  void close();
+  std::string_view getString(StringRef const &ref) const;
+  QueuedTrack toTrack(TrackRecord const &record) const;
+  bool isValid(StringRef const &ref) const;
+
+  char const *mData = nullptr;
+  size_t mSize = 0;
+  Header const *mHeader = nullptr;
+  TrackRecord const *mTracks = nullptr;
+  UserRecord const *mUsers = nullptr;
+  StringRef const *mVotes = nullptr;
+  char const *mStrings = nullptr;
+};
+
+#endif /* _SNAPSHOTFILE_H_ */
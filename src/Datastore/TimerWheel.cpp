@@ -0,0 +1,132 @@
+/*****************************************************************************/
+/**
+ * @file    TimerWheel.cpp
+ * @author  Team Server
+ * @brief   Class TimerWheel implementation
+ */
+/*****************************************************************************/
+
+#include "Datastore/TimerWheel.h"
+
+#include <algorithm>
+
+using namespace std;
+
+TimerWheel::TimerWheel(time_t now) : mNow(now) {
+}
+
+void TimerWheel::schedule(TSessionID const &id, time_t deadline) {
+  auto [it, inserted] = mTimers.try_emplace(id);
+  Timer &timer = it->second;
+
+  if (!inserted) {
+    if (deadline >= timer.deadline) {
+      // the timer gets moved once its current slot is reached
+      timer.deadline = deadline;
+      return;
+    }
+    timer.slot->erase(timer.pos);
+  }
+
+  timer.deadline = deadline;
+  insert(it->first, timer);
+}
+
+bool TimerWheel::cancel(TSessionID const &id) {
+  auto it = mTimers.find(id);
+  if (it == mTimers.end()) {
+    return false;
+  }
+
+  it->second.slot->erase(it->second.pos);
+  mTimers.erase(it);
+  return true;
+}
+
+vector<TSessionID> TimerWheel::advance(time_t now) {
+  vector<TSessionID> expired;
+
+  while (mNow < now) {
+    if (mTimers.empty()) {
+      // nothing to expire, skip the idle time at once
+      mNow = now;
+      break;
+    }
+
+    mNow++;
+
+    // whenever a level wraps around, the next slot of the level above gets
+    // distributed to the lower levels
+    for (unsigned level = 1; level < cLevels; level++) {
+      if ((mNow >> (cSlotBits * (level - 1))) & (cSlots - 1)) {
+        break;
+      }
+      cascade(level);
+    }
+    expire(expired);
+  }
+
+  return expired;
+}
+
+void TimerWheel::reserve(size_t n) {
+  mTimers.reserve(n);
+}
+
+size_t TimerWheel::size() const {
+  return mTimers.size();
+}
+
+void TimerWheel::insert(TSessionID const &id, Timer &timer) {
+  // already expired timers fire on the next tick
+  time_t when = max(timer.deadline, mNow + 1);
+  time_t delta = when - mNow;
+
+  unsigned level = 0;
+  while (level < cLevels - 1 &&
+         delta >= (time_t(1) << (cSlotBits * (level + 1)))) {
+    level++;
+  }
+  if (level == cLevels - 1) {
+    // park far deadlines in the furthest slot, they are re-inserted later
+    time_t maxDelta = (time_t(1) << (cSlotBits * cLevels)) - 1;
+    when = mNow + min(delta, maxDelta);
+  }
+
+  auto index = (when >> (cSlotBits * level)) & (cSlots - 1);
+  timer.slot = &mSlots[level][index];
+  timer.pos = timer.slot->insert(timer.slot->end(), &id);
+}
+
+void TimerWheel::cascade(unsigned level) {
+  auto index = (mNow >> (cSlotBits * level)) & (cSlots - 1);
+  TSlot slot;
+  slot.swap(mSlots[level][index]);
+
+  for (auto &&id : slot) {
+    Timer &timer = mTimers.at(*id);
+    if (timer.deadline <= mNow) {
+      // due right now, expired after cascading
+      timer.slot = &mSlots[0][mNow & (cSlots - 1)];
+      timer.pos = timer.slot->insert(timer.slot->end(), id);
+    } else {
+      insert(*id, timer);
+    }
+  }
+}
+
+void TimerWheel::expire(vector<TSessionID> &expired) {
+  TSlot slot;
+  slot.swap(mSlots[0][mNow & (cSlots - 1)]);
+
+  for (auto &&id : slot) {
+    auto it = mTimers.find(*id);
+    if (it->second.deadline > mNow) {
+      // deadline was moved in the meantime
+      insert(it->first, it->second);
+    } else {
+      expired.push_back(it->first);
+      mTimers.erase(it);
+    }
+  }
+}
@@ -0,0 +1,87 @@
+/*****************************************************************************/
+/**
+ * @file    TimerWheel.h
+ * @author  Team Server
+ * @brief   Class TimerWheel definition
+ */
+/*****************************************************************************/
+
+#ifndef _TIMERWHEEL_H_
+#define _TIMERWHEEL_H_
+
+#include <ctime>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "Types/GlobalTypes.h"
+
+/**
+ * @brief Hierarchical timer wheel with a resolution of one second, used to
+ * track session deadlines.
+ * @details Four levels of 64 slots each cover deadlines up to about 194 days
+ * ahead, later deadlines are parked in the last level until they come into
+ * range. Scheduling, rescheduling and cancelling a timer take constant time,
+ * advancing the wheel takes amortized constant time per elapsed second and
+ * expired timer.
+ *
+ * Moving a deadline further into the future only updates the stored deadline,
+ * the timer is moved lazily once its old slot is reached. This keeps sliding
+ * deadlines (e.g. on every request of a user) cheap.
+ */
+class TimerWheel {
+ public:
+  /**
+   * @param now The current time, deadlines up to this time are considered
+   * expired.
+   */
+  explicit TimerWheel(std::time_t now);
+
+  /**
+   * @brief Adds a timer or changes the deadline of an existing one.
+   */
+  void schedule(TSessionID const &id, std::time_t deadline);
+
+  /**
+   * @brief Removes a timer.
+   * @return `false` if there was no timer with this ID.
+   */
+  bool cancel(TSessionID const &id);
+
+  /**
+   * @brief Advances the wheel to `now` and removes all expired timers.
+   * @return IDs of the timers with a deadline of `now` or earlier.
+   */
+  std::vector<TSessionID> advance(std::time_t now);
+
+  /**
+   * @brief Prepares the wheel for `n` timers.
+   */
+  void reserve(size_t n);
+
+  size_t size() const;
+
+ private:
+  static unsigned const cLevels = 4;
+  static unsigned const cSlotBits = 6;
+  static unsigned const cSlots = 1 << cSlotBits;
+
+  using TSlot = std::list<TSessionID const *>;
+
+  struct Timer {
+    std::time_t deadline;
+    TSlot *slot;
+    TSlot::iterator pos;
+  };
+
+  void insert(TSessionID const &id, Timer &timer);
+  void cascade(unsigned level);
+  void expire(std::vector<TSessionID> &expired);
+
+  // slots only refer to the keys of mTimers, which are stable
+  TSlot mSlots[cLevels][cSlots];
+  std::unordered_map<TSessionID, Timer> mTimers;
+  std::time_t mNow;
+};
+
+#endif /* _TIMERWHEEL_H_ */
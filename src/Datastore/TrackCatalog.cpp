@@ -0,0 +1,67 @@
+/*****************************************************************************/
+/**
+ * @file    TrackCatalog.cpp
+ * @author  Team Server
+ * @brief   Class TrackCatalog implementation
+ */
+/*****************************************************************************/
+
+#include "Datastore/TrackCatalog.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static bool sameMetadata(BaseTrack const &a, BaseTrack const &b) {
+  return a.trackId == b.trackId && a.title == b.title && a.album == b.album &&
+         a.artist == b.artist && a.durationMs == b.durationMs &&
+         a.iconUri == b.iconUri && a.addedBy == b.addedBy;
+}
+
+QueuedTrack TrackEntry::toQueuedTrack() const {
+  QueuedTrack qtr;
+  static_cast<BaseTrack &>(qtr) = *track;
+  qtr.votes = votes;
+  qtr.userHasVoted = false;
+  qtr.insertedAt = insertedAt;
+  return qtr;
+}
+
+TTrackMetadata TrackCatalog::intern(BaseTrack track) {
+  auto &entry = mTracks[track.trackId];
+  auto metadata = entry.lock();
+  if (metadata && sameMetadata(*metadata, track)) {
+    return metadata;
+  }
+
+  // unknown, released or changed (e.g. added by someone else) metadata
+  metadata = make_shared<BaseTrack const>(move(track));
+  entry = metadata;
+
+  // released entries are removed once the catalog doubled its size, which
+  // keeps interning amortized constant time
+  if (mTracks.size() >= mNextCleanup) {
+    removeReleased();
+  }
+  return metadata;
+}
+
+void TrackCatalog::reserve(size_t n) {
+  mTracks.reserve(n);
+  mNextCleanup = max(mNextCleanup, 2 * n);
+}
+
+size_t TrackCatalog::size() const {
+  return mTracks.size();
+}
+
+void TrackCatalog::removeReleased() {
+  for (auto it = mTracks.begin(); it != mTracks.end();) {
+    if (it->second.expired()) {
+      it = mTracks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  mNextCleanup = max<size_t>(64, 2 * mTracks.size());
+}
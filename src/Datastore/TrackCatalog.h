@@ -0,0 +1,77 @@
+/*****************************************************************************/
+/**
+ * @file    TrackCatalog.h
+ * @author  Team Server
+ * @brief   Class TrackCatalog definition
+ */
+/*****************************************************************************/
+
+#ifndef _TRACKCATALOG_H_
+#define _TRACKCATALOG_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "Types/GlobalTypes.h"
+#include "Types/Tracks.h"
+
+/**
+ * @brief Shared, immutable metadata (title, artist, ...) of a track.
+ */
+using TTrackMetadata = std::shared_ptr<BaseTrack const>;
+
+/**
+ * @brief Compact representation of a queued track inside a DataStore.
+ * @details Only the votes and the insertion time belong to the entry itself,
+ * all strings are shared with every other entry, snapshot or current track
+ * referring to the same metadata. Copying an entry does not copy any string.
+ */
+struct TrackEntry {
+  TTrackMetadata track;
+  int votes = 0;
+  uint64_t insertedAt = 0;
+
+  TTrackID const &trackId() const {
+    return track->trackId;
+  }
+
+  /**
+   * @brief Expands the entry to a QueuedTrack as it is returned to clients.
+   */
+  QueuedTrack toQueuedTrack() const;
+};
+
+/**
+ * @brief Interns track metadata, so identical tracks are stored only once.
+ * @details The catalog itself does not keep tracks alive, metadata is released
+ * as soon as the last entry referencing it is gone. The catalog is not
+ * synchronized, the owner has to guard it.
+ */
+class TrackCatalog {
+ public:
+  /**
+   * @brief Returns the shared metadata for `track`.
+   * @details If metadata with the same content is still in use, it is reused,
+   * otherwise a new shared instance is created.
+   */
+  TTrackMetadata intern(BaseTrack track);
+
+  /**
+   * @brief Prepares the catalog for `n` tracks.
+   */
+  void reserve(size_t n);
+
+  /**
+   * @brief Number of (possibly already released) catalog entries.
+   */
+  size_t size() const;
+
+ private:
+  void removeReleased();
+
+  std::unordered_map<TTrackID, std::weak_ptr<BaseTrack const>> mTracks;
+  size_t mNextCleanup = 64;
+};
+
+#endif /* _TRACKCATALOG_H_ */
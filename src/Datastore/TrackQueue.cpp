@@ -0,0 +1,113 @@
+/*****************************************************************************/
+/**
+ * @file    TrackQueue.cpp
+ * @author  Team Server
+ * @brief   Class TrackQueue implementation
+ */
+/*****************************************************************************/
+
+#include "Datastore/TrackQueue.h"
+
+#include <iterator>
+#include <utility>
+
+using namespace std;
+
+bool TrackQueue::Key::operator<(Key const &other) const {
+  // same order as QueuedTrack::operator<, insertion order breaks ties
+  if (votes != other.votes) {
+    return votes > other.votes;
+  }
+  if (insertedAt != other.insertedAt) {
+    return insertedAt < other.insertedAt;
+  }
+  return sequence < other.sequence;
+}
+
+BaseTrack const *TrackQueue::find(TTrackID const &id) const {
+  auto it = mIndex.find(id);
+  if (it == mIndex.end()) {
+    return nullptr;
+  }
+  return it->second->second.get();
+}
+
+bool TrackQueue::contains(TTrackID const &id) const {
+  return mIndex.find(id) != mIndex.end();
+}
+
+bool TrackQueue::push(TrackEntry const &track) {
+  if (contains(track.trackId())) {
+    return false;
+  }
+
+  Key key{track.votes, track.insertedAt, mNextSequence++};
+  // tracks are often pushed in playback order (e.g. when restoring a queue)
+  auto hint = mTracks.end();
+  if (!mTracks.empty() && !(prev(hint)->first < key)) {
+    hint = mTracks.lower_bound(key);
+  }
+  auto it = mTracks.emplace_hint(hint, key, track.track);
+  mIndex.emplace(it->second->trackId, it);
+  return true;
+}
+
+optional<TrackEntry> TrackQueue::remove(TTrackID const &id) {
+  auto indexIt = mIndex.find(id);
+  if (indexIt == mIndex.end()) {
+    return nullopt;
+  }
+
+  auto it = indexIt->second;
+  mIndex.erase(indexIt);
+  TrackEntry track{move(it->second), it->first.votes, it->first.insertedAt};
+  mTracks.erase(it);
+  return track;
+}
+
+optional<TrackEntry> TrackQueue::popFront() {
+  if (mTracks.empty()) {
+    return nullopt;
+  }
+
+  auto it = mTracks.begin();
+  mIndex.erase(it->second->trackId);
+  TrackEntry track{move(it->second), it->first.votes, it->first.insertedAt};
+  mTracks.erase(it);
+  return track;
+}
+
+bool TrackQueue::changeVotes(TTrackID const &id, int delta) {
+  auto indexIt = mIndex.find(id);
+  if (indexIt == mIndex.end()) {
+    return false;
+  }
+
+  // Re-key the node in place: neither the track nor its strings get copied
+  auto node = mTracks.extract(indexIt->second);
+  node.key().votes += delta;
+  indexIt->second = mTracks.insert(move(node)).position;
+  return true;
+}
+
+void TrackQueue::reserve(size_t n) {
+  mIndex.reserve(n);
+}
+
+size_t TrackQueue::size() const {
+  return mTracks.size();
+}
+
+bool TrackQueue::empty() const {
+  return mTracks.empty();
+}
+
+Queue TrackQueue::toQueue() const {
+  Queue queue;
+  queue.tracks.reserve(mTracks.size());
+  for (auto &&entry : mTracks) {
+    TrackEntry track{entry.second, entry.first.votes, entry.first.insertedAt};
+    queue.tracks.push_back(track.toQueuedTrack());
+  }
+  return queue;
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************/
+/**
+ * @file    TrackQueue.h
+ * @author  Team Server
+ * @brief   Class TrackQueue definition
+ */
+/*****************************************************************************/
+
+#ifndef _TRACKQUEUE_H_
+#define _TRACKQUEUE_H_
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include "Datastore/TrackCatalog.h"
+#include "Types/GlobalTypes.h"
+#include "Types/Queue.h"
+#include "Types/Tracks.h"
+
+/**
+ * @brief Queue of tracks which is always kept in playback order.
+ * @details Tracks are ordered by their number of votes (descending) and their
+ * insertion time (ascending), ties are resolved by insertion order. Every track
+ * can be looked up by its ID in constant time, so changing the votes of a
+ * single track only repositions this one track (O(log n)) instead of sorting
+ * the whole queue.
+ */
+class TrackQueue {
+ public:
+  /**
+   * @brief Looks up a track by its ID.
+   * @return Pointer to the metadata or `nullptr` if it is not queued.
+   */
+  BaseTrack const *find(TTrackID const &id) const;
+  bool contains(TTrackID const &id) const;
+
+  /**
+   * @brief Inserts a track at the position given by its votes and insertion
+   * time.
+   * @return `false` if a track with the same ID is already queued.
+   */
+  bool push(TrackEntry const &track);
+
+  /**
+   * @brief Removes a track from the queue.
+   * @return The removed track or `nullopt` if it is not queued.
+   */
+  std::optional<TrackEntry> remove(TTrackID const &id);
+
+  /**
+   * @brief Removes the first track (i.e. the one to be played next).
+   * @return The removed track or `nullopt` if the queue is empty.
+   */
+  std::optional<TrackEntry> popFront();
+
+  /**
+   * @brief Adds `delta` to the votes of a track and repositions it.
+   * @return `false` if the track is not queued.
+   */
+  bool changeVotes(TTrackID const &id, int delta);
+
+  /**
+   * @brief Prepares the queue for `n` tracks.
+   */
+  void reserve(size_t n);
+
+  size_t size() const;
+  bool empty() const;
+
+  /**
+   * @brief Copies all tracks in playback order.
+   */
+  Queue toQueue() const;
+
+ private:
+  struct Key {
+    int votes;
+    uint64_t insertedAt;
+    uint64_t sequence;
+
+    bool operator<(Key const &other) const;
+  };
+  using TTrackMap = std::map<Key, TTrackMetadata>;
+
+  TTrackMap mTracks;
+  // keys refer to the track IDs inside the shared metadata
+  std::unordered_map<std::string_view, TTrackMap::iterator> mIndex;
+  uint64_t mNextSequence = 0;
+};
+
+#endif /* _TRACKQUEUE_H_ */
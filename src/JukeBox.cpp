@@ -8,9 +8,13 @@
 
 #include "JukeBox.h"
 
+#include <chrono>
 #include <ctime>
+#include <functional>
 #include <memory>
+#include <random>
 
+#include "Datastore/PersistentDataStore.h"
 #include "Datastore/RAMDataStore.h"
 #include "Network/RestAPI.h"
 #include "Spotify/SpotifyBackend.h"
@@ -21,12 +25,18 @@
 using namespace std;
 
 JukeBox::JukeBox() {
+  /* The start time alone is not unique if the server restarts within the same
+   * second */
+  mEpoch = (static_cast<uint64_t>(time(nullptr)) << 32) | random_device{}();
   mDataStore = new RAMDataStore();
   mNetwork = new RestAPI();
   mMusicBackend = new SpotifyBackend();
-  mScheduler = new SimpleScheduler(mDataStore, mMusicBackend);
+  mScheduler = new SimpleScheduler(
+      mDataStore, mMusicBackend, &mChangeNotifier, &mEvents);
+  mDataStore->setChangeNotifier(&mChangeNotifier);
+  mListener = new InstrumentedNetworkListener(this);
 
-  mNetwork->setListener(this);
+  mNetwork->setListener(mListener);
 }
 
 JukeBox::~JukeBox() {
@@ -34,6 +44,8 @@ JukeBox::~JukeBox() {
   mDataStore = nullptr;
   delete mNetwork;
   mNetwork = nullptr;
+  delete mListener;
+  mListener = nullptr;
   delete mMusicBackend;
   mMusicBackend = nullptr;
 }
@@ -62,6 +74,27 @@ bool JukeBox::start(string const &exeName, string const &configFilePath) {
   LOG(INFO) << "#########################################################################";
   // clang-format on
 
+  // persist the DataStore if a journal directory is configured
+  auto journalDir = conf->getValueString("DataStore", "journalDirectory");
+  if (holds_alternative<string>(journalDir) &&
+      !get<string>(journalDir).empty()) {
+    auto dataStore = new PersistentDataStore();
+    ret = dataStore->open(get<string>(journalDir));
+    if (ret.has_value()) {
+      LOG(ERROR) << "Failed to open persistent DataStore ("
+                 << ret.value().getErrorMessage() << ")";
+      delete dataStore;
+      return false;
+    }
+
+    delete mScheduler;
+    delete mDataStore;
+    mDataStore = dataStore;
+    mDataStore->setChangeNotifier(&mChangeNotifier);
+    mScheduler = new SimpleScheduler(
+        mDataStore, mMusicBackend, &mChangeNotifier, &mEvents);
+  }
+
   ret = mMusicBackend->initBackend();
   if (ret.has_value()) {
     LOG(ERROR) << "Failed to initialize music backend ("
@@ -150,26 +183,27 @@ TResult<QueueStatus> JukeBox::getCurrentQueues(TSessionID const &sid) {
   User user = get<User>(retUser);
 
   QueueStatus qs;
+  /* Read the version first, a change while the queues are copied gets
+   * reported by the next call of waitForChange */
+  qs.version = mChangeNotifier.getVersion();
+
+  /* Use a single snapshot, so both queues and the current track are
+   * consistent to each other */
+  auto retSnapshot = mDataStore->getQueueSnapshot();
+  if (holds_alternative<Error>(retSnapshot))
+    return get<Error>(retSnapshot);
+  auto snapshot = get<TQueueSnapshot>(retSnapshot);
+  qs.queueVersion = snapshot->version;
+  rememberServedQueues(snapshot);
 
   /* Set flag if the user has already voted for a track */
-  auto ret = mDataStore->getQueue(QueueType::Normal);
-  if (holds_alternative<Error>(ret))
-    return get<Error>(ret);
-  qs.normalQueue = get<Queue>(ret);
+  qs.normalQueue = snapshot->normalQueue;
 
   for (auto &queueElem : qs.normalQueue.tracks) {
-    queueElem.userHasVoted = false;
-    for (auto const &votedElem : user.votes) {
-      if (queueElem.trackId == votedElem)
-        /* User has voted for this track */
-        queueElem.userHasVoted = true;
-    }
+    queueElem.userHasVoted = user.votes.count(queueElem.trackId) > 0;
   }
 
-  ret = mDataStore->getQueue(QueueType::Admin);
-  if (holds_alternative<Error>(ret))
-    return get<Error>(ret);
-  qs.adminQueue = get<Queue>(ret);
+  qs.adminQueue = snapshot->adminQueue;
 
   /* Construct current PlaybackTrack through combining of information
    * in DataStore and Spotify */
@@ -188,16 +222,12 @@ TResult<QueueStatus> JukeBox::getCurrentQueues(TSessionID const &sid) {
   PlaybackTrack pbtSpotify = pbtSpotifyOpt.value();
 
   // query expected playback
-  auto currentTrackOptRes = mDataStore->getPlayingTrack();
-  if (holds_alternative<Error>(currentTrackOptRes))
-    return get<Error>(currentTrackOptRes);
-
-  auto currentTrackOpt = get<optional<QueuedTrack>>(currentTrackOptRes);
+  auto const &currentTrackOpt = snapshot->currentTrack;
   if (!currentTrackOpt.has_value()) {
     qs.currentTrack = nullopt;
     return qs;
   }
-  auto currentTrack = currentTrackOpt.value();
+  auto const &currentTrack = currentTrackOpt.value();
 
   // construct playback track
   PlaybackTrack pbt;
@@ -231,6 +261,101 @@ TResult<QueueStatus> JukeBox::getCurrentQueues(TSessionID const &sid) {
   return qs;
 }
 
+TResult<uint64_t> JukeBox::waitForChange(TSessionID const &sid,
+                                          uint64_t since,
+                                          chrono::milliseconds timeout) {
+  auto retIsExpired = mDataStore->isSessionExpired(sid);
+  if (holds_alternative<Error>(retIsExpired))
+    return get<Error>(retIsExpired);
+
+  if (!mDataStore->hasUser(sid)) {
+    string msg = "User with session ID '" + sid + "' does not exist.";
+    LOG(WARNING) << msg;
+    return Error(ErrorCode::DoesntExist, msg);
+  }
+
+  return mChangeNotifier.waitForChange(since, timeout);
+}
+
+TResult<EventBroadcaster *> JukeBox::getEvents(TSessionID const &sid) {
+  auto retIsExpired = mDataStore->isSessionExpired(sid);
+  if (holds_alternative<Error>(retIsExpired))
+    return get<Error>(retIsExpired);
+
+  if (!mDataStore->hasUser(sid)) {
+    string msg = "User with session ID '" + sid + "' does not exist.";
+    LOG(WARNING) << msg;
+    return Error(ErrorCode::DoesntExist, msg);
+  }
+
+  return &mEvents;
+}
+
+TResult<TQueueSnapshot> JukeBox::getPreviousQueues(TSessionID const &sid,
+                                                   uint64_t queueVersion) {
+  auto retIsExpired = mDataStore->isSessionExpired(sid);
+  if (holds_alternative<Error>(retIsExpired))
+    return get<Error>(retIsExpired);
+
+  if (!mDataStore->hasUser(sid)) {
+    string msg = "User with session ID '" + sid + "' does not exist.";
+    LOG(WARNING) << msg;
+    return Error(ErrorCode::DoesntExist, msg);
+  }
+
+  lock_guard<mutex> lock(mMtxServedQueues);
+  for (auto &&served : mServedQueues) {
+    if (served->version == queueVersion) {
+      return served;
+    }
+  }
+  return Error(ErrorCode::DoesntExist,
+               "Queues of version " + to_string(queueVersion) +
+                   " are not known anymore");
+}
+
+TResult<QueueStatusTag> JukeBox::getQueueStatusTag(TSessionID const &sid) {
+  auto retIsExpired = mDataStore->isSessionExpired(sid);
+  if (holds_alternative<Error>(retIsExpired))
+    return get<Error>(retIsExpired);
+
+  if (!mDataStore->hasUser(sid)) {
+    string msg = "User with session ID '" + sid + "' does not exist.";
+    LOG(WARNING) << msg;
+    return Error(ErrorCode::DoesntExist, msg);
+  }
+
+  auto retUser = mDataStore->getUser(sid);
+  if (holds_alternative<Error>(retUser))
+    return get<Error>(retUser);
+  User user = get<User>(retUser);
+
+  QueueStatusTag tag;
+  tag.epoch = mEpoch;
+  tag.version = mChangeNotifier.getVersion();
+
+  /* The votes are not ordered, so their hashes are combined independently of
+   * the order */
+  tag.votesHash = 0;
+  for (auto &&trackId : user.votes) {
+    tag.votesHash ^= hash<TTrackID>{}(trackId);
+  }
+  return tag;
+}
+
+void JukeBox::rememberServedQueues(TQueueSnapshot const &snapshot) {
+  lock_guard<mutex> lock(mMtxServedQueues);
+  for (auto &&served : mServedQueues) {
+    if (served->version == snapshot->version) {
+      return;
+    }
+  }
+  mServedQueues.push_back(snapshot);
+  if (mServedQueues.size() > cMaxServedQueues) {
+    mServedQueues.pop_front();
+  }
+}
+
 TResultOpt JukeBox::addTrackToQueue(TSessionID const &sid,
                                     TTrackID const &trkid,
                                     QueueType type) {
@@ -283,42 +408,128 @@ TResultOpt JukeBox::removeTrack(TSessionID const &sid, TTrackID const &trkid) {
     return Error(ErrorCode::AccessDenied, "User is not an admin.");
   }
 
-  /* Check, if TrackID exists in any queue */
-  /* Admin queue */
-  auto retQueue = mDataStore->getQueue(QueueType::Admin);
-  if (holds_alternative<Error>(retQueue))
-    return get<Error>(retQueue);
-  Queue queue = get<Queue>(retQueue);
-  bool trackFoundAdmin =
-      get<bool>(mDataStore->hasTrack(trkid, QueueType::Admin));
-
-  /* Normal queue */
-  retQueue = mDataStore->getQueue(QueueType::Normal);
-  if (holds_alternative<Error>(retQueue))
-    return get<Error>(retQueue);
-  queue = get<Queue>(retQueue);
-  bool trackFoundNormal =
-      get<bool>(mDataStore->hasTrack(trkid, QueueType::Normal));
-
-  if (!trackFoundAdmin && !trackFoundNormal) {
-    LOG(WARNING) << "Jukebox.moveTrack: TrackID '" << trkid
+  /* Find the queue containing the TrackID */
+  auto retLocate = mDataStore->locateTrack(trkid);
+  if (holds_alternative<Error>(retLocate))
+    return get<Error>(retLocate);
+  auto queueType = get<optional<QueueType>>(retLocate);
+
+  if (!queueType.has_value()) {
+    LOG(WARNING) << "Jukebox.removeTrack: TrackID '" << trkid
                  << "' could not be found.";
     return Error(ErrorCode::DoesntExist, "Track not found.");
   }
 
-  QueueType q;
-  if (trackFoundAdmin)
-    q = QueueType::Admin;
-  if (trackFoundNormal)
-    q = QueueType::Normal;
-
-  auto retTrack = mDataStore->removeTrack(trkid, q);
+  auto retTrack = mDataStore->removeTrack(trkid, queueType.value());
   if (holds_alternative<Error>(retTrack))
     return get<Error>(retTrack);
 
   return nullopt;
 }
 
+TResult<vector<TResultOpt>> JukeBox::addTracksToQueue(
+    TSessionID const &sid, vector<TTrackID> const &trkids, QueueType type) {
+  auto retIsExpired = mDataStore->isSessionExpired(sid);
+  if (holds_alternative<Error>(retIsExpired))
+    return get<Error>(retIsExpired);
+
+  User user = get<User>(mDataStore->getUser(sid));
+
+  if (type == QueueType::Admin && !user.isAdmin) {
+    LOG(WARNING) << "JukeBox.addTracksToQueue: User with session ID '" << sid
+                 << "' and nickname '" << user.Name
+                 << "' is not priviledged to add tracks to the admin queue.";
+    return Error(ErrorCode::AccessDenied, "User is not an admin.");
+  }
+
+  vector<TResultOpt> results(trkids.size());
+  vector<BaseTrack> tracks;
+  vector<size_t> indices;
+  tracks.reserve(trkids.size());
+  indices.reserve(trkids.size());
+
+  for (size_t i = 0; i < trkids.size(); ++i) {
+    auto query = mMusicBackend->createBaseTrack(trkids[i]);
+    if (holds_alternative<Error>(query)) {
+      LOG(WARNING)
+          << "JukeBox.addTracksToQueue: Could not add track for TrackID '"
+          << trkids[i] << "'.";
+      results[i] = get<Error>(query);
+      continue;
+    }
+    tracks.push_back(move(get<BaseTrack>(query)));
+    tracks.back().addedBy = user.Name;
+    indices.push_back(i);
+  }
+
+  auto retAdd = mDataStore->addTracks(tracks, type);
+  if (holds_alternative<Error>(retAdd))
+    return get<Error>(retAdd);
+
+  auto const &added = get<vector<TResultOpt>>(retAdd);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    results[indices[i]] = added[i];
+  }
+  return results;
+}
+
+TResultOpt JukeBox::voteTracks(TSessionID const &sid,
+                               vector<pair<TTrackID, TVote>> const &votes) {
+  auto retIsExpired = mDataStore->isSessionExpired(sid);
+  if (holds_alternative<Error>(retIsExpired))
+    return get<Error>(retIsExpired);
+
+  return mDataStore->voteTracks(sid, votes);
+}
+
+TResult<vector<TResultOpt>> JukeBox::removeTracks(
+    TSessionID const &sid, vector<TTrackID> const &trkids) {
+  auto retIsExpired = mDataStore->isSessionExpired(sid);
+  if (holds_alternative<Error>(retIsExpired))
+    return get<Error>(retIsExpired);
+
+  User user = get<User>(mDataStore->getUser(sid));
+
+  if (!user.isAdmin) {
+    LOG(WARNING) << "JukeBox.removeTracks: User with session ID '" << sid
+                 << "' and nickname '" << user.Name
+                 << "' is not priviledged to remove tracks.";
+    return Error(ErrorCode::AccessDenied, "User is not an admin.");
+  }
+
+  /* Admin queue first, the remaining tracks from the normal queue */
+  auto retAdmin = mDataStore->removeTracks(trkids, QueueType::Admin);
+  if (holds_alternative<Error>(retAdmin))
+    return get<Error>(retAdmin);
+  auto results = get<vector<TResultOpt>>(retAdmin);
+
+  vector<TTrackID> remaining;
+  vector<size_t> indices;
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (results[i].has_value()) {
+      remaining.push_back(trkids[i]);
+      indices.push_back(i);
+    }
+  }
+  if (remaining.empty())
+    return results;
+
+  auto retNormal = mDataStore->removeTracks(remaining, QueueType::Normal);
+  if (holds_alternative<Error>(retNormal))
+    return get<Error>(retNormal);
+
+  auto const &normal = get<vector<TResultOpt>>(retNormal);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    results[indices[i]] = normal[i];
+    if (normal[i].has_value()) {
+      LOG(WARNING) << "JukeBox.removeTracks: TrackID '" << remaining[i]
+                   << "' could not be found.";
+      results[indices[i]] = Error(ErrorCode::DoesntExist, "Track not found.");
+    }
+  }
+  return results;
+}
+
 TResultOpt JukeBox::moveTrack(TSessionID const &sid,
                               TTrackID const &trkid,
                               QueueType toQueue) {
@@ -343,22 +554,14 @@ TResultOpt JukeBox::moveTrack(TSessionID const &sid,
   if (toQueue == QueueType::Normal)
     fromQueue = QueueType::Admin;
 
-  /* Query the source queue for the track that is to be deleted */
-  bool trackFound = get<bool>(mDataStore->hasTrack(trkid, fromQueue));
-
-  if (!trackFound) {
+  /* Move the track at once, the votes are kept */
+  auto ret = mDataStore->moveTrack(trkid, fromQueue, toQueue, true);
+  if (ret.has_value() && ret->getErrorCode() == ErrorCode::DoesntExist) {
     LOG(WARNING) << "Jukebox.moveTrack: TrackID '" << trkid
                  << "' could not be found.";
     return Error(ErrorCode::DoesntExist, "Track not found.");
   }
-
-  /* Remove from source queue */
-  auto retTrack = mDataStore->removeTrack(trkid, fromQueue);
-  if (holds_alternative<Error>(retTrack))
-    return get<Error>(retTrack);
-
-  /* Add to target queue */
-  return mDataStore->addTrack(get<BaseTrack>(retTrack), toQueue);
+  return ret;
 }
 
 TResultOpt JukeBox::controlPlayer(TSessionID const &sid, PlayerAction action) {
@@ -9,17 +9,23 @@
 #ifndef _JUKEBOX_H_
 #define _JUKEBOX_H_
 
+#include <deque>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "DataStore.h"
 #include "MusicBackend.h"
+#include "Network/InstrumentedNetworkListener.h"
 #include "NetworkAPI.h"
 #include "NetworkListener.h"
 #include "Types/GlobalTypes.h"
 #include "Types/Queue.h"
 #include "Types/Result.h"
+#include "Utils/ChangeNotifier.h"
+#include "Utils/EventBroadcaster.h"
 #include "Utils/SimpleScheduler.h"
 
 /**
@@ -55,7 +61,14 @@ class JukeBox : public NetworkListener {
       std::optional<std::string> const &nickname) override;
   TResult<std::vector<BaseTrack>> queryTracks(
       std::string const &searchPattern, size_t const nrOfEntries) override;
-  TResult<QueueStatus> getCurrentQueues(TSessionID const &sid);
+  TResult<QueueStatus> getCurrentQueues(TSessionID const &sid) override;
+  TResult<uint64_t> waitForChange(TSessionID const &sid,
+                                  uint64_t since,
+                                  std::chrono::milliseconds timeout) override;
+  TResult<EventBroadcaster *> getEvents(TSessionID const &sid) override;
+  TResult<TQueueSnapshot> getPreviousQueues(TSessionID const &sid,
+                                            uint64_t queueVersion) override;
+  TResult<QueueStatusTag> getQueueStatusTag(TSessionID const &sid) override;
   TResultOpt addTrackToQueue(TSessionID const &sid,
                              TTrackID const &trkid,
                              QueueType type) override;
@@ -63,16 +76,41 @@ class JukeBox : public NetworkListener {
                        TTrackID const &trkid,
                        TVote vote) override;
   TResultOpt removeTrack(TSessionID const &sid, TTrackID const &trkid) override;
+  TResult<std::vector<TResultOpt>> addTracksToQueue(
+      TSessionID const &sid,
+      std::vector<TTrackID> const &trkids,
+      QueueType type) override;
+  TResultOpt voteTracks(
+      TSessionID const &sid,
+      std::vector<std::pair<TTrackID, TVote>> const &votes) override;
+  TResult<std::vector<TResultOpt>> removeTracks(
+      TSessionID const &sid, std::vector<TTrackID> const &trkids) override;
   TResultOpt moveTrack(TSessionID const &sid,
                        TTrackID const &trkid,
                        QueueType toQueue) override;
   TResultOpt controlPlayer(TSessionID const &sid, PlayerAction action) override;
 
  private:
+  void rememberServedQueues(TQueueSnapshot const &snapshot);
+
   DataStore *mDataStore;
   NetworkAPI *mNetwork;
+  // records metrics of all requests before forwarding them to the JukeBox
+  InstrumentedNetworkListener *mListener;
   MusicBackend *mMusicBackend;
   SimpleScheduler *mScheduler;
+  // notified by the DataStore and the scheduler
+  ChangeNotifier mChangeNotifier;
+  // distinguishes the versions of this instance from the ones of previous
+  // runs, which restarted at the same numbers
+  uint64_t mEpoch;
+  // published by the scheduler, streamed to the clients
+  EventBroadcaster mEvents;
+  // queues recently returned by getCurrentQueues, clients can request only
+  // the changes since one of them
+  std::deque<TQueueSnapshot> mServedQueues;
+  std::mutex mMtxServedQueues;
+  static constexpr size_t cMaxServedQueues = 32;
 };
 
 #endif /* _JUKEBOX_H_ */
@@ -0,0 +1,249 @@
+/*****************************************************************************/
+/**
+ * @file    ContentNegotiation.cpp
+ * @author  Team Server
+ * @brief   Class ContentNegotiation implementation
+ */
+/*****************************************************************************/
+
+#include "Network/ContentNegotiation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+
+#include "json/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+string const ContentNegotiation::JSON_CONTENT_TYPE = "application/json";
+
+static string trim(string const &str) {
+  auto begin = str.find_first_not_of(" \t");
+  if (begin == string::npos) {
+    return "";
+  }
+  auto end = str.find_last_not_of(" \t");
+  return str.substr(begin, end - begin + 1);
+}
+
+static string toLower(string str) {
+  transform(str.begin(), str.end(), str.begin(),
+            [](unsigned char c) { return tolower(c); });
+  return str;
+}
+
+/**
+ * @brief Returns the quality (`q` parameter) of a list element, 1 if it has
+ * none.
+ */
+static double parseQuality(string const &parameters) {
+  size_t start = 0;
+  while (start < parameters.size()) {
+    auto end = parameters.find(';', start);
+    if (end == string::npos) {
+      end = parameters.size();
+    }
+    auto parameter = trim(parameters.substr(start, end - start));
+    if (parameter.size() > 2 && tolower(parameter[0]) == 'q' &&
+        parameter[1] == '=') {
+      return atof(parameter.c_str() + 2);
+    }
+    start = end + 1;
+  }
+  return 1;
+}
+
+/**
+ * @brief Returns the known value with the highest quality in a header like
+ * `Accept` or `Accept-Encoding`.
+ * @param values Known values, with lower case names.
+ */
+template <typename T>
+static T negotiate(string const &header,
+                   map<string, T> const &values,
+                   T fallback) {
+  T best = fallback;
+  double bestQuality = 0;
+
+  size_t start = 0;
+  while (start < header.size()) {
+    auto end = header.find(',', start);
+    if (end == string::npos) {
+      end = header.size();
+    }
+    auto element = header.substr(start, end - start);
+    start = end + 1;
+
+    auto paramsPos = element.find(';');
+    auto it = values.find(toLower(trim(element.substr(0, paramsPos))));
+    if (it == values.cend()) {
+      continue;
+    }
+
+    auto quality = (paramsPos == string::npos)
+                       ? 1
+                       : parseQuality(element.substr(paramsPos + 1));
+    if (quality > bestQuality) {
+      best = it->second;
+      bestQuality = quality;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Writes the events of the JSON parser into a BinaryWriter.
+ */
+class BinaryTranscoder : public json::json_sax_t {
+ public:
+  explicit BinaryTranscoder(BinaryWriter &writer) : mWriter(writer) {
+  }
+
+  bool null() override {
+    mWriter.nullValue();
+    return true;
+  }
+
+  bool boolean(bool val) override {
+    mWriter.value(val);
+    return true;
+  }
+
+  bool number_integer(number_integer_t val) override {
+    mWriter.value(val);
+    return true;
+  }
+
+  bool number_unsigned(number_unsigned_t val) override {
+    mWriter.value(val);
+    return true;
+  }
+
+  bool number_float(number_float_t val, string_t const &) override {
+    mWriter.value(val);
+    return true;
+  }
+
+  bool string(string_t &val) override {
+    mWriter.value(val);
+    return true;
+  }
+
+  bool start_object(size_t) override {
+    mWriter.beginObject();
+    return true;
+  }
+
+  bool key(string_t &val) override {
+    mWriter.key(val);
+    return true;
+  }
+
+  bool end_object() override {
+    mWriter.endObject();
+    return true;
+  }
+
+  bool start_array(size_t) override {
+    mWriter.beginArray();
+    return true;
+  }
+
+  bool end_array() override {
+    mWriter.endArray();
+    return true;
+  }
+
+  bool parse_error(size_t,
+                   std::string const &,
+                   nlohmann::detail::exception const &ex) override {
+    throw invalid_argument(ex.what());
+  }
+
+ private:
+  BinaryWriter &mWriter;
+};
+
+ResponseFormat ContentNegotiation::negotiateFormat(string const &accept) {
+  static map<string, ResponseFormat> const MEDIA_TYPES = {
+      {"application/json", ResponseFormat::Json},                //
+      {"application/*", ResponseFormat::Json},                   //
+      {"*/*", ResponseFormat::Json},                             //
+      {"application/msgpack", ResponseFormat::MessagePack},      //
+      {"application/x-msgpack", ResponseFormat::MessagePack},    //
+      {"application/vnd.msgpack", ResponseFormat::MessagePack},  //
+      {"application/cbor", ResponseFormat::Cbor}                 //
+  };
+
+  return negotiate(accept, MEDIA_TYPES, ResponseFormat::Json);
+}
+
+ContentEncoding ContentNegotiation::negotiateEncoding(
+    string const &acceptEncoding) {
+  static map<string, ContentEncoding> const CODINGS = {
+      {"gzip", ContentEncoding::Gzip},          //
+      {"x-gzip", ContentEncoding::Gzip},        //
+      {"deflate", ContentEncoding::Deflate},    //
+      {"identity", ContentEncoding::Identity},  //
+      {"*", ContentEncoding::Gzip}              //
+  };
+
+  return negotiate(acceptEncoding, CODINGS, ContentEncoding::Identity);
+}
+
+string const &ContentNegotiation::getContentType(ResponseFormat format) {
+  static string const MSGPACK_CONTENT_TYPE = "application/msgpack";
+  static string const CBOR_CONTENT_TYPE = "application/cbor";
+
+  switch (format) {
+    case ResponseFormat::MessagePack:
+      return MSGPACK_CONTENT_TYPE;
+    case ResponseFormat::Cbor:
+      return CBOR_CONTENT_TYPE;
+    case ResponseFormat::Json:
+    default:
+      return JSON_CONTENT_TYPE;
+  }
+}
+
+string const &ContentNegotiation::getEncodingName(ContentEncoding encoding) {
+  static string const GZIP = "gzip";
+  static string const DEFLATE = "deflate";
+  static string const IDENTITY = "identity";
+
+  switch (encoding) {
+    case ContentEncoding::Gzip:
+      return GZIP;
+    case ContentEncoding::Deflate:
+      return DEFLATE;
+    case ContentEncoding::Identity:
+    default:
+      return IDENTITY;
+  }
+}
+
+BinaryFormat ContentNegotiation::getBinaryFormat(ResponseFormat format) {
+  assert(format != ResponseFormat::Json);
+  return (format == ResponseFormat::Cbor) ? BinaryFormat::Cbor
+                                          : BinaryFormat::MessagePack;
+}
+
+string ContentNegotiation::encode(string const &jsonBody,
+                                  ResponseFormat format) {
+  if (format == ResponseFormat::Json) {
+    return jsonBody;
+  }
+
+  // binary encodings are smaller than JSON
+  string encoded;
+  encoded.reserve(jsonBody.size());
+  BinaryWriter writer(encoded, getBinaryFormat(format));
+  BinaryTranscoder transcoder(writer);
+  json::sax_parse(jsonBody, &transcoder);
+  return encoded;
+}
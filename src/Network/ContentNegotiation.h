@@ -0,0 +1,69 @@
+/*****************************************************************************/
+/**
+ * @file    ContentNegotiation.h
+ * @author  Team Server
+ * @brief   Class ContentNegotiation definition
+ */
+/*****************************************************************************/
+
+#ifndef _CONTENT_NEGOTIATION_H_
+#define _CONTENT_NEGOTIATION_H_
+
+#include <string>
+
+#include "Utils/BinaryWriter.h"
+#include "Utils/Compression.h"
+
+/**
+ * @brief Formats the JSON responses of the REST API can be sent in.
+ */
+enum class ResponseFormat { Json, MessagePack, Cbor };
+
+/**
+ * @brief Selects the format and the content coding of a response from the
+ * `Accept` and `Accept-Encoding` headers of the request.
+ * @details Endpoints create their responses as JSON, which is converted into
+ * the binary formats, so every format has exactly the same schema. Large
+ * responses (the queues) are written in the requested format directly.
+ */
+class ContentNegotiation {
+ public:
+  static std::string const JSON_CONTENT_TYPE;
+
+  /**
+   * @brief Returns the supported format with the highest quality in the given
+   * `Accept` header.
+   * @details JSON is used if the header is empty or contains no supported
+   * format. Formats with the same quality are preferred in the order of the
+   * header.
+   */
+  static ResponseFormat negotiateFormat(std::string const &accept);
+
+  /**
+   * @brief Returns the supported content coding with the highest quality in
+   * the given `Accept-Encoding` header.
+   * @details The response is not compressed if the header is empty or
+   * contains no supported coding. Codings with the same quality are preferred
+   * in the order of the header.
+   */
+  static ContentEncoding negotiateEncoding(std::string const &acceptEncoding);
+
+  static std::string const &getContentType(ResponseFormat format);
+
+  static std::string const &getEncodingName(ContentEncoding encoding);
+
+  /**
+   * @brief The format of a BinaryWriter writing the given binary format.
+   */
+  static BinaryFormat getBinaryFormat(ResponseFormat format);
+
+  /**
+   * @brief Converts a JSON body into the given format.
+   * @details The body is transcoded while it is parsed, without creating a
+   * JSON document first.
+   */
+  static std::string encode(std::string const &jsonBody,
+                            ResponseFormat format);
+};
+
+#endif /* _CONTENT_NEGOTIATION_H_ */
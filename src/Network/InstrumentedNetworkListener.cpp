@@ -0,0 +1,169 @@
+/*****************************************************************************/
+/**
+ * @file    InstrumentedNetworkListener.cpp
+ * @author  Team Server
+ * @brief   Class InstrumentedNetworkListener implementation
+ */
+/*****************************************************************************/
+
+#include "Network/InstrumentedNetworkListener.h"
+
+#include <chrono>
+
+using namespace std;
+
+static char const *const cEndpointNames[] = {"generateSession",
+                                             "queryTracks",
+                                             "getCurrentQueues",
+                                             "waitForChange",
+                                             "getEvents",
+                                             "getPreviousQueues",
+                                             "getQueueStatusTag",
+                                             "addTrackToQueue",
+                                             "addTracksToQueue",
+                                             "voteTrack",
+                                             "voteTracks",
+                                             "controlPlayer",
+                                             "removeTrack",
+                                             "removeTracks",
+                                             "moveTrack"};
+
+static bool isError(TResultOpt const &res) {
+  return res.has_value();
+}
+
+template <typename T>
+static bool isError(TResult<T> const &res) {
+  return holds_alternative<Error>(res);
+}
+
+template <typename TFunc>
+auto InstrumentedNetworkListener::measure(Endpoint endpoint,
+                                          TFunc const &func) {
+  auto start = chrono::steady_clock::now();
+  auto res = func();
+  auto end = chrono::steady_clock::now();
+
+  auto &metrics = Metrics::getInstance();
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  metrics.record(mMetrics[endpoint].duration, ns);
+  if (isError(res)) {
+    metrics.increment(mMetrics[endpoint].errors);
+  }
+  return res;
+}
+
+InstrumentedNetworkListener::InstrumentedNetworkListener(
+    NetworkListener *listener)
+    : mListener(listener) {
+  static_assert(size(cEndpointNames) == NrOfEndpoints,
+                "every endpoint needs a name");
+
+  auto &metrics = Metrics::getInstance();
+  for (size_t i = 0; i < NrOfEndpoints; i++) {
+    auto labels = string("endpoint=\"") + cEndpointNames[i] + "\"";
+    mMetrics[i].duration =
+        metrics.registerHistogram("jukebox_request_duration_seconds", labels);
+    mMetrics[i].errors =
+        metrics.registerCounter("jukebox_request_errors_total", labels);
+  }
+}
+
+TResult<TSessionID> InstrumentedNetworkListener::generateSession(
+    optional<TPassword> const &pw, optional<string> const &nickname) {
+  return measure(GenerateSession, [&]() {
+    return mListener->generateSession(pw, nickname);
+  });
+}
+
+TResult<vector<BaseTrack>> InstrumentedNetworkListener::queryTracks(
+    string const &searchPattern, size_t const nrOfEntries) {
+  return measure(QueryTracks, [&]() {
+    return mListener->queryTracks(searchPattern, nrOfEntries);
+  });
+}
+
+TResult<QueueStatus> InstrumentedNetworkListener::getCurrentQueues(
+    TSessionID const &sid) {
+  return measure(GetCurrentQueues,
+                 [&]() { return mListener->getCurrentQueues(sid); });
+}
+
+TResult<uint64_t> InstrumentedNetworkListener::waitForChange(
+    TSessionID const &sid, uint64_t since, chrono::milliseconds timeout) {
+  return measure(WaitForChange, [&]() {
+    return mListener->waitForChange(sid, since, timeout);
+  });
+}
+
+TResult<EventBroadcaster *> InstrumentedNetworkListener::getEvents(
+    TSessionID const &sid) {
+  return measure(GetEvents, [&]() { return mListener->getEvents(sid); });
+}
+
+TResult<TQueueSnapshot> InstrumentedNetworkListener::getPreviousQueues(
+    TSessionID const &sid, uint64_t queueVersion) {
+  return measure(GetPreviousQueues, [&]() {
+    return mListener->getPreviousQueues(sid, queueVersion);
+  });
+}
+
+TResult<QueueStatusTag> InstrumentedNetworkListener::getQueueStatusTag(
+    TSessionID const &sid) {
+  return measure(GetQueueStatusTag,
+                 [&]() { return mListener->getQueueStatusTag(sid); });
+}
+
+TResultOpt InstrumentedNetworkListener::addTrackToQueue(TSessionID const &sid,
+                                                        TTrackID const &trkid,
+                                                        QueueType type) {
+  return measure(AddTrackToQueue, [&]() {
+    return mListener->addTrackToQueue(sid, trkid, type);
+  });
+}
+
+TResult<vector<TResultOpt>> InstrumentedNetworkListener::addTracksToQueue(
+    TSessionID const &sid, vector<TTrackID> const &trkids, QueueType type) {
+  return measure(AddTracksToQueue, [&]() {
+    return mListener->addTracksToQueue(sid, trkids, type);
+  });
+}
+
+TResultOpt InstrumentedNetworkListener::voteTrack(TSessionID const &sid,
+                                                  TTrackID const &trkid,
+                                                  TVote vote) {
+  return measure(VoteTrack,
+                 [&]() { return mListener->voteTrack(sid, trkid, vote); });
+}
+
+TResultOpt InstrumentedNetworkListener::voteTracks(
+    TSessionID const &sid, vector<pair<TTrackID, TVote>> const &votes) {
+  return measure(VoteTracks,
+                 [&]() { return mListener->voteTracks(sid, votes); });
+}
+
+TResultOpt InstrumentedNetworkListener::controlPlayer(TSessionID const &sid,
+                                                      PlayerAction action) {
+  return measure(ControlPlayer,
+                 [&]() { return mListener->controlPlayer(sid, action); });
+}
+
+TResultOpt InstrumentedNetworkListener::removeTrack(TSessionID const &sid,
+                                                    TTrackID const &trkid) {
+  return measure(RemoveTrack,
+                 [&]() { return mListener->removeTrack(sid, trkid); });
+}
+
+TResult<vector<TResultOpt>> InstrumentedNetworkListener::removeTracks(
+    TSessionID const &sid, vector<TTrackID> const &trkids) {
+  return measure(RemoveTracks,
+                 [&]() { return mListener->removeTracks(sid, trkids); });
+}
+
+TResultOpt InstrumentedNetworkListener::moveTrack(TSessionID const &sid,
+                                                  TTrackID const &trkid,
+                                                  QueueType toQueue) {
+  return measure(MoveTrack, [&]() {
+    return mListener->moveTrack(sid, trkid, toQueue);
+  });
+}
@@ -0,0 +1,102 @@
+/*****************************************************************************/
+/**
+ * @file    InstrumentedNetworkListener.h
+ * @author  Team Server
+ * @brief   Class InstrumentedNetworkListener definition
+ */
+/*****************************************************************************/
+
+#ifndef _INSTRUMENTED_NETWORK_LISTENER_H_
+#define _INSTRUMENTED_NETWORK_LISTENER_H_
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "NetworkListener.h"
+#include "Utils/Metrics.h"
+
+/**
+ * @class InstrumentedNetworkListener
+ * @brief Forwards all requests to another NetworkListener and records the
+ * latency and the number of failed calls of every endpoint.
+ * @details The durations are recorded in the histogram
+ * `jukebox_request_duration_seconds`, failed calls are counted in
+ * `jukebox_request_errors_total`, both labeled with the endpoint.
+ * @sa Metrics
+ */
+class InstrumentedNetworkListener final : public NetworkListener {
+ public:
+  /**
+   * @param listener Listener handling the requests, not owned.
+   */
+  explicit InstrumentedNetworkListener(NetworkListener *listener);
+
+  TResult<TSessionID> generateSession(
+      std::optional<TPassword> const &pw,
+      std::optional<std::string> const &nickname) override;
+  TResult<std::vector<BaseTrack>> queryTracks(
+      std::string const &searchPattern, size_t const nrOfEntries) override;
+  TResult<QueueStatus> getCurrentQueues(TSessionID const &sid) override;
+  TResult<uint64_t> waitForChange(TSessionID const &sid,
+                                  uint64_t since,
+                                  std::chrono::milliseconds timeout) override;
+  TResult<EventBroadcaster *> getEvents(TSessionID const &sid) override;
+  TResult<TQueueSnapshot> getPreviousQueues(TSessionID const &sid,
+                                            uint64_t queueVersion) override;
+  TResult<QueueStatusTag> getQueueStatusTag(TSessionID const &sid) override;
+  TResultOpt addTrackToQueue(TSessionID const &sid,
+                             TTrackID const &trkid,
+                             QueueType type) override;
+  TResult<std::vector<TResultOpt>> addTracksToQueue(
+      TSessionID const &sid,
+      std::vector<TTrackID> const &trkids,
+      QueueType type) override;
+  TResultOpt voteTrack(TSessionID const &sid,
+                       TTrackID const &trkid,
+                       TVote vote) override;
+  TResultOpt voteTracks(
+      TSessionID const &sid,
+      std::vector<std::pair<TTrackID, TVote>> const &votes) override;
+  TResultOpt controlPlayer(TSessionID const &sid, PlayerAction action) override;
+  TResultOpt removeTrack(TSessionID const &sid, TTrackID const &trkid) override;
+  TResult<std::vector<TResultOpt>> removeTracks(
+      TSessionID const &sid, std::vector<TTrackID> const &trkids) override;
+  TResultOpt moveTrack(TSessionID const &sid,
+                       TTrackID const &trkid,
+                       QueueType toQueue) override;
+
+ private:
+  enum Endpoint {
+    GenerateSession,
+    QueryTracks,
+    GetCurrentQueues,
+    WaitForChange,
+    GetEvents,
+    GetPreviousQueues,
+    GetQueueStatusTag,
+    AddTrackToQueue,
+    AddTracksToQueue,
+    VoteTrack,
+    VoteTracks,
+    ControlPlayer,
+    RemoveTrack,
+    RemoveTracks,
+    MoveTrack,
+    NrOfEndpoints
+  };
+
+  struct EndpointMetrics {
+    Metrics::TMetricID duration;
+    Metrics::TMetricID errors;
+  };
+
+  template <typename TFunc>
+  auto measure(Endpoint endpoint, TFunc const &func);
+
+  NetworkListener *mListener;
+  std::array<EndpointMetrics, NrOfEndpoints> mMetrics;
+};
+
+#endif /* _INSTRUMENTED_NETWORK_LISTENER_H_ */
@@ -0,0 +1,166 @@
+/*****************************************************************************/
+/**
+ * @file    QueueBodyCache.cpp
+ * @author  Team Server
+ * @brief   Class QueueBodyCache implementation
+ */
+/*****************************************************************************/
+
+#include "Network/QueueBodyCache.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Utils/Serializer.h"
+
+using namespace std;
+
+QueueBodyCache::Entry::Entry(QueueStatus const &status, ResponseFormat format)
+    : mQueueVersion(status.queueVersion), mFormat(format) {
+  if (format == ResponseFormat::Json) {
+    serialize(status, [](string &out) { return JsonWriter(out); });
+  } else {
+    auto binaryFormat = ContentNegotiation::getBinaryFormat(format);
+    serialize(status,
+              [=](string &out) { return BinaryWriter(out, binaryFormat); });
+  }
+}
+
+template <typename MakeWriter>
+void QueueBodyCache::Entry::serialize(QueueStatus const &status,
+                                      MakeWriter makeWriter) {
+  auto const &tracks = status.normalQueue.tracks;
+  auto writer = makeWriter(mNormalQueue);
+  writer.beginArray(tracks.size());
+  mVoteOffsets.reserve(tracks.size());
+  string voted;
+  for (size_t i = 0; i < tracks.size(); i++) {
+    auto track = tracks[i];
+    track.userHasVoted = false;
+    Serializer::serialize(track, writer);
+
+    // only the value of `current_vote` differs if the user voted for the
+    // track, independent of the format and of the content of the strings
+    track.userHasVoted = true;
+    voted.clear();
+    auto votedWriter = makeWriter(voted);
+    Serializer::serialize(track, votedWriter);
+    // the writer may have separated the track from the previous one
+    auto trackStart = mNormalQueue.size() - voted.size();
+    auto diff = mismatch(voted.cbegin(), voted.cend(),
+                         mNormalQueue.cbegin() + trackStart);
+    assert(diff.first != voted.cend());
+    mVoteOffsets.push_back(diff.second - mNormalQueue.cbegin());
+    mVotedValue = *diff.first;
+
+    if (i % cTracksPerSegment == 0) {
+      mSegmentRanges.emplace_back(trackStart, trackStart);
+      mNormalSegments.push_back(make_shared<CachedSegment const>());
+    }
+    mSegmentRanges.back().second = mNormalQueue.size();
+  }
+  writer.endArray();
+
+  auto adminWriter = makeWriter(mAdminQueue);
+  Serializer::serialize(status.adminQueue, adminWriter);
+  mAdminSegment = make_shared<CachedSegment const>();
+}
+
+template <typename Writer>
+void QueueBodyCache::Entry::appendNormalQueue(
+    Queue const &queue,
+    Writer &writer,
+    vector<BodySegment> *segments) const {
+  assert(queue.tracks.size() == mVoteOffsets.size());
+
+  auto &out = writer.getOutput();
+  writer.raw(mNormalQueue);
+  auto start = out.size() - mNormalQueue.size();
+  for (size_t i = 0; i < mVoteOffsets.size(); i++) {
+    if (queue.tracks[i].userHasVoted) {
+      out[start + mVoteOffsets[i]] = mVotedValue;
+    }
+  }
+
+  if (!segments) {
+    return;
+  }
+  // patched segments differ from the cached ones
+  for (size_t s = 0; s < mNormalSegments.size(); s++) {
+    auto first = queue.tracks.cbegin() + s * cTracksPerSegment;
+    auto last = queue.tracks.cbegin() +
+                min(queue.tracks.size(), (s + 1) * cTracksPerSegment);
+    if (any_of(first, last, [](auto &&t) { return t.userHasVoted; })) {
+      continue;
+    }
+    auto const &range = mSegmentRanges[s];
+    segments->push_back(
+        {start + range.first, range.second - range.first, mNormalSegments[s]});
+  }
+}
+
+template <typename Writer>
+void QueueBodyCache::Entry::appendAdminQueue(
+    Writer &writer,
+    vector<BodySegment> *segments) const {
+  writer.raw(mAdminQueue);
+  if (segments) {
+    auto start = writer.getOutput().size() - mAdminQueue.size();
+    segments->push_back({start, mAdminQueue.size(), mAdminSegment});
+  }
+}
+
+template void QueueBodyCache::Entry::appendNormalQueue(
+    Queue const &queue,
+    JsonWriter &writer,
+    vector<BodySegment> *segments) const;
+template void QueueBodyCache::Entry::appendNormalQueue(
+    Queue const &queue,
+    BinaryWriter &writer,
+    vector<BodySegment> *segments) const;
+template void QueueBodyCache::Entry::appendAdminQueue(
+    JsonWriter &writer,
+    vector<BodySegment> *segments) const;
+template void QueueBodyCache::Entry::appendAdminQueue(
+    BinaryWriter &writer,
+    vector<BodySegment> *segments) const;
+
+string const &QueueBodyCache::Entry::getAdminQueue() const {
+  return mAdminQueue;
+}
+
+uint64_t QueueBodyCache::Entry::getQueueVersion() const {
+  return mQueueVersion;
+}
+
+ResponseFormat QueueBodyCache::Entry::getFormat() const {
+  return mFormat;
+}
+
+size_t QueueBodyCache::Entry::getSize() const {
+  return mNormalQueue.size() + mAdminQueue.size();
+}
+
+QueueBodyCache::TEntry QueueBodyCache::get(QueueStatus const &status,
+                                          ResponseFormat format) {
+  if (status.queueVersion == 0) {
+    return make_shared<Entry const>(status, format);
+  }
+
+  auto &cached = mEntries[static_cast<size_t>(format)];
+  {
+    lock_guard<mutex> lock(mMutex);
+    if (cached && cached->getQueueVersion() == status.queueVersion) {
+      return cached;
+    }
+  }
+
+  // serialize without holding the lock, concurrent requests of a new version
+  // may serialize it twice
+  auto entry = make_shared<Entry const>(status, format);
+  lock_guard<mutex> lock(mMutex);
+  if (!cached || cached->getQueueVersion() < entry->getQueueVersion()) {
+    cached = entry;
+  }
+  return entry;
+}
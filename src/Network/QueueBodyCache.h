@@ -0,0 +1,115 @@
+/*****************************************************************************/
+/**
+ * @file    QueueBodyCache.h
+ * @author  Team Server
+ * @brief   Class QueueBodyCache definition
+ */
+/*****************************************************************************/
+
+#ifndef _QUEUE_BODY_CACHE_H_
+#define _QUEUE_BODY_CACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Network/ContentNegotiation.h"
+#include "Types/Queue.h"
+#include "Utils/Compression.h"
+
+/**
+ * @brief Caches the serialized queues of the current queue version in every
+ * response format, so they are shared between the responses to all users.
+ * @details The queues only differ between users in the field `current_vote`,
+ * which is serialized as `0` and patched in place for every response.
+ *
+ * The queues are also compressed in segments of up to cTracksPerSegment
+ * tracks, which are shared between all compressed responses. Only the
+ * segments containing votes of the user have to be compressed again.
+ */
+class QueueBodyCache {
+ public:
+  /**
+   * @brief Serialized queues of a single version in a single format.
+   */
+  class Entry {
+   public:
+    Entry(QueueStatus const &status, ResponseFormat format);
+
+    /**
+     * @brief Appends the normal queue as array, with the field `current_vote`
+     * set from the given queue.
+     * @param queue The normal queue of the entry's version.
+     * @param writer JsonWriter or BinaryWriter of the entry's format.
+     * @param segments If set, the cached compressed segments of the written
+     * data are added.
+     */
+    template <typename Writer>
+    void appendNormalQueue(Queue const &queue,
+                           Writer &writer,
+                           std::vector<BodySegment> *segments = nullptr) const;
+
+    /**
+     * @brief Appends the admin queue as array.
+     * @param writer JsonWriter or BinaryWriter of the entry's format.
+     * @param segments If set, the cached compressed segment of the written
+     * data is added.
+     */
+    template <typename Writer>
+    void appendAdminQueue(Writer &writer,
+                          std::vector<BodySegment> *segments = nullptr) const;
+
+    /**
+     * @brief The admin queue as array in the entry's format.
+     */
+    std::string const &getAdminQueue() const;
+
+    uint64_t getQueueVersion() const;
+
+    ResponseFormat getFormat() const;
+
+    /**
+     * @brief Number of bytes of both serialized queues.
+     */
+    size_t getSize() const;
+
+    static constexpr size_t cTracksPerSegment = 32;
+
+   private:
+    template <typename MakeWriter>
+    void serialize(QueueStatus const &status, MakeWriter makeWriter);
+
+    uint64_t mQueueVersion;
+    ResponseFormat mFormat;
+    std::string mNormalQueue;
+    // position of the value of `current_vote` of every track in mNormalQueue
+    std::vector<size_t> mVoteOffsets;
+    // serialized value of `current_vote` if the user voted for the track
+    char mVotedValue = 0;
+    // range of the tracks of every segment in mNormalQueue, without commas
+    std::vector<std::pair<size_t, size_t>> mSegmentRanges;
+    std::vector<std::shared_ptr<CachedSegment const>> mNormalSegments;
+    std::string mAdminQueue;
+    std::shared_ptr<CachedSegment const> mAdminSegment;
+  };
+
+  using TEntry = std::shared_ptr<Entry const>;
+
+  /**
+   * @brief Returns the serialized queues of the given status.
+   * @details The queues are only serialized if their version has not been
+   * cached in the format yet. Unknown versions (0) are never cached.
+   */
+  TEntry get(QueueStatus const &status,
+             ResponseFormat format = ResponseFormat::Json);
+
+ private:
+  std::mutex mMutex;
+  // indexed by ResponseFormat
+  std::array<TEntry, 3> mEntries;
+};
+
+#endif /* _QUEUE_BODY_CACHE_H_ */
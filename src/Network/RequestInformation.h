@@ -11,7 +11,14 @@
 
 #include <httpserver.hpp>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "Network/ContentNegotiation.h"
+#include "Utils/Compression.h"
+#include "Utils/ConcurrencyLimit.h"
+#include "Utils/EventBroadcaster.h"
 
 /**
  * @brief Wraps all relevant pieces of information provided by a HTTP request.
@@ -21,6 +28,23 @@ struct RequestInformation {
   std::string method;
   std::string body;
   std::map<std::string, std::string, httpserver::http::arg_comparator> args;
+  // format requested by the client, handlers may write their body in it
+  ResponseFormat format = ResponseFormat::Json;
+};
+
+/**
+ * @brief Subscription of a client to the events of an EventBroadcaster.
+ */
+struct EventSubscription {
+  EventBroadcaster *events;
+  // position of the next event to send
+  uint64_t position;
+  // event which is currently sent, the first one is the state of the
+  // broadcaster at the time of subscribing
+  EventBroadcaster::TEvent current;
+  size_t offset = 0;
+  // held until the stream is closed
+  ConcurrencyLimit::TSlot slot = nullptr;
 };
 
 /**
@@ -29,6 +53,12 @@ struct RequestInformation {
 struct ResponseInformation {
   std::string body;
   int code = 200;
+  // JSON bodies are converted to the format requested by the client
+  std::string contentType = "application/json";
+  // ranges of the body which have already been compressed
+  std::vector<BodySegment> segments = {};
+  // if set, the events are streamed instead of sending the body
+  std::shared_ptr<EventSubscription> subscription = nullptr;
 };
 
 #endif  // _REQUEST_INFORMATION_H_
@@ -18,6 +18,25 @@ using namespace httpserver;
 
 static string const CONFIG_SECTION = "RestAPI";
 
+/**
+ * @brief Reads an optional, positive limit from the configuration.
+ */
+static TResult<size_t> getConfigLimit(string const &key, size_t defaultValue) {
+  auto value = ConfigHandler::getInstance()->getValueInt(CONFIG_SECTION, key);
+  if (holds_alternative<Error>(value)) {
+    if (get<Error>(value).getErrorCode() == ErrorCode::KeyNotFound) {
+      return defaultValue;
+    }
+    return get<Error>(value);
+  }
+
+  if (get<int>(value) < 1) {
+    return Error(ErrorCode::InvalidValue,
+                 "RestAPI.handleRequests: " + key + " must be positive");
+  }
+  return static_cast<size_t>(get<int>(value));
+}
+
 TResultOpt RestAPI::handleRequests() {
   auto configHandler = ConfigHandler::getInstance();
 
@@ -33,6 +52,17 @@ TResultOpt RestAPI::handleRequests() {
                  "RestAPI.handleRequests: Port value is out of range");
   }
 
+  auto maxEventStreams = getConfigLimit(
+      "maxEventStreams", RestRequestHandler::cDefaultMaxEventStreams);
+  if (holds_alternative<Error>(maxEventStreams)) {
+    return get<Error>(maxEventStreams);
+  }
+  auto maxLongPolls = getConfigLimit(
+      "maxLongPolls", RestRequestHandler::cDefaultMaxLongPolls);
+  if (holds_alternative<Error>(maxLongPolls)) {
+    return get<Error>(maxLongPolls);
+  }
+
   auto webserverParams =
       create_webserver(port)
           .not_found_resource(RestRequestHandler::NotFoundHandler)
@@ -47,7 +77,8 @@ TResultOpt RestAPI::handleRequests() {
   ws = make_unique<webserver>(webserverParams);
 
   // use a single handler sensitive on all paths
-  RestRequestHandler handler(listener);
+  RestRequestHandler handler(listener, get<size_t>(maxEventStreams),
+                             get<size_t>(maxLongPolls));
   ws->register_resource("/", &handler, true);
 
   // run the webserver in blocking mode
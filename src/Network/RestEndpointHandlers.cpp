@@ -8,14 +8,31 @@
 
 #include "RestEndpointHandlers.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
 #include <iostream>
+#include <sstream>
 
+#include "Network/QueueBodyCache.h"
+#include "Utils/BinaryWriter.h"
+#include "Utils/JsonWriter.h"
+#include "Utils/Metrics.h"
+#include "Utils/QueueDiff.h"
 #include "Utils/Serializer.h"
 #include "json/json.hpp"
 
 using namespace std;
 using json = nlohmann::json;
 
+// maximum time a request for the current queues waits for changes
+static chrono::seconds const LONG_POLL_TIMEOUT(30);
+// serialized queues shared between the responses to all users
+static QueueBodyCache QUEUE_BODY_CACHE;
+// response body of all requests which only succeed or fail
+static string const EMPTY_OBJECT = "{}";
+
 //
 // Helper functions
 //
@@ -29,7 +46,7 @@ static TResult<json const> parseJsonString(string const &str) {
   }
 }
 
-static ResponseInformation const mapErrorToResponse(Error const &err) {
+static int mapErrorToStatusCode(Error const &err) {
   static const map<ErrorCode, int> ERROR_TO_HTTP_STATUS = {
       {ErrorCode::WrongPassword, 401},        //
       {ErrorCode::AccessDenied, 403},         //
@@ -49,29 +66,155 @@ static ResponseInformation const mapErrorToResponse(Error const &err) {
       {ErrorCode::SpotifyHttpTimeout, 400},   //
       {ErrorCode::SpotifyNoDevice, 404},      //
       {ErrorCode::AlreadyExists, 400},        //
-      {ErrorCode::DoesntExist, 400}           //
+      {ErrorCode::DoesntExist, 400},          //
+      {ErrorCode::ServiceUnavailable, 503}    //
   };
 
-  int statusCode;
-
   // map internal error codes to HTTP status codes
   // unhandled ErrorCodes trigger an internal server error
   auto errorCode = err.getErrorCode();
   auto statusCodeIt = ERROR_TO_HTTP_STATUS.find(errorCode);
   if (statusCodeIt == ERROR_TO_HTTP_STATUS.cend()) {
-    statusCode = 500;
-  } else {
-    statusCode = statusCodeIt->second;
+    return 500;
   }
+  return statusCodeIt->second;
+}
+
+ResponseInformation const mapErrorToResponse(Error const &err) {
+  int statusCode = mapErrorToStatusCode(err);
 
   VLOG(2) << "Request lead to error: " << err.getErrorMessage();
 
   // construct response
-  json responseBody = {
-      {"status", statusCode},           //
-      {"error", err.getErrorMessage()}  //
-  };
-  return {responseBody.dump(), statusCode};
+  string responseBody;
+  JsonWriter writer(responseBody);
+  writer.beginObject()
+      .key("error")
+      .value(err.getErrorMessage())
+      .key("status")
+      .value(statusCode)
+      .endObject();
+  return {responseBody, statusCode};
+}
+
+static TResultOpt parseTrackIds(json const &body, vector<TTrackID> &trkids) {
+  if (body.find("track_ids") == body.cend()) {
+    return Error(ErrorCode::InvalidFormat, "Field 'track_ids' not found");
+  }
+  auto const &trackIds = body["track_ids"];
+  if (!trackIds.is_array()) {
+    return Error(ErrorCode::InvalidFormat,
+                 "Value of 'track_ids' must be an array");
+  }
+  trkids.reserve(trackIds.size());
+  for (auto const &trackId : trackIds) {
+    if (!trackId.is_string()) {
+      return Error(ErrorCode::InvalidFormat,
+                   "Values of 'track_ids' must be strings");
+    }
+    trkids.push_back(trackId.get<string>());
+  }
+  return nullopt;
+}
+
+static string serializeBatchResults(vector<TTrackID> const &trkids,
+                                    vector<TResultOpt> const &results) {
+  string responseBody;
+  JsonWriter writer(responseBody);
+  writer.beginObject().key("results").beginArray();
+  for (size_t i = 0; i < trkids.size() && i < results.size(); ++i) {
+    writer.beginObject();
+    if (results[i].has_value()) {
+      writer.key("error").value(results[i]->getErrorMessage());
+      writer.key("status").value(mapErrorToStatusCode(results[i].value()));
+    } else {
+      writer.key("status").value(200);
+    }
+    writer.key("track_id").value(trkids[i]);
+    writer.endObject();
+  }
+  writer.endArray().endObject();
+  return responseBody;
+}
+
+/**
+ * @brief Serializes only the changes of the queues since `base`.
+ * @details The votes of the user are sent as a separate list of track IDs, the
+ * currently playing track only contains its playback status if it did not
+ * change.
+ * @return `nullopt` if most of the tracks changed anyway.
+ */
+static optional<string> serializeQueueDelta(QueueStatus const &status,
+                                            QueueSnapshot const &base) {
+  auto normalOps = QueueDiff::operations(base.normalQueue, status.normalQueue);
+  auto adminOps = QueueDiff::operations(base.adminQueue, status.adminQueue);
+  auto nrOfTracks =
+      status.normalQueue.tracks.size() + status.adminQueue.tracks.size();
+  if (normalOps.size() + adminOps.size() > nrOfTracks / 2) {
+    return nullopt;
+  }
+
+  string responseBody;
+  JsonWriter writer(responseBody);
+  writer.beginObject();
+  writer.key("admin_queue");
+  QueueDiff::write(adminOps, writer);
+  writer.key("base_version").value(base.version);
+
+  writer.key("current_votes").beginArray();
+  for (auto &&track : status.normalQueue.tracks) {
+    if (track.userHasVoted) {
+      writer.value(track.trackId);
+    }
+  }
+  writer.endArray();
+
+  writer.key("currently_playing");
+  if (!status.currentTrack.has_value()) {
+    writer.beginObject().endObject();
+  } else if (base.currentTrack.has_value() &&
+             base.currentTrack->trackId == status.currentTrack->trackId) {
+    writer.beginObject()
+        .key("playing")
+        .value(status.currentTrack->isPlaying)
+        .key("playing_for")
+        .value(status.currentTrack->progressMs)
+        .endObject();
+  } else {
+    Serializer::serialize(status.currentTrack.value(), writer);
+  }
+
+  writer.key("normal_queue");
+  QueueDiff::write(normalOps, writer);
+  writer.key("queue_version").value(status.queueVersion);
+  writer.key("version").value(status.version);
+  writer.endObject();
+  return responseBody;
+}
+
+/**
+ * @brief Writes the current queues from the cached queues of their version.
+ * @param queues Cached queues in the format of the writer.
+ */
+template <typename Writer>
+static void writeCurrentQueues(QueueStatus const &status,
+                               QueueBodyCache::Entry const &queues,
+                               Writer &writer,
+                               vector<BodySegment> &segments) {
+  writer.beginObject();
+  writer.key("admin_queue");
+  queues.appendAdminQueue(writer, &segments);
+  writer.key("currently_playing");
+  if (status.currentTrack.has_value()) {
+    Serializer::serialize(status.currentTrack.value(), writer);
+  } else {
+    writer.beginObject().endObject();
+  }
+  writer.key("normal_queue");
+  queues.appendNormalQueue(status.normalQueue, writer, &segments);
+  writer.key("queue_version").value(status.queueVersion);
+  writer.key("version").value(status.version);
+  writer.endObject();
 }
 
 //
@@ -140,6 +283,28 @@ static ResponseInformation const mapErrorToResponse(Error const &err) {
     }                                                                          \
   } while (0)
 
+#define PARSE_OPTIONAL_UINT64_PARAMETER(name, args)                          \
+  do {                                                                       \
+    if (args.find(#name) != args.cend()) {                                   \
+      auto paramStr = args.at(#name);                                        \
+      uint64_t tmpValue = 0;                                                 \
+      size_t idx = 0;                                                        \
+      try {                                                                  \
+        if (!paramStr.empty() && paramStr[0] >= '0' && paramStr[0] <= '9') { \
+          tmpValue = stoull(paramStr, &idx);                                 \
+        }                                                                    \
+      } catch (out_of_range const &) {                                       \
+        idx = 0;                                                             \
+      }                                                                      \
+      if (idx == 0 || idx != paramStr.size()) {                              \
+        return mapErrorToResponse(Error(ErrorCode::InvalidFormat,            \
+                                        "Parameter '" #name                  \
+                                        "' is not an unsigned integer"));    \
+      }                                                                      \
+      name = tmpValue;                                                       \
+    }                                                                        \
+  } while (0)
+
 #define PARSE_REQUIRED_STRING_PARAMETER(name, args)                            \
   do {                                                                         \
     if (args.find(#name) == args.cend()) {                                     \
@@ -178,10 +343,13 @@ ResponseInformation const generateSessionHandler(
 
   // construct the response
   auto sessionId = get<TSessionID>(result);
-  json responseBody = {
-      {"session_id", static_cast<string>(sessionId)}  //
-  };
-  return {responseBody.dump()};
+  string responseBody;
+  JsonWriter writer(responseBody);
+  writer.beginObject()
+      .key("session_id")
+      .value(static_cast<string>(sessionId))
+      .endObject();
+  return {responseBody};
 }
 
 //
@@ -208,13 +376,15 @@ ResponseInformation const queryTracksHandler(NetworkListener *listener,
   // construct the response
   auto queriedTracks = get<vector<BaseTrack>>(result);
 
-  json jsonTracks = json::array();
+  string responseBody;
+  responseBody.reserve(queriedTracks.size() * 256 + 16);
+  JsonWriter writer(responseBody);
+  writer.beginObject().key("tracks").beginArray();
   for (auto &&track : queriedTracks) {
-    jsonTracks.push_back(Serializer::serialize(track));
+    Serializer::serialize(track, writer);
   }
-
-  json responseBody = {{"tracks", jsonTracks}};
-  return {responseBody.dump()};
+  writer.endArray().endObject();
+  return {responseBody};
 }
 
 //
@@ -227,7 +397,20 @@ ResponseInformation const getCurrentQueuesHandler(
 
   // parse request parameters
   TSessionID session_id;
+  optional<uint64_t> since;
+  optional<uint64_t> queue_version;
   PARSE_REQUIRED_STRING_PARAMETER(session_id, infos.args);
+  PARSE_OPTIONAL_UINT64_PARAMETER(since, infos.args);
+  PARSE_OPTIONAL_UINT64_PARAMETER(queue_version, infos.args);
+
+  // wait until the client's version is outdated (long polling)
+  if (since.has_value()) {
+    auto waitResult =
+        listener->waitForChange(session_id, since.value(), LONG_POLL_TIMEOUT);
+    if (holds_alternative<Error>(waitResult)) {
+      return mapErrorToResponse(get<Error>(waitResult));
+    }
+  }
 
   // notify the listener about the request
   auto result = listener->getCurrentQueues(session_id);
@@ -238,23 +421,81 @@ ResponseInformation const getCurrentQueuesHandler(
   // construct the response
   auto queueStatus = get<QueueStatus>(result);
 
-  json playbackTrack = json::object();
-  json normalQueue = json::array();
-  json adminQueue = json::array();
-  if (queueStatus.currentTrack.has_value()) {
-    playbackTrack = Serializer::serialize(queueStatus.currentTrack.value());
+  // only send the changes if the client's queues are still known
+  if (queue_version.has_value()) {
+    auto baseResult =
+        listener->getPreviousQueues(session_id, queue_version.value());
+    if (holds_alternative<TQueueSnapshot>(baseResult)) {
+      auto delta =
+          serializeQueueDelta(queueStatus, *get<TQueueSnapshot>(baseResult));
+      if (delta.has_value()) {
+        return {delta.value()};
+      }
+    }
+  }
+
+  // the queues are serialized once per version and format and shared between
+  // all users
+  auto queues = QUEUE_BODY_CACHE.get(queueStatus, infos.format);
+  ResponseInformation response;
+  response.contentType = ContentNegotiation::getContentType(infos.format);
+  response.body.reserve(queues->getSize() + 512);
+  if (infos.format == ResponseFormat::Json) {
+    JsonWriter writer(response.body);
+    writeCurrentQueues(queueStatus, *queues, writer, response.segments);
+  } else {
+    BinaryWriter writer(response.body,
+                        ContentNegotiation::getBinaryFormat(infos.format));
+    writeCurrentQueues(queueStatus, *queues, writer, response.segments);
+  }
+  return response;
+}
+
+bool getCurrentQueuesLongPoll(RequestInformation const &infos) {
+  return infos.args.find("since") != infos.args.cend();
+}
+
+optional<string> getCurrentQueuesETag(NetworkListener *listener,
+                                      RequestInformation const &infos) {
+  assert(listener);
+
+  // long polling requests wait for a newer version instead
+  if (getCurrentQueuesLongPoll(infos)) {
+    return nullopt;
   }
-  for (auto &&track : queueStatus.normalQueue.tracks) {
-    normalQueue.push_back(Serializer::serialize(track));
+  auto sessionIt = infos.args.find("session_id");
+  if (sessionIt == infos.args.cend()) {
+    return nullopt;
   }
-  for (auto &&track : queueStatus.adminQueue.tracks) {
-    adminQueue.push_back(Serializer::serialize(track));
+
+  // the changes depend on the client's version as well, invalid versions are
+  // reported by the handler
+  string queueVersion;
+  auto queueVersionIt = infos.args.find("queue_version");
+  if (queueVersionIt != infos.args.cend()) {
+    queueVersion = queueVersionIt->second;
+    if (queueVersion.empty() ||
+        !all_of(queueVersion.cbegin(), queueVersion.cend(), ::isdigit)) {
+      return nullopt;
+    }
   }
 
-  json responseBody = {{"currently_playing", playbackTrack},
-                       {"normal_queue", normalQueue},
-                       {"admin_queue", adminQueue}};
-  return {responseBody.dump()};
+  // errors are reported by the handler as well
+  auto result = listener->getQueueStatusTag(sessionIt->second);
+  if (holds_alternative<Error>(result)) {
+    return nullopt;
+  }
+  auto tag = get<QueueStatusTag>(result);
+
+  // weak, since the progress of the playback is not part of the version
+  stringstream etag;
+  etag << "W/\"" << hex << tag.epoch << '-' << dec << tag.version << '-' << hex
+       << tag.votesHash;
+  if (!queueVersion.empty()) {
+    etag << '-' << queueVersion;
+  }
+  etag << '"';
+  return etag.str();
 }
 
 //
@@ -301,8 +542,7 @@ ResponseInformation const addTrackToQueueHandler(
   }
 
   // construct the response
-  json responseBody = json::object();
-  return {responseBody.dump()};
+  return {EMPTY_OBJECT};
 }
 
 //
@@ -335,8 +575,7 @@ ResponseInformation const voteTrackHandler(NetworkListener *listener,
   }
 
   // construct the response
-  json responseBody = json::object();
-  return {responseBody.dump()};
+  return {EMPTY_OBJECT};
 }
 
 //
@@ -387,8 +626,7 @@ ResponseInformation const controlPlayerHandler(
   }
 
   // construct the response
-  json responseBody = json::object();
-  return {responseBody.dump()};
+  return {EMPTY_OBJECT};
 }
 
 //
@@ -438,8 +676,7 @@ ResponseInformation const moveTracksHandler(NetworkListener *listener,
   }
 
   // construct the response
-  json responseBody = json::object();
-  return {responseBody.dump()};
+  return {EMPTY_OBJECT};
 }
 
 //
@@ -473,6 +710,190 @@ ResponseInformation const removeTrackHandler(NetworkListener *listener,
   }
 
   // construct the response
-  json responseBody = json::object();
-  return {responseBody.dump()};
+  return {EMPTY_OBJECT};
+}
+
+//
+// ADD TRACKS TO QUEUE
+//
+
+ResponseInformation const addTracksToQueueHandler(
+    NetworkListener *listener, RequestInformation const &infos) {
+  assert(listener);
+
+  auto parseResult = parseJsonString(infos.body);
+  if (holds_alternative<Error>(parseResult)) {
+    return mapErrorToResponse(get<Error>(parseResult));
+  }
+  json const bodyJson = get<json const>(parseResult);
+
+  // parse request specific JSON fields
+  TSessionID session_id;
+  vector<TTrackID> track_ids;
+  optional<string> queue_type;
+
+  PARSE_REQUIRED_STRING_FIELD(session_id, bodyJson);
+  PARSE_OPTIONAL_STRING_FIELD(queue_type, bodyJson);
+  auto parseIds = parseTrackIds(bodyJson, track_ids);
+  if (parseIds.has_value()) {
+    return mapErrorToResponse(parseIds.value());
+  }
+
+  QueueType queueType = QueueType::Normal;
+  if (queue_type.has_value()) {
+    if (queue_type.value() == "admin") {
+      queueType = QueueType::Admin;
+    } else if (queue_type.value() == "normal") {
+      queueType = QueueType::Normal;
+    } else {
+      return mapErrorToResponse(
+          Error(ErrorCode::InvalidFormat,
+                "Value of 'queue_type' must either be 'admin' or 'normal'"));
+    }
+  }
+
+  // notify the listener about the request
+  auto result = listener->addTracksToQueue(session_id, track_ids, queueType);
+  if (holds_alternative<Error>(result)) {
+    return mapErrorToResponse(get<Error>(result));
+  }
+
+  // construct the response
+  return {serializeBatchResults(track_ids, get<vector<TResultOpt>>(result))};
+}
+
+//
+// VOTE TRACKS
+//
+
+ResponseInformation const voteTracksHandler(NetworkListener *listener,
+                                            RequestInformation const &infos) {
+  assert(listener);
+
+  auto parseResult = parseJsonString(infos.body);
+  if (holds_alternative<Error>(parseResult)) {
+    return mapErrorToResponse(get<Error>(parseResult));
+  }
+  json const bodyJson = get<json const>(parseResult);
+
+  // parse request specific JSON fields
+  TSessionID session_id;
+  PARSE_REQUIRED_STRING_FIELD(session_id, bodyJson);
+
+  if (bodyJson.find("votes") == bodyJson.cend()) {
+    return mapErrorToResponse(
+        Error(ErrorCode::InvalidFormat, "Field 'votes' not found"));
+  }
+  if (!bodyJson["votes"].is_array()) {
+    return mapErrorToResponse(
+        Error(ErrorCode::InvalidFormat, "Value of 'votes' must be an array"));
+  }
+
+  vector<pair<TTrackID, TVote>> votes;
+  votes.reserve(bodyJson["votes"].size());
+  for (auto const &voteJson : bodyJson["votes"]) {
+    if (!voteJson.is_object()) {
+      return mapErrorToResponse(Error(ErrorCode::InvalidFormat,
+                                      "Values of 'votes' must be objects"));
+    }
+    TTrackID track_id;
+    int vote;
+    PARSE_REQUIRED_STRING_FIELD(track_id, voteJson);
+    PARSE_REQUIRED_INT_FIELD(vote, voteJson);
+    votes.emplace_back(track_id, (vote != 0));
+  }
+
+  // notify the listener about the request
+  TResultOpt result = listener->voteTracks(session_id, votes);
+  if (result.has_value()) {
+    return mapErrorToResponse(result.value());
+  }
+
+  // construct the response
+  return {EMPTY_OBJECT};
+}
+
+//
+// REMOVE TRACKS
+//
+
+ResponseInformation const removeTracksHandler(NetworkListener *listener,
+                                              RequestInformation const &infos) {
+  assert(listener);
+
+  auto parseResult = parseJsonString(infos.body);
+  if (holds_alternative<Error>(parseResult)) {
+    return mapErrorToResponse(get<Error>(parseResult));
+  }
+  json const bodyJson = get<json const>(parseResult);
+
+  // parse request specific JSON fields
+  TSessionID session_id;
+  vector<TTrackID> track_ids;
+
+  PARSE_REQUIRED_STRING_FIELD(session_id, bodyJson);
+  auto parseIds = parseTrackIds(bodyJson, track_ids);
+  if (parseIds.has_value()) {
+    return mapErrorToResponse(parseIds.value());
+  }
+
+  // notify the listener about the request
+  auto result = listener->removeTracks(session_id, track_ids);
+  if (holds_alternative<Error>(result)) {
+    return mapErrorToResponse(get<Error>(result));
+  }
+
+  // construct the response
+  return {serializeBatchResults(track_ids, get<vector<TResultOpt>>(result))};
+}
+
+//
+// EVENTS
+//
+
+ResponseInformation const eventsHandler(NetworkListener *listener,
+                                        RequestInformation const &infos) {
+  assert(listener);
+
+  // parse request parameters
+  TSessionID session_id;
+  PARSE_REQUIRED_STRING_PARAMETER(session_id, infos.args);
+
+  // notify the listener about the request
+  auto result = listener->getEvents(session_id);
+  if (holds_alternative<Error>(result)) {
+    return mapErrorToResponse(get<Error>(result));
+  }
+
+  // the stream starts with the current state, followed by all events
+  // published afterwards
+  auto subscription = make_shared<EventSubscription>();
+  subscription->events = get<EventBroadcaster *>(result);
+  subscription->current =
+      subscription->events->subscribe(subscription->position);
+
+  ResponseInformation response;
+  response.subscription = subscription;
+  return response;
+}
+
+//
+// METRICS
+//
+
+ResponseInformation const metricsHandler(NetworkListener *,
+                                         RequestInformation const &) {
+  // the metrics are read from the registry only, neither the listener nor
+  // the DataStore are involved
+  static atomic<size_t> lastSize{0};
+
+  string body;
+  body.reserve(lastSize.load(memory_order_relaxed) + 256);
+  Metrics::getInstance().writePrometheusText(body);
+  lastSize.store(body.size(), memory_order_relaxed);
+
+  ResponseInformation response;
+  response.body = move(body);
+  response.contentType = "text/plain; version=0.0.4";
+  return response;
 }
@@ -9,12 +9,33 @@
 #ifndef _REST_ENDPOINT_HANDLERS_H_
 #define _REST_ENDPOINT_HANDLERS_H_
 
+#include <optional>
+#include <string>
+
 #include "NetworkListener.h"
 #include "RequestInformation.h"
 
 typedef ResponseInformation const (*TEndpointHandler)(
     NetworkListener *, RequestInformation const &);
 
+/**
+ * @brief Returns the entity tag of the response the request would get, without
+ * creating the response. `nullopt` if the response cannot be tagged.
+ */
+typedef std::optional<std::string> (*TETagHandler)(NetworkListener *,
+                                                   RequestInformation const &);
+
+/**
+ * @brief Returns true if the request waits for a change before it is answered
+ * (long polling).
+ */
+typedef bool (*TLongPollHandler)(RequestInformation const &);
+
+/**
+ * @brief Creates the error response with the HTTP status code of the error.
+ */
+ResponseInformation const mapErrorToResponse(Error const &err);
+
 ResponseInformation const generateSessionHandler(NetworkListener *,
                                                  RequestInformation const &);
 
@@ -24,6 +45,10 @@ ResponseInformation const queryTracksHandler(NetworkListener *,
 ResponseInformation const getCurrentQueuesHandler(NetworkListener *,
                                                   RequestInformation const &);
 
+std::optional<std::string> getCurrentQueuesETag(NetworkListener *,
+                                                RequestInformation const &);
+bool getCurrentQueuesLongPoll(RequestInformation const &);
+
 ResponseInformation const addTrackToQueueHandler(NetworkListener *,
                                                  RequestInformation const &);
 
@@ -39,4 +64,19 @@ ResponseInformation const moveTracksHandler(NetworkListener *,
 ResponseInformation const removeTrackHandler(NetworkListener *,
                                              RequestInformation const &);
 
+ResponseInformation const addTracksToQueueHandler(NetworkListener *,
+                                                  RequestInformation const &);
+
+ResponseInformation const voteTracksHandler(NetworkListener *,
+                                            RequestInformation const &);
+
+ResponseInformation const removeTracksHandler(NetworkListener *,
+                                              RequestInformation const &);
+
+ResponseInformation const eventsHandler(NetworkListener *,
+                                        RequestInformation const &);
+
+ResponseInformation const metricsHandler(NetworkListener *,
+                                         RequestInformation const &);
+
 #endif  // _REST_ENDPOINT_HANDLERS_H_
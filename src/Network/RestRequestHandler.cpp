@@ -10,12 +10,18 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
+#include "Network/ContentNegotiation.h"
 #include "RestEndpointHandlers.h"
+#include "Utils/Compression.h"
 #include "Utils/LoggingHandler.h"
+#include "Utils/Metrics.h"
 #include "json/json.hpp"
 
 using namespace std;
@@ -24,6 +30,22 @@ using json = nlohmann::json;
 
 static string const API_BASE_PATH = "/api/v1";
 
+// keeps idle event streams from being closed by proxies
+static chrono::seconds const HEARTBEAT_INTERVAL(15);
+static EventBroadcaster::TEvent const HEARTBEAT =
+    make_shared<string const>(":\n\n");
+// smaller bodies are not worth the overhead of compressing them
+static size_t const MIN_COMPRESSED_SIZE = 1024;
+// seconds after which rejected clients should try again
+static string const RETRY_AFTER = "5";
+
+static Metrics::TMetricID const cRejectedStreams =
+    Metrics::getInstance().registerCounter("jukebox_rejected_requests_total",
+                                           "reason=\"event_streams\"");
+static Metrics::TMetricID const cRejectedLongPolls =
+    Metrics::getInstance().registerCounter("jukebox_rejected_requests_total",
+                                           "reason=\"long_polls\"");
+
 //
 // Utilities
 //
@@ -41,6 +63,148 @@ static optional<string> getCurrentExceptionMessage() {
   return nullopt;
 }
 
+/**
+ * @brief Writes the events of a subscription to the buffer of the response.
+ * @details Blocks until at least one event is available, a heartbeat is sent
+ * if nothing has been published for a while. The events are shared with all
+ * other subscribers and are only copied into the buffer.
+ * @return The number of written bytes, -1 to close the stream.
+ */
+static ssize_t sendEvents(shared_ptr<EventSubscription> subscription,
+                          char *buffer,
+                          size_t max) {
+  auto &sub = *subscription;
+  size_t size = 0;
+  while (size < max) {
+    if (sub.current && sub.offset < sub.current->size()) {
+      auto n = min(max - size, sub.current->size() - sub.offset);
+      memcpy(buffer + size, sub.current->data() + sub.offset, n);
+      sub.offset += n;
+      size += n;
+      continue;
+    }
+
+    // only wait if nothing has been written yet
+    auto timeout = (size == 0) ? chrono::milliseconds(HEARTBEAT_INTERVAL)
+                               : chrono::milliseconds(0);
+    auto result = sub.events->waitForEvent(sub.position, timeout);
+    if (holds_alternative<Error>(result)) {
+      // the client fell behind, it has to reconnect to get the current state
+      VLOG(1) << get<Error>(result).getErrorMessage();
+      if (size == 0) {
+        return -1;
+      }
+      break;
+    }
+
+    auto event = get<EventBroadcaster::TEvent>(result);
+    if (!event) {
+      if (size > 0) {
+        break;
+      }
+      event = HEARTBEAT;
+    }
+    sub.current = event;
+    sub.offset = 0;
+  }
+  return size;
+}
+
+/**
+ * @brief Checks if an `If-None-Match` header contains the entity tag.
+ * @details Uses the weak comparison, which ignores the `W/` prefix.
+ */
+static bool matchesETag(string const &ifNoneMatch, string const &etag) {
+  auto opaqueTag = [](string const &tag) {
+    auto begin = tag.find_first_not_of(" \t");
+    auto end = tag.find_last_not_of(" \t");
+    if (begin == string::npos) {
+      return string();
+    }
+    if (tag.compare(begin, 2, "W/") == 0) {
+      begin += 2;
+    }
+    return tag.substr(begin, end - begin + 1);
+  };
+
+  auto expected = opaqueTag(etag);
+  size_t start = 0;
+  while (start < ifNoneMatch.size()) {
+    auto end = ifNoneMatch.find(',', start);
+    if (end == string::npos) {
+      end = ifNoneMatch.size();
+    }
+    auto tag = opaqueTag(ifNoneMatch.substr(start, end - start));
+    if (tag == "*" || tag == expected) {
+      return true;
+    }
+    start = end + 1;
+  }
+  return false;
+}
+
+/**
+ * @brief Creates the response in the format and content coding requested by
+ * the client.
+ * @param format Format requested by the client.
+ * @param etag Entity tag of successful responses, if any.
+ */
+static shared_ptr<http_response> encodeResponse(
+    http_request const &req,
+    ResponseFormat format,
+    ResponseInformation info,
+    optional<string> const &etag) {
+  auto contentType = info.contentType;
+  string vary = "Accept-Encoding";
+
+  // only JSON bodies can be converted into other formats
+  if (contentType == ContentNegotiation::JSON_CONTENT_TYPE &&
+      format != ResponseFormat::Json) {
+    info.body = ContentNegotiation::encode(info.body, format);
+    info.segments.clear();
+    contentType = ContentNegotiation::getContentType(format);
+  }
+  if (contentType == ContentNegotiation::getContentType(format)) {
+    vary = "Accept, " + vary;
+  }
+
+  auto encoding =
+      ContentNegotiation::negotiateEncoding(req.get_header("Accept-Encoding"));
+  if (info.body.size() < MIN_COMPRESSED_SIZE) {
+    encoding = ContentEncoding::Identity;
+  }
+  if (encoding != ContentEncoding::Identity) {
+    info.body = Compression::compress(info.body, info.segments, encoding);
+  }
+
+  auto response =
+      make_shared<string_response>(info.body, info.code, contentType);
+  response->with_header("Vary", vary);
+  if (etag.has_value() && info.code == 200) {
+    response->with_header("ETag", etag.value());
+  }
+  if (encoding != ContentEncoding::Identity) {
+    response->with_header("Content-Encoding",
+                          ContentNegotiation::getEncodingName(encoding));
+  }
+  return response;
+}
+
+/**
+ * @brief Creates the response to a request which was rejected because the
+ * server is busy, the client should try again later.
+ */
+static shared_ptr<http_response> unavailableResponse(
+    http_request const &req,
+    ResponseFormat format,
+    string const &message) {
+  VLOG(1) << message;
+  auto info = mapErrorToResponse(Error(ErrorCode::ServiceUnavailable, message));
+  auto response = encodeResponse(req, format, move(info), nullopt);
+  response->with_header("Retry-After", RETRY_AFTER);
+  return response;
+}
+
 //
 // Default request handlers
 //
@@ -86,8 +250,12 @@ shared_ptr<http_response> const RestRequestHandler::InternalErrorHandler(
 // RestRequestHandler implementation
 //
 
-RestRequestHandler::RestRequestHandler(NetworkListener *listener)
-    : listener(listener) {
+RestRequestHandler::RestRequestHandler(NetworkListener *listener,
+                                       size_t maxEventStreams,
+                                       size_t maxLongPolls)
+    : listener(listener),
+      mEventStreams(maxEventStreams),
+      mLongPolls(maxLongPolls) {
   assert(listener);
 }
 
@@ -108,34 +276,112 @@ shared_ptr<http_response> const RestRequestHandler::render(
   VLOG(2) << "Query parameters: " << req.get_querystring();
 
   auto path = req.get_path().substr(API_BASE_PATH.size());
-  auto response = decodeAndDispatch(RequestInformation{
+  auto infos = RequestInformation{
       path,               //
       req.get_method(),   //
       req.get_content(),  //
       req.get_args()      //
-  });
+  };
+  infos.format = ContentNegotiation::negotiateFormat(req.get_header("Accept"));
+
+  // clients which already have the current response get none, before it is
+  // created at all
+  auto etag = getETag(infos);
+  if (etag.has_value() &&
+      matchesETag(req.get_header("If-None-Match"), etag.value())) {
+    VLOG(2) << "Response: not modified";
+    auto notModified = make_shared<string_response>("", 304);
+    notModified->with_header("ETag", etag.value());
+    notModified->with_header("Vary", "Accept, Accept-Encoding");
+    return notModified;
+  }
+
+  // long polling requests block a thread of the server while they wait, the
+  // slot is held until the response has been created
+  ConcurrencyLimit::TSlot longPoll;
+  if (isLongPoll(infos)) {
+    longPoll = mLongPolls.tryAcquire();
+    if (!longPoll) {
+      Metrics::getInstance().increment(cRejectedLongPolls);
+      return unavailableResponse(req, infos.format,
+                                 "All " + to_string(mLongPolls.getLimit()) +
+                                     " long polling requests are in use");
+    }
+  }
+
+  auto response = decodeAndDispatch(infos);
+
+  if (response.has_value() && response.value().subscription) {
+    // every stream blocks a thread of the server until it is closed
+    auto slot = mEventStreams.tryAcquire();
+    if (!slot) {
+      Metrics::getInstance().increment(cRejectedStreams);
+      return unavailableResponse(req, infos.format,
+                                 "All " + to_string(mEventStreams.getLimit()) +
+                                     " event streams are in use");
+    }
+    response.value().subscription->slot = slot;
+
+    VLOG(2) << "Response: event stream";
+    auto stream = make_shared<deferred_response<EventSubscription>>(
+        sendEvents, response.value().subscription, "", response.value().code,
+        "text/event-stream");
+    stream->with_header("Cache-Control", "no-cache");
+    return stream;
+  }
 
   if (response.has_value()) {
     VLOG(2) << "Response: " << response.value().body;
-    return make_shared<string_response>(response.value().body,
-                                        response.value().code);
+    return encodeResponse(req, infos.format, move(response.value()), etag);
   }
 
   return NotFoundHandler(req);
 }
 
+optional<string> RestRequestHandler::getETag(RequestInformation const &infos) {
+  static const map<pair<string, string>, TETagHandler> TAGGED_ENDPOINTS = {
+      {{"/getCurrentQueues", "GET"}, getCurrentQueuesETag}  //
+  };
+
+  auto handlerIt = TAGGED_ENDPOINTS.find({infos.path, infos.method});
+  if (handlerIt != TAGGED_ENDPOINTS.cend()) {
+    return handlerIt->second(listener, infos);
+  }
+
+  return nullopt;
+}
+
+bool RestRequestHandler::isLongPoll(RequestInformation const &infos) {
+  static const map<pair<string, string>, TLongPollHandler>
+      LONG_POLL_ENDPOINTS = {
+          {{"/getCurrentQueues", "GET"}, getCurrentQueuesLongPoll}  //
+      };
+
+  auto handlerIt = LONG_POLL_ENDPOINTS.find({infos.path, infos.method});
+  if (handlerIt != LONG_POLL_ENDPOINTS.cend()) {
+    return handlerIt->second(infos);
+  }
+
+  return false;
+}
+
 optional<ResponseInformation> RestRequestHandler::decodeAndDispatch(
     RequestInformation const &infos) {
   static const map<pair<string, string>, TEndpointHandler> AVAILABLE_ENDPOINTS =
       {
-          {{"/generateSession", "POST"}, generateSessionHandler},   //
-          {{"/queryTracks", "GET"}, queryTracksHandler},            //
-          {{"/getCurrentQueues", "GET"}, getCurrentQueuesHandler},  //
-          {{"/addTrackToQueue", "POST"}, addTrackToQueueHandler},   //
-          {{"/voteTrack", "PUT"}, voteTrackHandler},                //
-          {{"/controlPlayer", "PUT"}, controlPlayerHandler},        //
-          {{"/moveTrack", "PUT"}, moveTracksHandler},               //
-          {{"/removeTrack", "DELETE"}, removeTrackHandler}          //
+          {{"/generateSession", "POST"}, generateSessionHandler},     //
+          {{"/queryTracks", "GET"}, queryTracksHandler},              //
+          {{"/getCurrentQueues", "GET"}, getCurrentQueuesHandler},    //
+          {{"/addTrackToQueue", "POST"}, addTrackToQueueHandler},     //
+          {{"/addTracksToQueue", "POST"}, addTracksToQueueHandler},   //
+          {{"/voteTrack", "PUT"}, voteTrackHandler},                  //
+          {{"/voteTracks", "PUT"}, voteTracksHandler},                //
+          {{"/controlPlayer", "PUT"}, controlPlayerHandler},          //
+          {{"/moveTrack", "PUT"}, moveTracksHandler},                 //
+          {{"/removeTrack", "DELETE"}, removeTrackHandler},           //
+          {{"/removeTracks", "DELETE"}, removeTracksHandler},         //
+          {{"/events", "GET"}, eventsHandler},                        //
+          {{"/metrics", "GET"}, metricsHandler}                       //
       };
 
   // TODO: the Method NotAllowedHandler won't ever be called
@@ -15,16 +15,31 @@
 
 #include "NetworkListener.h"
 #include "RequestInformation.h"
+#include "Utils/ConcurrencyLimit.h"
 
 /**
  * @class RestRequestHandler
  * @brief Provides a REST request handler for incoming connections.
  * @details Is used to validate and dispatch incoming requests. If a valid
  * request has found the assigned `NetworkListener` is notified.
+ *
+ * The server uses a thread per connection. Every event stream blocks its
+ * thread until the client disconnects and every long polling request until
+ * a change happens or it times out, so the number of both is limited.
+ * Further requests are answered with `503 Service Unavailable`.
  */
 class RestRequestHandler : public httpserver::http_resource {
  public:
-  RestRequestHandler(NetworkListener *listener);
+  static constexpr size_t cDefaultMaxEventStreams = 256;
+  static constexpr size_t cDefaultMaxLongPolls = 256;
+
+  /**
+   * @param maxEventStreams Maximum number of concurrent event streams.
+   * @param maxLongPolls Maximum number of concurrent long polling requests.
+   */
+  RestRequestHandler(NetworkListener *listener,
+                     size_t maxEventStreams = cDefaultMaxEventStreams,
+                     size_t maxLongPolls = cDefaultMaxLongPolls);
 
   static std::shared_ptr<httpserver::http_response> const NotFoundHandler(
       httpserver::http_request const &req);
@@ -35,6 +50,8 @@ class RestRequestHandler : public httpserver::http_resource {
 
  private:
   NetworkListener *listener;
+  ConcurrencyLimit mEventStreams;
+  ConcurrencyLimit mLongPolls;
 
   bool isValidBasePath(std::string const &path) const;
   std::shared_ptr<httpserver::http_response> const render(
@@ -42,6 +59,10 @@ class RestRequestHandler : public httpserver::http_resource {
 
   std::optional<ResponseInformation> decodeAndDispatch(
       RequestInformation const &);
+
+  std::optional<std::string> getETag(RequestInformation const &);
+
+  bool isLongPoll(RequestInformation const &);
 };
 
 #endif /* _REST_ENDPOINT_HANDLER_H_ */
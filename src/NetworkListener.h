@@ -9,13 +9,16 @@
 #ifndef _NETWORKLISTENER_H_
 #define _NETWORKLISTENER_H_
 
+#include <chrono>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "Types/GlobalTypes.h"
 #include "Types/Queue.h"
 #include "Types/Result.h"
+#include "Utils/EventBroadcaster.h"
 
 /**
  * @brief Provides interface methods for all supported requests.
@@ -59,6 +62,51 @@ class NetworkListener {
    */
   virtual TResult<QueueStatus> getCurrentQueues(TSessionID const &sid) = 0;
 
+  /**
+   * @brief Waits until the queues or the playback change.
+   * @details Returns immediately if they already changed since `since`.
+   * @param sid Session ID of the user.
+   * @param since Version returned by getCurrentQueues.
+   * @param timeout Maximum time to wait.
+   * @return The current version (equals `since` if nothing changed), `Error`
+   * otherwise.
+   */
+  virtual TResult<uint64_t> waitForChange(
+      TSessionID const &sid,
+      uint64_t since,
+      std::chrono::milliseconds timeout) = 0;
+
+  /**
+   * @brief Returns the events pushed to the clients.
+   * @details Changes of the queues and the progress of the playback are
+   * published as Server-Sent Events.
+   * @param sid Session ID of the user.
+   * @return The broadcaster of the events on success, `Error` otherwise.
+   */
+  virtual TResult<EventBroadcaster *> getEvents(TSessionID const &sid) = 0;
+
+  /**
+   * @brief Returns queues which have previously been returned by
+   * getCurrentQueues, so only the changes since then need to be sent.
+   * @details Only the most recent versions are kept.
+   * @param sid Session ID of the user.
+   * @param queueVersion The `queueVersion` of a previous QueueStatus.
+   * @return The queues without user specific information, `Error` if the
+   * version is not known (anymore).
+   */
+  virtual TResult<TQueueSnapshot> getPreviousQueues(TSessionID const &sid,
+                                                    uint64_t queueVersion) = 0;
+
+  /**
+   * @brief Identifies the result of getCurrentQueues for the user, without
+   * copying the queues.
+   * @details Used to answer requests of clients which already have the
+   * current queues.
+   * @param sid Session ID of the user.
+   * @return The tag on success, `Error` otherwise.
+   */
+  virtual TResult<QueueStatusTag> getQueueStatusTag(TSessionID const &sid) = 0;
+
   /**
    * @brief Add a track to a given queue (normal or admin).
    * @details Depending on the value of `type` a track is added to either the
@@ -79,6 +127,23 @@ class NetworkListener {
                                      TTrackID const &trkid,
                                      QueueType type) = 0;
 
+  /**
+   * @brief Add multiple tracks to a given queue (normal or admin) at once.
+   * @details Same as addTrackToQueue for every track, but the queue is
+   * modified only once (e.g. to import a playlist).
+   *
+   * @param sid The session ID of the user. Used to authenticate as admin if
+   * needed.
+   * @param trkids The IDs of the tracks to add to a queue.
+   * @param type Determines to which queue the tracks should be added.
+   * @return Either the result for each track (in the given order) or an
+   * `Error` if the whole request failed.
+   */
+  virtual TResult<std::vector<TResultOpt>> addTracksToQueue(
+      TSessionID const &sid,
+      std::vector<TTrackID> const &trkids,
+      QueueType type) = 0;
+
   /**
    * @brief Vote for a track or revoke a vote.
    * @details Depending on the value of `type` a track is added to either the
@@ -98,6 +163,19 @@ class NetworkListener {
                                TTrackID const &trkid,
                                TVote vote) = 0;
 
+  /**
+   * @brief Vote for multiple tracks or revoke the votes at once.
+   * @details Same as voteTrack for every entry, but the queue is reordered
+   * only once.
+   *
+   * @param sid The session ID of the user.
+   * @param votes Pairs of a track ID and the vote for this track.
+   * @return Returns an `Error` if something went wrong.
+   */
+  virtual TResultOpt voteTracks(
+      TSessionID const &sid,
+      std::vector<std::pair<TTrackID, TVote>> const &votes) = 0;
+
   /**
    * @brief Controls the behaviour of the music player.
    * @details Allows the admin to control some behaviour of the player. This
@@ -132,6 +210,22 @@ class NetworkListener {
   virtual TResultOpt removeTrack(TSessionID const &sid,
                                  TTrackID const &trkid) = 0;
 
+  /**
+   * @brief Remove multiple tracks from the queues at once.
+   * @details Same as removeTrack for every track, but the queues are
+   * modified only once. This action is only allowed for admins.
+   *
+   * @param sid The session ID of the user. Used to authenticate as admin.
+   * @param trkids The tracks to be removed.
+   * @return Either the result for each track (in the given order) or an
+   * `Error` if the whole request failed.
+   *
+   * @note To remove tracks from any queue, the user must have been
+   * authenticated as admin when generating the session ID!
+   */
+  virtual TResult<std::vector<TResultOpt>> removeTracks(
+      TSessionID const &sid, std::vector<TTrackID> const &trkids) = 0;
+
   /**
    * @brief Move a track between queues.
    * @details Can be used to move a track from one queue to another. If the
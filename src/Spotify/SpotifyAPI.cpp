@@ -9,10 +9,42 @@
 #include <connection.h>
 
 #include <cassert>
+#include <chrono>
 #include <memory>
 
+#include "Utils/Metrics.h"
+
 using namespace SpotifyApi;
 
+static Metrics::TMetricID const cGetDuration =
+    Metrics::getInstance().registerHistogram(
+        "jukebox_spotify_request_duration_seconds", "request=\"get\"");
+static Metrics::TMetricID const cPostDuration =
+    Metrics::getInstance().registerHistogram(
+        "jukebox_spotify_request_duration_seconds", "request=\"post\"");
+static Metrics::TMetricID const cPutDuration =
+    Metrics::getInstance().registerHistogram(
+        "jukebox_spotify_request_duration_seconds", "request=\"put\"");
+static Metrics::TMetricID const cTokenDuration =
+    Metrics::getInstance().registerHistogram(
+        "jukebox_spotify_request_duration_seconds", "request=\"token\"");
+
+/**
+ * @brief Performs a request to Spotify and records its duration.
+ */
+template <typename TFunc>
+static RestClient::Response measureRequest(Metrics::TMetricID histogram,
+                                           TFunc const &request) {
+  auto start = std::chrono::steady_clock::now();
+  auto response = request();
+  auto end = std::chrono::steady_clock::now();
+  Metrics::getInstance().record(
+      histogram,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count());
+  return response;
+}
+
 TResult<Token> SpotifyAPI::getAccessToken(GrantType grantType,
                                           std::string const &code,
                                           std::string const &redirectUri,
@@ -47,7 +79,8 @@ TResult<Token> SpotifyAPI::getAccessToken(GrantType grantType,
   client->SetHeaders(headers);
 
   client->SetTimeout(cRequestTimeout);
-  auto response = client->post("/api/token", body);
+  auto response = measureRequest(
+      cTokenDuration, [&]() { return client->post("/api/token", body); });
   nlohmann::json tokenJson;
   try {
     tokenJson = nlohmann::json::parse(response.body);
@@ -97,7 +130,8 @@ TResult<Token> SpotifyAPI::refreshAccessToken(std::string const &refreshToken,
   client->SetHeaders(headers);
 
   client->SetTimeout(cRequestTimeout);
-  auto response = client->post("/api/token", body);
+  auto response = measureRequest(
+      cTokenDuration, [&]() { return client->post("/api/token", body); });
   nlohmann::json tokenJson;
   try {
     tokenJson = nlohmann::json::parse(response.body);
@@ -396,15 +430,20 @@ TResult<RestClient::Response> SpotifyAPI::spotifyCall(
 
   switch (method) {
     case HttpGet: {
-      response = client->get(endpoint + query);
+      response = measureRequest(
+          cGetDuration, [&]() { return client->get(endpoint + query); });
     } break;
 
     case HttpPost: {
-      response = client->post(endpoint + query, body);
+      response = measureRequest(cPostDuration, [&]() {
+        return client->post(endpoint + query, body);
+      });
     } break;
 
     case HttpPut: {
-      response = client->put(endpoint + query, body);
+      response = measureRequest(cPutDuration, [&]() {
+        return client->put(endpoint + query, body);
+      });
     } break;
     default:
       return Error(ErrorCode::SpotifyAPIError, "Invalid Http method");
@@ -12,11 +12,19 @@
 #include "Types/Result.h"
 #include "Utils/ConfigHandler.h"
 #include "Utils/LoggingHandler.h"
+#include "Utils/Metrics.h"
 #include "httpserver.hpp"
 
 using namespace SpotifyApi;
 using namespace httpserver;
 
+static Metrics::TMetricID const cTokenRefreshes =
+    Metrics::getInstance().registerCounter(
+        "jukebox_spotify_token_refreshes_total", "result=\"success\"");
+static Metrics::TMetricID const cFailedTokenRefreshes =
+    Metrics::getInstance().registerCounter(
+        "jukebox_spotify_token_refreshes_total", "result=\"error\"");
+
 SpotifyAuthorization::~SpotifyAuthorization() {
   stopServer();
 }
@@ -79,8 +87,10 @@ TResultOpt SpotifyAuthorization::refreshAccessToken() {
   if (auto error = std::get_if<Error>(&ret)) {
     LOG(ERROR) << "SpotifyAuthorization.refreshAccessToken: "
                << error->getErrorMessage();
+    Metrics::getInstance().increment(cFailedTokenRefreshes);
     return *error;
   }
+  Metrics::getInstance().increment(cTokenRefreshes);
 
   auto token = std::get<Token>(ret);
   // set refresh token, because in refresh access token no new refresh token
@@ -9,6 +9,8 @@
 #ifndef _QUEUE_H_
 #define _QUEUE_H_
 
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -30,6 +32,44 @@ struct QueueStatus {
   Queue adminQueue;
 
   std::optional<PlaybackTrack> currentTrack;
+
+  // changes whenever the queues or the playback change
+  uint64_t version = 0;
+  // version of the QueueSnapshot the queues are taken from, 0 if unknown
+  uint64_t queueVersion = 0;
+};
+
+/**
+ * @brief Identifies the QueueStatus of a user without copying the queues.
+ * @details Two equal tags result in the same QueueStatus, except for the
+ * progress of the current track.
+ */
+struct QueueStatusTag {
+  // differs between runs of the server, since the versions restart with it
+  uint64_t epoch;
+  // version of the QueueStatus
+  uint64_t version;
+  // hash of the tracks the user has voted for
+  uint64_t votesHash;
+};
+
+/**
+ * @brief Immutable view of both queues and the current track at a certain
+ * version of a DataStore.
+ * @details A snapshot gets shared between all readers and is never modified
+ * after it has been published. Every modification of the queues or the current
+ * track results in a new snapshot with a higher version. Versions start at 1.
+ */
+struct QueueSnapshot {
+  uint64_t version;
+  Queue adminQueue;
+  Queue normalQueue;
+  std::optional<QueuedTrack> currentTrack;
 };
 
+/**
+ * @brief Shared, read only handle to a QueueSnapshot
+ */
+using TQueueSnapshot = std::shared_ptr<QueueSnapshot const>;
+
 #endif /* _QUEUE_H_ */
@@ -39,7 +39,8 @@ enum class ErrorCode {
   SpotifyNoDevice,
   AlreadyExists,
   DoesntExist,
-  WrongPassword
+  WrongPassword,
+  ServiceUnavailable
 };
 
 /**
@@ -8,7 +8,7 @@
 #define _USER_H_
 
 #include <ctime>
-#include <vector>
+#include <unordered_set>
 
 #include "Types/GlobalTypes.h"
 
@@ -18,7 +18,8 @@ class User {
   std::time_t ExpirationDate;
   std::string Name;
   bool isAdmin;
-  std::vector<TTrackID> votes;
+  // tracks upvoted by this user
+  std::unordered_set<TTrackID> votes;
   bool operator==(const User user) {
     return SessionID == user.SessionID;
   }
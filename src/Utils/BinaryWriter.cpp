@@ -0,0 +1,275 @@
+/*****************************************************************************/
+/**
+ * @file    BinaryWriter.cpp
+ * @author  Team Server
+ * @brief   Class BinaryWriter implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/BinaryWriter.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+// major types of CBOR
+static uint8_t const CBOR_UNSIGNED = 0;
+static uint8_t const CBOR_NEGATIVE = 1;
+static uint8_t const CBOR_STRING = 3;
+static uint8_t const CBOR_ARRAY = 4;
+static uint8_t const CBOR_MAP = 5;
+
+// MessagePack types of 8, 16 and 32 bit lengths, 0 if there is none
+static array<uint8_t, 3> const MSGPACK_STRING = {0xd9, 0xda, 0xdb};
+static array<uint8_t, 3> const MSGPACK_ARRAY = {0x00, 0xdc, 0xdd};
+static array<uint8_t, 3> const MSGPACK_MAP = {0x00, 0xde, 0xdf};
+
+static void appendByte(uint8_t byte, string &out) {
+  out += static_cast<char>(byte);
+}
+
+static void appendBigEndian(uint64_t value, size_t bytes, string &out) {
+  for (size_t i = bytes; i > 0; i--) {
+    appendByte(static_cast<uint8_t>(value >> ((i - 1) * 8)), out);
+  }
+}
+
+/**
+ * @brief Appends the initial byte of a CBOR data item and its argument in the
+ * smallest encoding.
+ */
+static void appendCborHead(uint8_t majorType, uint64_t argument, string &out) {
+  uint8_t type = majorType << 5;
+  if (argument < 24) {
+    appendByte(type | argument, out);
+  } else if (argument <= numeric_limits<uint8_t>::max()) {
+    appendByte(type | 24, out);
+    appendBigEndian(argument, 1, out);
+  } else if (argument <= numeric_limits<uint16_t>::max()) {
+    appendByte(type | 25, out);
+    appendBigEndian(argument, 2, out);
+  } else if (argument <= numeric_limits<uint32_t>::max()) {
+    appendByte(type | 26, out);
+    appendBigEndian(argument, 4, out);
+  } else {
+    appendByte(type | 27, out);
+    appendBigEndian(argument, 8, out);
+  }
+}
+
+/**
+ * @brief Appends a MessagePack type with a length, the length is stored in
+ * the fix type if it is at most `fixMax`.
+ */
+static void appendMsgPackHead(uint8_t fixType,
+                              uint64_t fixMax,
+                              array<uint8_t, 3> const &types,
+                              uint64_t length,
+                              string &out) {
+  if (length <= fixMax) {
+    appendByte(fixType | length, out);
+  } else if (types[0] != 0 && length <= numeric_limits<uint8_t>::max()) {
+    appendByte(types[0], out);
+    appendBigEndian(length, 1, out);
+  } else if (length <= numeric_limits<uint16_t>::max()) {
+    appendByte(types[1], out);
+    appendBigEndian(length, 2, out);
+  } else {
+    appendByte(types[2], out);
+    appendBigEndian(length, 4, out);
+  }
+}
+
+static void appendContainerHead(BinaryFormat format,
+                                bool isObject,
+                                size_t size,
+                                string &out) {
+  if (format == BinaryFormat::Cbor) {
+    appendCborHead(isObject ? CBOR_MAP : CBOR_ARRAY, size, out);
+  } else if (isObject) {
+    appendMsgPackHead(0x80, 15, MSGPACK_MAP, size, out);
+  } else {
+    appendMsgPackHead(0x90, 15, MSGPACK_ARRAY, size, out);
+  }
+}
+
+BinaryWriter::BinaryWriter(string &out, BinaryFormat format)
+    : mOut(out), mFormat(format) {
+}
+
+BinaryWriter &BinaryWriter::beginObject() {
+  begin(true, nullopt);
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::endObject() {
+  end();
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::beginArray() {
+  begin(false, nullopt);
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::beginArray(size_t size) {
+  begin(false, size);
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::endArray() {
+  end();
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::key(string_view name) {
+  element();
+  appendString(name);
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::value(string_view str) {
+  element();
+  appendString(str);
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::value(char const *str) {
+  return value(string_view(str));
+}
+
+BinaryWriter &BinaryWriter::value(bool b) {
+  element();
+  if (mFormat == BinaryFormat::Cbor) {
+    appendByte(b ? 0xf5 : 0xf4, mOut);
+  } else {
+    appendByte(b ? 0xc3 : 0xc2, mOut);
+  }
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::value(double number) {
+  element();
+  uint64_t bits;
+  static_assert(sizeof(bits) == sizeof(number));
+  memcpy(&bits, &number, sizeof(bits));
+  appendByte(mFormat == BinaryFormat::Cbor ? 0xfb : 0xcb, mOut);
+  appendBigEndian(bits, sizeof(bits), mOut);
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::nullValue() {
+  element();
+  appendByte(mFormat == BinaryFormat::Cbor ? 0xf6 : 0xc0, mOut);
+  return *this;
+}
+
+BinaryWriter &BinaryWriter::raw(string_view encoded) {
+  element();
+  mOut += encoded;
+  return *this;
+}
+
+string &BinaryWriter::getOutput() {
+  return mOut;
+}
+
+BinaryFormat BinaryWriter::getFormat() const {
+  return mFormat;
+}
+
+void BinaryWriter::begin(bool isObject, optional<size_t> size) {
+  element();
+  mContainers.push_back({mOut.size(), 0, isObject, size.has_value()});
+  if (size.has_value()) {
+    appendContainerHead(mFormat, isObject, size.value(), mOut);
+  } else {
+    // replaced by the head when the container is ended
+    appendByte(0, mOut);
+  }
+}
+
+void BinaryWriter::end() {
+  assert(!mContainers.empty());
+  auto container = mContainers.back();
+  mContainers.pop_back();
+  if (container.hasHead) {
+    return;
+  }
+
+  auto size =
+      container.isObject ? container.elements / 2 : container.elements;
+  string head;
+  appendContainerHead(mFormat, container.isObject, size, head);
+  mOut.replace(container.headOffset, 1, head);
+}
+
+void BinaryWriter::element() {
+  if (!mContainers.empty()) {
+    mContainers.back().elements++;
+  }
+}
+
+void BinaryWriter::appendString(string_view str) {
+  if (mFormat == BinaryFormat::Cbor) {
+    appendCborHead(CBOR_STRING, str.size(), mOut);
+  } else {
+    appendMsgPackHead(0xa0, 31, MSGPACK_STRING, str.size(), mOut);
+  }
+  mOut += str;
+}
+
+void BinaryWriter::appendUnsigned(uint64_t number) {
+  if (mFormat == BinaryFormat::Cbor) {
+    appendCborHead(CBOR_UNSIGNED, number, mOut);
+    return;
+  }
+
+  if (number < 128) {
+    // positive fixint
+    appendByte(number, mOut);
+  } else if (number <= numeric_limits<uint8_t>::max()) {
+    appendByte(0xcc, mOut);
+    appendBigEndian(number, 1, mOut);
+  } else if (number <= numeric_limits<uint16_t>::max()) {
+    appendByte(0xcd, mOut);
+    appendBigEndian(number, 2, mOut);
+  } else if (number <= numeric_limits<uint32_t>::max()) {
+    appendByte(0xce, mOut);
+    appendBigEndian(number, 4, mOut);
+  } else {
+    appendByte(0xcf, mOut);
+    appendBigEndian(number, 8, mOut);
+  }
+}
+
+void BinaryWriter::appendNegative(int64_t number) {
+  assert(number < 0);
+  if (mFormat == BinaryFormat::Cbor) {
+    // encoded as -1 - n
+    appendCborHead(CBOR_NEGATIVE, static_cast<uint64_t>(-(number + 1)), mOut);
+    return;
+  }
+
+  // two's complement, the lower bytes are written
+  auto bits = static_cast<uint64_t>(number);
+  if (number >= -32) {
+    // negative fixint
+    appendByte(static_cast<uint8_t>(bits), mOut);
+  } else if (number >= numeric_limits<int8_t>::min()) {
+    appendByte(0xd0, mOut);
+    appendBigEndian(bits, 1, mOut);
+  } else if (number >= numeric_limits<int16_t>::min()) {
+    appendByte(0xd1, mOut);
+    appendBigEndian(bits, 2, mOut);
+  } else if (number >= numeric_limits<int32_t>::min()) {
+    appendByte(0xd2, mOut);
+    appendBigEndian(bits, 4, mOut);
+  } else {
+    appendByte(0xd3, mOut);
+    appendBigEndian(bits, 8, mOut);
+  }
+}
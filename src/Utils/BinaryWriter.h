@@ -0,0 +1,113 @@
+/*****************************************************************************/
+/**
+ * @file    BinaryWriter.h
+ * @author  Team Server
+ * @brief   Class BinaryWriter definition
+ */
+/*****************************************************************************/
+
+#ifndef _BINARY_WRITER_H_
+#define _BINARY_WRITER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Binary formats written by BinaryWriter.
+ */
+enum class BinaryFormat { MessagePack, Cbor };
+
+/**
+ * @brief Writes MessagePack or CBOR directly into a string, with the same
+ * interface as JsonWriter.
+ * @details Every value is written in its smallest encoding, so the output is
+ * the same as the one of `nlohmann::json::to_msgpack` and `to_cbor` for a
+ * document with the same keys in the same order.
+ *
+ * Both formats need the number of elements in front of an object or array. A
+ * single byte is reserved for it, which is enough for small containers. If
+ * more bytes are needed when the container is ended, its content is moved,
+ * which can be avoided by passing the size of large arrays to beginArray.
+ */
+class BinaryWriter {
+ public:
+  /**
+   * @param out Output, the data is appended to its current content.
+   */
+  BinaryWriter(std::string &out, BinaryFormat format);
+
+  BinaryWriter &beginObject();
+  BinaryWriter &endObject();
+  BinaryWriter &beginArray();
+  /**
+   * @param size Number of elements which are written into the array.
+   */
+  BinaryWriter &beginArray(size_t size);
+  BinaryWriter &endArray();
+
+  BinaryWriter &key(std::string_view name);
+
+  BinaryWriter &value(std::string_view str);
+  BinaryWriter &value(char const *str);
+  BinaryWriter &value(bool b);
+  BinaryWriter &value(double number);
+  BinaryWriter &nullValue();
+
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                   BinaryWriter &>
+  value(T number) {
+    element();
+    if constexpr (std::is_signed_v<T>) {
+      if (number < 0) {
+        appendNegative(number);
+        return *this;
+      }
+    }
+    appendUnsigned(static_cast<uint64_t>(number));
+    return *this;
+  }
+
+  /**
+   * @brief Writes an already encoded value of the same format as is.
+   */
+  BinaryWriter &raw(std::string_view encoded);
+
+  /**
+   * @brief The output the writer appends to, e.g. to patch values which have
+   * already been written.
+   */
+  std::string &getOutput();
+
+  BinaryFormat getFormat() const;
+
+ private:
+  /**
+   * @brief Object or array which has not been ended yet.
+   */
+  struct Container {
+    size_t headOffset;
+    // keys and values written into the container
+    size_t elements;
+    bool isObject;
+    // false if the byte at headOffset is reserved for the head
+    bool hasHead;
+  };
+
+  void begin(bool isObject, std::optional<size_t> size);
+  void end();
+  void element();
+  void appendString(std::string_view str);
+  void appendUnsigned(uint64_t number);
+  void appendNegative(int64_t number);
+
+  std::string &mOut;
+  BinaryFormat mFormat;
+  std::vector<Container> mContainers;
+};
+
+#endif /* _BINARY_WRITER_H_ */
@@ -0,0 +1,31 @@
+/*****************************************************************************/
+/**
+ * @file    ChangeNotifier.cpp
+ * @author  Team Server
+ * @brief   Class ChangeNotifier implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/ChangeNotifier.h"
+
+using namespace std;
+
+uint64_t ChangeNotifier::getVersion() {
+  lock_guard<mutex> lock(mMutex);
+  return mVersion;
+}
+
+void ChangeNotifier::notify() {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mVersion++;
+  }
+  mChanged.notify_all();
+}
+
+uint64_t ChangeNotifier::waitForChange(uint64_t since,
+                                       chrono::milliseconds timeout) {
+  unique_lock<mutex> lock(mMutex);
+  mChanged.wait_for(lock, timeout, [&]() { return mVersion != since; });
+  return mVersion;
+}
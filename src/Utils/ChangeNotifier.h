@@ -0,0 +1,44 @@
+/*****************************************************************************/
+/**
+ * @file    ChangeNotifier.h
+ * @author  Team Server
+ * @brief   Class ChangeNotifier definition
+ */
+/*****************************************************************************/
+
+#ifndef _CHANGE_NOTIFIER_H_
+#define _CHANGE_NOTIFIER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Version counter which threads can wait on.
+ * @details Every change of the observed state increments the version, threads
+ * waiting for a newer version than the one they know are woken up.
+ */
+class ChangeNotifier {
+ public:
+  uint64_t getVersion();
+
+  /**
+   * @brief Increments the version and wakes up all waiting threads.
+   */
+  void notify();
+
+  /**
+   * @brief Blocks until the version differs from `since` or the timeout
+   * expires.
+   * @return The current version, which equals `since` on a timeout.
+   */
+  uint64_t waitForChange(uint64_t since, std::chrono::milliseconds timeout);
+
+ private:
+  std::mutex mMutex;
+  std::condition_variable mChanged;
+  uint64_t mVersion = 0;
+};
+
+#endif /* _CHANGE_NOTIFIER_H_ */
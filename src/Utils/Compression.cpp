@@ -0,0 +1,118 @@
+/*****************************************************************************/
+/**
+ * @file    Compression.cpp
+ * @author  Team Server
+ * @brief   Class Compression implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/Compression.h"
+
+#include <zlib.h>
+
+#include <cassert>
+#include <stdexcept>
+
+using namespace std;
+
+// an empty, final deflate block with fixed Huffman codes, terminating a stream
+// of segments
+static char const FINAL_BLOCK[] = {0x03, 0x00};
+
+static void appendLittleEndian(uint32_t value, string &out) {
+  for (int i = 0; i < 4; i++) {
+    out += static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+static void appendBigEndian(uint32_t value, string &out) {
+  for (int i = 3; i >= 0; i--) {
+    out += static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+CompressedSegment const &CachedSegment::get(string_view data) const {
+  call_once(mOnce, [&]() { mSegment = Compression::compressSegment(data); });
+  return mSegment;
+}
+
+CompressedSegment Compression::compressSegment(string_view data) {
+  CompressedSegment segment;
+  auto bytes = reinterpret_cast<Bytef const *>(data.data());
+  segment.crc32 = crc32(crc32(0, Z_NULL, 0), bytes, data.size());
+  segment.adler32 = adler32(adler32(0, Z_NULL, 0), bytes, data.size());
+  segment.size = data.size();
+
+  // negative window bits create raw deflate data, without header and trailer
+  z_stream stream = {};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw runtime_error("Failed to initialize deflate stream");
+  }
+
+  // a sync flush ends the segment byte aligned, without a final block
+  segment.data.resize(deflateBound(&stream, data.size()) + 16);
+  stream.next_in = const_cast<Bytef *>(bytes);
+  stream.avail_in = data.size();
+  do {
+    if (stream.total_out == segment.data.size()) {
+      segment.data.resize(segment.data.size() * 2);
+    }
+    stream.next_out =
+        reinterpret_cast<Bytef *>(segment.data.data()) + stream.total_out;
+    stream.avail_out = segment.data.size() - stream.total_out;
+    deflate(&stream, Z_SYNC_FLUSH);
+  } while (stream.avail_out == 0);
+  assert(stream.avail_in == 0);
+
+  segment.data.resize(stream.total_out);
+  deflateEnd(&stream);
+  return segment;
+}
+
+string Compression::compress(string_view body,
+                             vector<BodySegment> const &segments,
+                             ContentEncoding encoding) {
+  assert(encoding != ContentEncoding::Identity);
+
+  string out;
+  out.reserve(body.size() / 4 + 64);
+  if (encoding == ContentEncoding::Gzip) {
+    // magic, deflate, no flags, no modification time, no extra flags, Unix
+    out.append("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\x03", 10);
+  } else {
+    // deflate with a 32K window, default compression
+    out.append("\x78\x9c", 2);
+  }
+
+  uint32_t crc = crc32(0, Z_NULL, 0);
+  uint32_t adler = adler32(0, Z_NULL, 0);
+  auto append = [&](CompressedSegment const &segment) {
+    out += segment.data;
+    crc = crc32_combine(crc, segment.crc32, segment.size);
+    adler = adler32_combine(adler, segment.adler32, segment.size);
+  };
+
+  size_t pos = 0;
+  for (auto &&segment : segments) {
+    assert(segment.offset >= pos &&
+           segment.offset + segment.size <= body.size());
+    if (segment.offset > pos) {
+      append(compressSegment(body.substr(pos, segment.offset - pos)));
+    }
+    append(segment.cached->get(body.substr(segment.offset, segment.size)));
+    pos = segment.offset + segment.size;
+  }
+  if (pos < body.size()) {
+    append(compressSegment(body.substr(pos)));
+  }
+  out.append(FINAL_BLOCK, sizeof(FINAL_BLOCK));
+
+  if (encoding == ContentEncoding::Gzip) {
+    appendLittleEndian(crc, out);
+    appendLittleEndian(static_cast<uint32_t>(body.size()), out);
+  } else {
+    appendBigEndian(adler, out);
+  }
+  return out;
+}
@@ -0,0 +1,86 @@
+/*****************************************************************************/
+/**
+ * @file    Compression.h
+ * @author  Team Server
+ * @brief   Class Compression definition
+ */
+/*****************************************************************************/
+
+#ifndef _COMPRESSION_H_
+#define _COMPRESSION_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief HTTP content codings supported for responses.
+ */
+enum class ContentEncoding { Identity, Gzip, Deflate };
+
+/**
+ * @brief Part of a deflate stream which does not reference any data before
+ * it, so it can be combined with other segments in any order.
+ */
+struct CompressedSegment {
+  // raw deflate blocks, ending byte aligned without a final block
+  std::string data;
+  // checksums and length of the uncompressed data
+  uint32_t crc32;
+  uint32_t adler32;
+  size_t size;
+};
+
+/**
+ * @brief Segment which is compressed on first use and shared afterwards.
+ */
+class CachedSegment {
+ public:
+  /**
+   * @brief Returns the compressed segment.
+   * @param data The uncompressed data, only used on the first call. Must be
+   * the same for every call.
+   */
+  CompressedSegment const &get(std::string_view data) const;
+
+ private:
+  mutable std::once_flag mOnce;
+  mutable CompressedSegment mSegment;
+};
+
+/**
+ * @brief Range of a body which is compressed by a CachedSegment.
+ */
+struct BodySegment {
+  size_t offset;
+  size_t size;
+  std::shared_ptr<CachedSegment const> cached;
+};
+
+/**
+ * @brief Compresses response bodies with the gzip or deflate (zlib) format.
+ * @details Bodies are assembled from independently compressed segments, so
+ * parts which are the same for many responses only have to be compressed
+ * once.
+ */
+class Compression {
+ public:
+  /**
+   * @brief Compresses the data into an independent segment.
+   */
+  static CompressedSegment compressSegment(std::string_view data);
+
+  /**
+   * @brief Compresses the body in the given encoding.
+   * @param segments Ranges of the body, ordered by their offset, which are
+   * taken from their cached segment. All other data is compressed.
+   */
+  static std::string compress(std::string_view body,
+                              std::vector<BodySegment> const &segments,
+                              ContentEncoding encoding);
+};
+
+#endif /* _COMPRESSION_H_ */
@@ -0,0 +1,38 @@
+/*****************************************************************************/
+/**
+ * @file    ConcurrencyLimit.cpp
+ * @author  Team Server
+ * @brief   Class ConcurrencyLimit implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/ConcurrencyLimit.h"
+
+using namespace std;
+
+ConcurrencyLimit::ConcurrencyLimit(size_t limit)
+    : mLimit(limit), mActive(make_shared<atomic<size_t>>(0)) {
+}
+
+ConcurrencyLimit::TSlot ConcurrencyLimit::tryAcquire() {
+  auto active = mActive->load();
+  do {
+    if (active >= mLimit) {
+      return nullptr;
+    }
+  } while (!mActive->compare_exchange_weak(active, active + 1));
+
+  // the slot keeps the counter alive, so it can be released after the
+  // ConcurrencyLimit has been destroyed
+  auto counter = mActive;
+  return TSlot(counter.get(),
+               [counter](void const *) { counter->fetch_sub(1); });
+}
+
+size_t ConcurrencyLimit::getActive() const {
+  return mActive->load();
+}
+
+size_t ConcurrencyLimit::getLimit() const {
+  return mLimit;
+}
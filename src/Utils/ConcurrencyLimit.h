@@ -0,0 +1,48 @@
+/*****************************************************************************/
+/**
+ * @file    ConcurrencyLimit.h
+ * @author  Team Server
+ * @brief   Class ConcurrencyLimit definition
+ */
+/*****************************************************************************/
+
+#ifndef _CONCURRENCY_LIMIT_H_
+#define _CONCURRENCY_LIMIT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief Limits how many holders of a resource there are at the same time,
+ * e.g. how many requests may keep a thread of the server busy.
+ */
+class ConcurrencyLimit {
+ public:
+  /**
+   * @brief A taken slot, it is released when the last copy is destroyed.
+   * @details Slots may outlive the ConcurrencyLimit they were taken from.
+   */
+  using TSlot = std::shared_ptr<void const>;
+
+  explicit ConcurrencyLimit(size_t limit);
+
+  /**
+   * @brief Takes a slot if not all of them are taken.
+   * @return The slot, `nullptr` if the limit is reached.
+   */
+  TSlot tryAcquire();
+
+  /**
+   * @brief Number of currently taken slots.
+   */
+  size_t getActive() const;
+
+  size_t getLimit() const;
+
+ private:
+  size_t mLimit;
+  std::shared_ptr<std::atomic<size_t>> mActive;
+};
+
+#endif /* _CONCURRENCY_LIMIT_H_ */
@@ -0,0 +1,76 @@
+/*****************************************************************************/
+/**
+ * @file    EventBroadcaster.cpp
+ * @author  Team Server
+ * @brief   Class EventBroadcaster implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/EventBroadcaster.h"
+
+using namespace std;
+
+string EventBroadcaster::formatEvent(string const &name, string const &data) {
+  string event;
+  event.reserve(name.size() + data.size() + 16);
+  event += "event: ";
+  event += name;
+  event += "\ndata: ";
+  event += data;
+  event += "\n\n";
+  return event;
+}
+
+void EventBroadcaster::publish(string event) {
+  auto shared = make_shared<string const>(move(event));
+  {
+    lock_guard<mutex> lock(mMutex);
+    append(move(shared));
+  }
+  mPublished.notify_all();
+}
+
+void EventBroadcaster::publish(string event, string state) {
+  auto sharedEvent = make_shared<string const>(move(event));
+  auto sharedState = make_shared<string const>(move(state));
+  {
+    lock_guard<mutex> lock(mMutex);
+    append(move(sharedEvent));
+    mState = move(sharedState);
+  }
+  mPublished.notify_all();
+}
+
+EventBroadcaster::TEvent EventBroadcaster::subscribe(uint64_t &position) {
+  lock_guard<mutex> lock(mMutex);
+  position = mFirstPosition + mEvents.size();
+  return mState;
+}
+
+TResult<EventBroadcaster::TEvent> EventBroadcaster::waitForEvent(
+    uint64_t &position, chrono::milliseconds timeout) {
+  unique_lock<mutex> lock(mMutex);
+  auto isPublished = [&]() {
+    return position < mFirstPosition + mEvents.size();
+  };
+  if (!mPublished.wait_for(lock, timeout, isPublished)) {
+    return TEvent();
+  }
+
+  if (position < mFirstPosition) {
+    return Error(ErrorCode::DoesntExist,
+                 "EventBroadcaster.waitForEvent: " +
+                     to_string(mFirstPosition - position) +
+                     " events have been missed");
+  }
+  return mEvents[position++ - mFirstPosition];
+}
+
+void EventBroadcaster::append(TEvent event) {
+  // must be called with mMutex held
+  mEvents.push_back(move(event));
+  if (mEvents.size() > cMaxEvents) {
+    mEvents.pop_front();
+    mFirstPosition++;
+  }
+}
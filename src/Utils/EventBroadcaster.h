@@ -0,0 +1,86 @@
+/*****************************************************************************/
+/**
+ * @file    EventBroadcaster.h
+ * @author  Team Server
+ * @brief   Class EventBroadcaster definition
+ */
+/*****************************************************************************/
+
+#ifndef _EVENT_BROADCASTER_H_
+#define _EVENT_BROADCASTER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Types/Result.h"
+
+/**
+ * @brief Fans out serialized events to any number of subscribers.
+ * @details Every event is serialized once by the publisher and shared between
+ * all subscribers, a subscriber only keeps the position of the next event it
+ * wants to read. The last `cMaxEvents` events are kept, a subscriber falling
+ * further behind misses events and has to subscribe again.\n\n
+ * Additionally a state event can be published, which is handed to every new
+ * subscriber, so it can apply the following events on top of it.
+ */
+class EventBroadcaster {
+ public:
+  using TEvent = std::shared_ptr<std::string const>;
+
+  static constexpr size_t cMaxEvents = 256;
+
+  /**
+   * @brief Formats an event as a Server-Sent Event.
+   * @param name Type of the event.
+   * @param data Payload, must not contain line breaks.
+   */
+  static std::string formatEvent(std::string const &name,
+                                 std::string const &data);
+
+  /**
+   * @brief Appends an event and wakes up all waiting subscribers.
+   */
+  void publish(std::string event);
+
+  /**
+   * @brief Appends an event and replaces the state handed to new subscribers.
+   * @details Both are updated atomically, so `state` must already contain the
+   * changes described by `event`.
+   */
+  void publish(std::string event, std::string state);
+
+  /**
+   * @brief Starts reading events.
+   * @param position Is set to the position of the next published event.
+   * @return The current state, `nullptr` if none has been published yet.
+   */
+  TEvent subscribe(uint64_t &position);
+
+  /**
+   * @brief Blocks until the event at `position` is available or the timeout
+   * expires.
+   * @param position Position of the event to read, is advanced on success.
+   * @param timeout Maximum time to wait.
+   * @return The event, `nullptr` on a timeout or `Error` if the event has
+   * already been dropped.
+   */
+  TResult<TEvent> waitForEvent(uint64_t &position,
+                               std::chrono::milliseconds timeout);
+
+ private:
+  void append(TEvent event);
+
+  std::mutex mMutex;
+  std::condition_variable mPublished;
+  std::deque<TEvent> mEvents;
+  // position of the first event in mEvents
+  uint64_t mFirstPosition = 0;
+  TEvent mState;
+};
+
+#endif /* _EVENT_BROADCASTER_H_ */
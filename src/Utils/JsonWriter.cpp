@@ -0,0 +1,178 @@
+/*****************************************************************************/
+/**
+ * @file    JsonWriter.cpp
+ * @author  Team Server
+ * @brief   Class JsonWriter implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/JsonWriter.h"
+
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+static uint64_t const cOnes = 0x0101010101010101ULL;
+static uint64_t const cHighBits = 0x8080808080808080ULL;
+
+/**
+ * @brief Returns non-zero if any byte of the block is a control character, a
+ * quote or a backslash.
+ */
+static uint64_t needsEscaping(uint64_t block) {
+  // a byte is below n if subtracting n borrows from its high bit
+  auto hasZeroByte = [](uint64_t v) { return (v - cOnes) & ~v & cHighBits; };
+  uint64_t control = (block - cOnes * 0x20) & ~block & cHighBits;
+  uint64_t quote = hasZeroByte(block ^ (cOnes * '"'));
+  uint64_t backslash = hasZeroByte(block ^ (cOnes * '\\'));
+  return control | quote | backslash;
+}
+
+static bool needsEscaping(char c) {
+  return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+static void appendEscapedChar(char c, string &out) {
+  switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default: {
+      static char const HEX[] = "0123456789abcdef";
+      auto byte = static_cast<unsigned char>(c);
+      out += "\\u00";
+      out += HEX[byte >> 4];
+      out += HEX[byte & 0xF];
+    } break;
+  }
+}
+
+JsonWriter::JsonWriter(string &out) : mOut(out) {
+}
+
+JsonWriter &JsonWriter::beginObject() {
+  separate();
+  mOut += '{';
+  mNeedsComma = false;
+  return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+  mOut += '}';
+  mNeedsComma = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+  separate();
+  mOut += '[';
+  mNeedsComma = false;
+  return *this;
+}
+
+JsonWriter &JsonWriter::beginArray(size_t) {
+  return beginArray();
+}
+
+JsonWriter &JsonWriter::endArray() {
+  mOut += ']';
+  mNeedsComma = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::key(string_view name) {
+  separate();
+  mOut += '"';
+  appendEscaped(name, mOut);
+  mOut += "\":";
+  mNeedsComma = false;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(string_view str) {
+  separate();
+  mOut += '"';
+  appendEscaped(str, mOut);
+  mOut += '"';
+  mNeedsComma = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(char const *str) {
+  return value(string_view(str));
+}
+
+JsonWriter &JsonWriter::value(bool b) {
+  separate();
+  mOut += b ? "true" : "false";
+  mNeedsComma = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::nullValue() {
+  separate();
+  mOut += "null";
+  mNeedsComma = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::raw(string_view json) {
+  separate();
+  mOut += json;
+  mNeedsComma = true;
+  return *this;
+}
+
+string &JsonWriter::getOutput() {
+  return mOut;
+}
+
+void JsonWriter::appendEscaped(string_view str, string &out) {
+  size_t runStart = 0;
+  size_t i = 0;
+  while (i < str.size()) {
+    // skip whole blocks which do not need escaping
+    if (i + sizeof(uint64_t) <= str.size()) {
+      uint64_t block;
+      memcpy(&block, str.data() + i, sizeof(block));
+      if (!needsEscaping(block)) {
+        i += sizeof(block);
+        continue;
+      }
+    }
+
+    if (!needsEscaping(str[i])) {
+      i++;
+      continue;
+    }
+    out.append(str.data() + runStart, i - runStart);
+    appendEscapedChar(str[i], out);
+    runStart = ++i;
+  }
+  out.append(str.data() + runStart, i - runStart);
+}
+
+void JsonWriter::separate() {
+  if (mNeedsComma) {
+    mOut += ',';
+  }
+}
@@ -0,0 +1,90 @@
+/*****************************************************************************/
+/**
+ * @file    JsonWriter.h
+ * @author  Team Server
+ * @brief   Class JsonWriter definition
+ */
+/*****************************************************************************/
+
+#ifndef _JSON_WRITER_H_
+#define _JSON_WRITER_H_
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @brief Writes JSON directly into a string, without building a document
+ * first.
+ * @details Commas are inserted automatically, the caller is responsible for
+ * properly nesting objects and arrays and for writing a key before every value
+ * inside of an object. Strings are expected to be UTF-8 and are not validated.
+ *
+ * @code
+ * JsonWriter writer(out);
+ * writer.beginObject().key("votes").value(3).endObject();
+ * @endcode
+ */
+class JsonWriter {
+ public:
+  /**
+   * @param out Output, the JSON is appended to its current content.
+   */
+  explicit JsonWriter(std::string &out);
+
+  JsonWriter &beginObject();
+  JsonWriter &endObject();
+  JsonWriter &beginArray();
+  /**
+   * @brief Same as beginArray(), the size is only needed by BinaryWriter.
+   */
+  JsonWriter &beginArray(size_t size);
+  JsonWriter &endArray();
+
+  JsonWriter &key(std::string_view name);
+
+  JsonWriter &value(std::string_view str);
+  JsonWriter &value(char const *str);
+  JsonWriter &value(bool b);
+  JsonWriter &nullValue();
+
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                   JsonWriter &>
+  value(T number) {
+    separate();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    mOut.append(buffer, result.ptr);
+    mNeedsComma = true;
+    return *this;
+  }
+
+  /**
+   * @brief Writes an already serialized JSON value as is.
+   */
+  JsonWriter &raw(std::string_view json);
+
+  /**
+   * @brief The output the writer appends to, e.g. to patch values which have
+   * already been written.
+   */
+  std::string &getOutput();
+
+  /**
+   * @brief Appends the string with all characters escaped which are not
+   * allowed inside of JSON strings (without the surrounding quotes).
+   * @details Blocks of eight characters are checked at once, so strings which
+   * need no escaping are copied in large chunks.
+   */
+  static void appendEscaped(std::string_view str, std::string &out);
+
+ private:
+  void separate();
+
+  std::string &mOut;
+  bool mNeedsComma = false;
+};
+
+#endif /* _JSON_WRITER_H_ */
@@ -0,0 +1,56 @@
+/*****************************************************************************/
+/**
+ * @file    MeasuredSharedMutex.cpp
+ * @author  Team Server
+ * @brief   Class MeasuredSharedMutex implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/MeasuredSharedMutex.h"
+
+#include <chrono>
+
+using namespace std;
+
+MeasuredSharedMutex::MeasuredSharedMutex(string const &name,
+                                         string const &labels)
+    : mWaitTime(Metrics::getInstance().registerHistogram(name, labels)) {
+}
+
+void MeasuredSharedMutex::lock() {
+  uint64_t ns = 0;
+  if (!mMutex.try_lock()) {
+    auto start = chrono::steady_clock::now();
+    mMutex.lock();
+    auto end = chrono::steady_clock::now();
+    ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  }
+  Metrics::getInstance().record(mWaitTime, ns);
+}
+
+bool MeasuredSharedMutex::try_lock() {
+  return mMutex.try_lock();
+}
+
+void MeasuredSharedMutex::unlock() {
+  mMutex.unlock();
+}
+
+void MeasuredSharedMutex::lock_shared() {
+  uint64_t ns = 0;
+  if (!mMutex.try_lock_shared()) {
+    auto start = chrono::steady_clock::now();
+    mMutex.lock_shared();
+    auto end = chrono::steady_clock::now();
+    ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  }
+  Metrics::getInstance().record(mWaitTime, ns);
+}
+
+bool MeasuredSharedMutex::try_lock_shared() {
+  return mMutex.try_lock_shared();
+}
+
+void MeasuredSharedMutex::unlock_shared() {
+  mMutex.unlock_shared();
+}
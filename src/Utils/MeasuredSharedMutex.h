@@ -0,0 +1,44 @@
+/*****************************************************************************/
+/**
+ * @file    MeasuredSharedMutex.h
+ * @author  Team Server
+ * @brief   Class MeasuredSharedMutex definition
+ */
+/*****************************************************************************/
+
+#ifndef _MEASURED_SHARED_MUTEX_H_
+#define _MEASURED_SHARED_MUTEX_H_
+
+#include <shared_mutex>
+#include <string>
+
+#include "Utils/Metrics.h"
+
+/**
+ * @brief A shared mutex which records the time spent waiting for it.
+ * @details Every acquisition (exclusive or shared) records its wait time in a
+ * histogram, uncontended acquisitions are recorded as 0 without reading the
+ * clock. Can be used with std::unique_lock and std::shared_lock.
+ */
+class MeasuredSharedMutex {
+ public:
+  /**
+   * @param name Name of the histogram (see Metrics::registerHistogram).
+   * @param labels Labels of the histogram.
+   */
+  MeasuredSharedMutex(std::string const &name, std::string const &labels);
+
+  void lock();
+  bool try_lock();
+  void unlock();
+
+  void lock_shared();
+  bool try_lock_shared();
+  void unlock_shared();
+
+ private:
+  std::shared_mutex mMutex;
+  Metrics::TMetricID mWaitTime;
+};
+
+#endif /* _MEASURED_SHARED_MUTEX_H_ */
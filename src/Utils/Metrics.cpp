@@ -0,0 +1,418 @@
+/*****************************************************************************/
+/**
+ * @file    Metrics.cpp
+ * @author  Team Server
+ * @brief   Classes LatencyHistogram and Metrics implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/Metrics.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+using namespace std;
+
+//
+// LatencyHistogram
+//
+
+LatencyHistogram::LatencyHistogram(LatencyHistogram const &other) {
+  add(other);
+}
+
+LatencyHistogram &LatencyHistogram::operator=(LatencyHistogram const &other) {
+  if (this != &other) {
+    reset();
+    add(other);
+  }
+  return *this;
+}
+
+void LatencyHistogram::reset() {
+  for (auto &&bucket : mBuckets) {
+    bucket.store(0, memory_order_relaxed);
+  }
+  mCount.store(0, memory_order_relaxed);
+  mSum.store(0, memory_order_relaxed);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+  // single writer, so no read-modify-write operations are needed
+  auto &bucket = mBuckets[getBucketIndex(value)];
+  bucket.store(bucket.load(memory_order_relaxed) + 1, memory_order_relaxed);
+  mCount.store(mCount.load(memory_order_relaxed) + 1, memory_order_relaxed);
+  mSum.store(mSum.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+void LatencyHistogram::add(LatencyHistogram const &other) {
+  for (size_t i = 0; i < cBuckets; i++) {
+    mBuckets[i].fetch_add(other.getBucketCount(i), memory_order_relaxed);
+  }
+  mCount.fetch_add(other.getCount(), memory_order_relaxed);
+  mSum.fetch_add(other.getSum(), memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const {
+  return mCount.load(memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getSum() const {
+  return mSum.load(memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getBucketCount(size_t index) const {
+  return mBuckets[index].load(memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getQuantile(double q) const {
+  // count the buckets themselves, mCount may already include a value which
+  // is not visible in its bucket yet
+  uint64_t total = 0;
+  for (auto &&bucket : mBuckets) {
+    total += bucket.load(memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  auto rank = static_cast<uint64_t>(ceil(clamp(q, 0.0, 1.0) * total));
+  rank = max<uint64_t>(rank, 1);
+  uint64_t count = 0;
+  for (size_t i = 0; i < cBuckets; i++) {
+    count += mBuckets[i].load(memory_order_relaxed);
+    if (count >= rank) {
+      return getBucketUpperBound(i);
+    }
+  }
+  return getBucketUpperBound(cBuckets - 1);
+}
+
+size_t LatencyHistogram::getBucketIndex(uint64_t value) {
+  // values below cSubBuckets have their own bucket
+  if (value < cSubBuckets) {
+    return value;
+  }
+  size_t exponent = 63 - __builtin_clzll(value);
+  if (exponent > cMaxExponent) {
+    return cBuckets - 1;
+  }
+  size_t subBucket =
+      (value >> (exponent - cSubBucketBits)) & (cSubBuckets - 1);
+  return (exponent - cSubBucketBits + 1) * cSubBuckets + subBucket;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t index) {
+  if (index < cSubBuckets) {
+    return index;
+  }
+  size_t exponent = index / cSubBuckets + cSubBucketBits - 1;
+  uint64_t subBucket = index % cSubBuckets;
+  size_t shift = exponent - cSubBucketBits;
+  return ((cSubBuckets + subBucket) << shift) + (uint64_t(1) << shift) - 1;
+}
+
+//
+// Prometheus text format
+//
+
+using TMetricNames = vector<pair<string, string>>;
+
+static bool isFirstWithName(TMetricNames const &metrics, size_t index) {
+  for (size_t i = 0; i < index; i++) {
+    if (metrics[i].first == metrics[index].first) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void appendType(string &out, string const &name, char const *type) {
+  out += "# TYPE ";
+  out += name;
+  out += ' ';
+  out += type;
+  out += '\n';
+}
+
+static void appendName(string &out,
+                       string const &name,
+                       char const *suffix,
+                       string const &labels,
+                       char const *quantile = nullptr) {
+  out += name;
+  out += suffix;
+  if (labels.empty() && quantile == nullptr) {
+    return;
+  }
+  out += '{';
+  out += labels;
+  if (quantile != nullptr) {
+    if (!labels.empty()) {
+      out += ',';
+    }
+    out += "quantile=\"";
+    out += quantile;
+    out += '"';
+  }
+  out += '}';
+}
+
+static void appendValue(string &out, int64_t value) {
+  char buffer[32];
+  int len = snprintf(buffer, sizeof(buffer), " %" PRId64 "\n", value);
+  out.append(buffer, len);
+}
+
+static void appendValue(string &out, uint64_t value) {
+  char buffer[32];
+  int len = snprintf(buffer, sizeof(buffer), " %" PRIu64 "\n", value);
+  out.append(buffer, len);
+}
+
+static void appendSeconds(string &out, uint64_t ns) {
+  char buffer[32];
+  int len = snprintf(buffer, sizeof(buffer), " %.9g\n", ns / 1e9);
+  out.append(buffer, len);
+}
+
+//
+// Metrics
+//
+
+thread_local Metrics::ShardHandle Metrics::sShard;
+
+Metrics &Metrics::getInstance() {
+  static Metrics instance;
+  return instance;
+}
+
+Metrics::ThreadShard::~ThreadShard() {
+  for (auto &&histogram : histograms) {
+    delete histogram.load();
+  }
+}
+
+Metrics::ShardHandle::~ShardHandle() {
+  if (shard == nullptr) {
+    return;
+  }
+
+  // keep the counts of the exiting thread
+  auto &metrics = getInstance();
+  lock_guard<mutex> lock(metrics.mMutex);
+  auto &retired = metrics.mRetired;
+  for (size_t i = 0; i < cMaxCounters; i++) {
+    retired.counters[i].fetch_add(shard->counters[i].load(),
+                                  memory_order_relaxed);
+  }
+  for (size_t i = 0; i < cMaxHistograms; i++) {
+    auto histogram = shard->histograms[i].load();
+    if (histogram == nullptr) {
+      continue;
+    }
+    if (retired.histograms[i].load() == nullptr) {
+      retired.histograms[i] = new LatencyHistogram();
+    }
+    retired.histograms[i].load()->add(*histogram);
+  }
+
+  auto &shards = metrics.mShards;
+  shards.erase(remove_if(shards.begin(), shards.end(),
+                         [this](unique_ptr<ThreadShard> const &s) {
+                           return s.get() == shard;
+                         }),
+               shards.end());
+  shard = nullptr;
+}
+
+Metrics::ThreadShard &Metrics::getShard() {
+  if (sShard.shard == nullptr) {
+    auto shard = make_unique<ThreadShard>();
+    lock_guard<mutex> lock(mMutex);
+    sShard.shard = shard.get();
+    mShards.push_back(move(shard));
+  }
+  return *sShard.shard;
+}
+
+Metrics::TMetricID Metrics::registerMetric(
+    vector<pair<string, string>> &metrics,
+    size_t maxMetrics,
+    string const &name,
+    string const &labels) {
+  // must be called with mMutex held
+  auto metric = make_pair(name, labels);
+  auto it = find(metrics.begin(), metrics.end(), metric);
+  if (it != metrics.end()) {
+    return it - metrics.begin();
+  }
+  if (metrics.size() >= maxMetrics) {
+    // updates of this ID are ignored
+    LOG(WARNING) << "Metric " << name << "{" << labels
+                 << "} not registered, limit of " << maxMetrics
+                 << " reached";
+    return maxMetrics;
+  }
+  metrics.push_back(move(metric));
+  return metrics.size() - 1;
+}
+
+Metrics::TMetricID Metrics::registerCounter(string const &name,
+                                            string const &labels) {
+  lock_guard<mutex> lock(mMutex);
+  return registerMetric(mCounterNames, cMaxCounters, name, labels);
+}
+
+Metrics::TMetricID Metrics::registerHistogram(string const &name,
+                                              string const &labels) {
+  lock_guard<mutex> lock(mMutex);
+  return registerMetric(mHistogramNames, cMaxHistograms, name, labels);
+}
+
+Metrics::TMetricID Metrics::registerGauge(string const &name,
+                                          string const &labels) {
+  lock_guard<mutex> lock(mMutex);
+  return registerMetric(mGaugeNames, cMaxGauges, name, labels);
+}
+
+void Metrics::increment(TMetricID counter, uint64_t n) {
+  if (counter >= cMaxCounters) {
+    return;
+  }
+  // only the calling thread writes its shard
+  auto &value = getShard().counters[counter];
+  value.store(value.load(memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+void Metrics::record(TMetricID histogram, uint64_t ns) {
+  if (histogram >= cMaxHistograms) {
+    return;
+  }
+  auto &slot = getShard().histograms[histogram];
+  auto value = slot.load(memory_order_acquire);
+  if (value == nullptr) {
+    value = new LatencyHistogram();
+    slot.store(value, memory_order_release);
+  }
+  value->record(ns);
+}
+
+void Metrics::set(TMetricID gauge, int64_t value) {
+  if (gauge >= cMaxGauges) {
+    return;
+  }
+  mGauges[gauge].store(value, memory_order_relaxed);
+}
+
+uint64_t Metrics::mergeCounter(size_t index) {
+  // must be called with mMutex held
+  uint64_t value = mRetired.counters[index].load(memory_order_relaxed);
+  for (auto &&shard : mShards) {
+    value += shard->counters[index].load(memory_order_relaxed);
+  }
+  return value;
+}
+
+void Metrics::mergeHistogram(size_t index, LatencyHistogram &histogram) {
+  // must be called with mMutex held
+  auto retired = mRetired.histograms[index].load(memory_order_acquire);
+  if (retired != nullptr) {
+    histogram.add(*retired);
+  }
+  for (auto &&shard : mShards) {
+    auto value = shard->histograms[index].load(memory_order_acquire);
+    if (value != nullptr) {
+      histogram.add(*value);
+    }
+  }
+}
+
+vector<Metrics::CounterValue> Metrics::getCounters() {
+  lock_guard<mutex> lock(mMutex);
+
+  vector<CounterValue> values;
+  values.reserve(mCounterNames.size());
+  for (size_t i = 0; i < mCounterNames.size(); i++) {
+    values.push_back(
+        {mCounterNames[i].first, mCounterNames[i].second, mergeCounter(i)});
+  }
+  return values;
+}
+
+vector<Metrics::HistogramValue> Metrics::getHistograms() {
+  lock_guard<mutex> lock(mMutex);
+
+  vector<HistogramValue> values(mHistogramNames.size());
+  for (size_t i = 0; i < mHistogramNames.size(); i++) {
+    values[i].name = mHistogramNames[i].first;
+    values[i].labels = mHistogramNames[i].second;
+    mergeHistogram(i, values[i].histogram);
+  }
+  return values;
+}
+
+void Metrics::writePrometheusText(string &out) {
+  static char const *const cQuantileLabels[] = {"0.5", "0.9", "0.99"};
+  static double const cQuantiles[] = {0.5, 0.9, 0.99};
+
+  lock_guard<mutex> lock(mMutex);
+
+  // all metrics with the same name have to be written in one group
+  for (size_t i = 0; i < mCounterNames.size(); i++) {
+    if (!isFirstWithName(mCounterNames, i)) {
+      continue;
+    }
+    auto const &name = mCounterNames[i].first;
+    appendType(out, name, "counter");
+    for (size_t j = i; j < mCounterNames.size(); j++) {
+      if (mCounterNames[j].first == name) {
+        appendName(out, name, "", mCounterNames[j].second);
+        appendValue(out, mergeCounter(j));
+      }
+    }
+  }
+
+  for (size_t i = 0; i < mGaugeNames.size(); i++) {
+    if (!isFirstWithName(mGaugeNames, i)) {
+      continue;
+    }
+    auto const &name = mGaugeNames[i].first;
+    appendType(out, name, "gauge");
+    for (size_t j = i; j < mGaugeNames.size(); j++) {
+      if (mGaugeNames[j].first == name) {
+        appendName(out, name, "", mGaugeNames[j].second);
+        appendValue(out, mGauges[j].load(memory_order_relaxed));
+      }
+    }
+  }
+
+  for (size_t i = 0; i < mHistogramNames.size(); i++) {
+    if (!isFirstWithName(mHistogramNames, i)) {
+      continue;
+    }
+    auto const &name = mHistogramNames[i].first;
+    appendType(out, name, "summary");
+    for (size_t j = i; j < mHistogramNames.size(); j++) {
+      if (mHistogramNames[j].first != name) {
+        continue;
+      }
+      auto const &labels = mHistogramNames[j].second;
+      mMerged.reset();
+      mergeHistogram(j, mMerged);
+      for (size_t q = 0; q < size(cQuantiles); q++) {
+        appendName(out, name, "", labels, cQuantileLabels[q]);
+        appendSeconds(out, mMerged.getQuantile(cQuantiles[q]));
+      }
+      appendName(out, name, "_sum", labels);
+      appendSeconds(out, mMerged.getSum());
+      appendName(out, name, "_count", labels);
+      appendValue(out, mMerged.getCount());
+    }
+  }
+}
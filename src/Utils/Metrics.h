@@ -0,0 +1,208 @@
+/*****************************************************************************/
+/**
+ * @file    Metrics.h
+ * @author  Team Server
+ * @brief   Classes LatencyHistogram and Metrics definition
+ */
+/*****************************************************************************/
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Histogram of latencies with logarithmic buckets (HDR style).
+ * @details Every power of two is split into `cSubBuckets` linear buckets, so a
+ * recorded value keeps a relative precision of 1/`cSubBuckets` over the whole
+ * range from 1 ns up to about 18 minutes. Larger values are counted in the
+ * last bucket.
+ *
+ * A histogram has a single writer, concurrent readers see every counter
+ * either before or after an update, but not necessarily all counters at the
+ * same time.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t cSubBucketBits = 3;
+  static constexpr size_t cSubBuckets = 1 << cSubBucketBits;
+  static constexpr size_t cMaxExponent = 40;
+  static constexpr size_t cBuckets =
+      (cMaxExponent - cSubBucketBits + 2) * cSubBuckets;
+
+  LatencyHistogram() = default;
+  LatencyHistogram(LatencyHistogram const &other);
+  LatencyHistogram &operator=(LatencyHistogram const &other);
+
+  /**
+   * @brief Removes all values, must only be called by the writer.
+   */
+  void reset();
+
+  /**
+   * @brief Counts a single value (in ns), must only be called by the writer.
+   */
+  void record(uint64_t value);
+
+  /**
+   * @brief Adds all values counted by another histogram.
+   */
+  void add(LatencyHistogram const &other);
+
+  uint64_t getCount() const;
+  uint64_t getSum() const;
+
+  /**
+   * @brief Number of recorded values in a bucket.
+   */
+  uint64_t getBucketCount(size_t index) const;
+
+  /**
+   * @brief Estimates the value below which the fraction `q` of all values
+   * lies.
+   * @return The upper bound of the bucket containing the quantile or 0 if
+   * no value has been recorded.
+   */
+  uint64_t getQuantile(double q) const;
+
+  static size_t getBucketIndex(uint64_t value);
+  static uint64_t getBucketUpperBound(size_t index);
+
+ private:
+  std::array<std::atomic<uint64_t>, cBuckets> mBuckets{};
+  std::atomic<uint64_t> mCount{0};
+  std::atomic<uint64_t> mSum{0};
+};
+
+/**
+ * @brief Registry of counters, gauges and latency histograms.
+ * @details Each thread updates its own copy of every counter and histogram
+ * without locking or atomic read-modify-write operations, the copies are only
+ * merged when the metrics are read. Counts of exited threads are kept.
+ * Gauges hold a single value which is overwritten by every update.
+ *
+ * Metrics are registered once (e.g. in a constructor) and are updated using
+ * the returned ID afterwards.
+ */
+class Metrics {
+ public:
+  using TMetricID = size_t;
+
+  static constexpr size_t cMaxCounters = 64;
+  static constexpr size_t cMaxHistograms = 32;
+  static constexpr size_t cMaxGauges = 16;
+
+  /**
+   * @brief Merged value of a counter.
+   */
+  struct CounterValue {
+    std::string name;
+    std::string labels;
+    uint64_t value;
+  };
+
+  /**
+   * @brief Merged values of a histogram.
+   */
+  struct HistogramValue {
+    std::string name;
+    std::string labels;
+    LatencyHistogram histogram;
+  };
+
+  static Metrics &getInstance();
+
+  /**
+   * @brief Registers a counter, registering the same name and labels again
+   * returns the same ID.
+   * @param name Name of the metric (e.g. `jukebox_request_errors_total`).
+   * @param labels Comma separated labels (e.g. `endpoint="voteTrack"`).
+   * @return The ID used to update the counter. If cMaxCounters is reached a
+   * warning is logged and updates of the returned ID are ignored.
+   */
+  TMetricID registerCounter(std::string const &name,
+                            std::string const &labels = "");
+
+  /**
+   * @brief Registers a histogram, see registerCounter.
+   */
+  TMetricID registerHistogram(std::string const &name,
+                              std::string const &labels = "");
+
+  /**
+   * @brief Registers a gauge, see registerCounter.
+   */
+  TMetricID registerGauge(std::string const &name,
+                          std::string const &labels = "");
+
+  void increment(TMetricID counter, uint64_t n = 1);
+  void record(TMetricID histogram, uint64_t ns);
+  void set(TMetricID gauge, int64_t value);
+
+  std::vector<CounterValue> getCounters();
+  std::vector<HistogramValue> getHistograms();
+
+  /**
+   * @brief Appends all metrics to `out` using the Prometheus text format.
+   * @details Histograms are exported as summaries (quantiles, sum and count)
+   * in seconds. Apart from growing `out` no memory is allocated.
+   */
+  void writePrometheusText(std::string &out);
+
+ private:
+  Metrics() = default;
+  Metrics(Metrics const &) = delete;
+  Metrics &operator=(Metrics const &) = delete;
+
+  /**
+   * @brief Metrics updated by a single thread.
+   */
+  struct ThreadShard {
+    std::array<std::atomic<uint64_t>, cMaxCounters> counters{};
+    // allocated on first use by the owning thread
+    std::array<std::atomic<LatencyHistogram *>, cMaxHistograms> histograms{};
+
+    ~ThreadShard();
+  };
+
+  /**
+   * @brief Returns the shard of the calling thread to the registry when the
+   * thread exits.
+   */
+  struct ShardHandle {
+    ThreadShard *shard = nullptr;
+    ~ShardHandle();
+  };
+
+  ThreadShard &getShard();
+  uint64_t mergeCounter(size_t index);
+  void mergeHistogram(size_t index, LatencyHistogram &histogram);
+  static TMetricID registerMetric(
+      std::vector<std::pair<std::string, std::string>> &metrics,
+      size_t maxMetrics,
+      std::string const &name,
+      std::string const &labels);
+
+  static thread_local ShardHandle sShard;
+
+  // guards all members, never locked while updating a metric
+  std::mutex mMutex;
+  std::vector<std::unique_ptr<ThreadShard>> mShards;
+  // counts of exited threads
+  ThreadShard mRetired;
+  std::vector<std::pair<std::string, std::string>> mCounterNames;
+  std::vector<std::pair<std::string, std::string>> mHistogramNames;
+  std::vector<std::pair<std::string, std::string>> mGaugeNames;
+  std::array<std::atomic<int64_t>, cMaxGauges> mGauges{};
+  // merged histogram while writing the metrics
+  LatencyHistogram mMerged;
+};
+
+#endif /* _METRICS_H_ */
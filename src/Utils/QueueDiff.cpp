@@ -0,0 +1,158 @@
+/*****************************************************************************/
+/**
+ * @file    QueueDiff.cpp
+ * @author  Team Server
+ * @brief   Class QueueDiff implementation
+ */
+/*****************************************************************************/
+
+#include "Utils/QueueDiff.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "Utils/Serializer.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * @brief Returns the values of a longest strictly increasing subsequence.
+ */
+static vector<size_t> longestIncreasingSubsequence(
+    vector<size_t> const &values) {
+  // tails[l] is the index of the smallest value ending a subsequence of
+  // length l + 1, predecessors links the subsequences
+  vector<size_t> tails;
+  vector<size_t> predecessors(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    auto it = lower_bound(
+        tails.begin(), tails.end(), values[i],
+        [&](size_t index, size_t value) { return values[index] < value; });
+    predecessors[i] = (it == tails.begin()) ? i : *(it - 1);
+    if (it == tails.end()) {
+      tails.push_back(i);
+    } else {
+      *it = i;
+    }
+  }
+
+  vector<size_t> result(tails.size());
+  if (!tails.empty()) {
+    auto index = tails.back();
+    for (size_t l = tails.size(); l > 0; l--) {
+      result[l - 1] = values[index];
+      index = predecessors[index];
+    }
+  }
+  return result;
+}
+
+vector<QueueDiff::Operation> QueueDiff::operations(Queue const &from,
+                                                  Queue const &to) {
+  vector<Operation> ops;
+
+  unordered_map<TTrackID, size_t> indices;
+  indices.reserve(to.tracks.size());
+  for (size_t i = 0; i < to.tracks.size(); i++) {
+    indices.emplace(to.tracks[i].trackId, i);
+  }
+
+  // remove tracks and update votes, remember the new positions of the
+  // remaining tracks in their old order
+  vector<size_t> kept;
+  vector<bool> existed(to.tracks.size(), false);
+  kept.reserve(from.tracks.size());
+  for (auto &&track : from.tracks) {
+    auto it = indices.find(track.trackId);
+    if (it == indices.end()) {
+      ops.push_back({Operation::Type::Remove, &track, nullptr});
+      continue;
+    }
+
+    auto const &updated = to.tracks[it->second];
+    if (updated.votes != track.votes) {
+      ops.push_back({Operation::Type::Votes, &updated, nullptr});
+    }
+    kept.push_back(it->second);
+    existed[it->second] = true;
+  }
+
+  // the largest set of tracks which are already in the right order stays,
+  // all others are moved or inserted behind their new predecessor
+  vector<bool> stays(to.tracks.size(), false);
+  for (auto index : longestIncreasingSubsequence(kept)) {
+    stays[index] = true;
+  }
+  for (size_t i = 0; i < to.tracks.size(); i++) {
+    if (stays[i]) {
+      continue;
+    }
+
+    auto type = existed[i] ? Operation::Type::Move : Operation::Type::Insert;
+    auto after = (i == 0) ? nullptr : &to.tracks[i - 1];
+    ops.push_back({type, &to.tracks[i], after});
+  }
+
+  return ops;
+}
+
+json QueueDiff::diff(Queue const &from, Queue const &to) {
+  json ops = json::array();
+  for (auto &&op : operations(from, to)) {
+    auto const &track = *op.track;
+    json after = op.after ? json(op.after->trackId) : json(nullptr);
+    switch (op.type) {
+      case Operation::Type::Remove:
+        ops.push_back(json::array({"remove", track.trackId}));
+        break;
+      case Operation::Type::Votes:
+        ops.push_back(json::array({"votes", track.trackId, track.votes}));
+        break;
+      case Operation::Type::Move:
+        ops.push_back(json::array({"move", track.trackId, after}));
+        break;
+      case Operation::Type::Insert:
+        ops.push_back(
+            json::array({"insert", after, Serializer::serialize(track)}));
+        break;
+    }
+  }
+  return ops;
+}
+
+void QueueDiff::write(vector<Operation> const &ops, JsonWriter &writer) {
+  auto writeAfter = [&](Operation const &op) {
+    if (op.after) {
+      writer.value(op.after->trackId);
+    } else {
+      writer.nullValue();
+    }
+  };
+
+  writer.beginArray();
+  for (auto &&op : ops) {
+    auto const &track = *op.track;
+    writer.beginArray();
+    switch (op.type) {
+      case Operation::Type::Remove:
+        writer.value("remove").value(track.trackId);
+        break;
+      case Operation::Type::Votes:
+        writer.value("votes").value(track.trackId).value(track.votes);
+        break;
+      case Operation::Type::Move:
+        writer.value("move").value(track.trackId);
+        writeAfter(op);
+        break;
+      case Operation::Type::Insert:
+        writer.value("insert");
+        writeAfter(op);
+        Serializer::serialize(track, writer);
+        break;
+    }
+    writer.endArray();
+  }
+  writer.endArray();
+}
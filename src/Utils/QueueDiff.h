@@ -0,0 +1,65 @@
+/*****************************************************************************/
+/**
+ * @file    QueueDiff.h
+ * @author  Team Server
+ * @brief   Class QueueDiff definition
+ */
+/*****************************************************************************/
+
+#ifndef _QUEUE_DIFF_H_
+#define _QUEUE_DIFF_H_
+
+#include <vector>
+
+#include "Types/Queue.h"
+#include "Utils/JsonWriter.h"
+#include "json/json.hpp"
+
+/**
+ * @brief Describes the changes between two versions of a queue as a list of
+ * operations, which is much smaller than the queue itself.
+ * @details The operations have to be applied in the given order:
+ *  - `["remove", track_id]` removes the track.
+ *  - `["votes", track_id, votes]` sets the number of votes of the track.
+ *  - `["move", track_id, after_id]` moves the track directly behind the track
+ *    `after_id`, or to the front if `after_id` is `null`.
+ *  - `["insert", after_id, track]` inserts the track, positioned as for
+ *    `move`.
+ *
+ * Tracks which keep their relative order are not moved, so a single changed
+ * vote results in at most two operations.
+ */
+class QueueDiff {
+ public:
+  /**
+   * @brief A single operation, referencing the tracks of the compared queues.
+   */
+  struct Operation {
+    enum class Type { Remove, Votes, Move, Insert };
+
+    Type type;
+    // track of `from` for Remove, of `to` otherwise
+    QueuedTrack const *track;
+    // predecessor in `to` for Move and Insert, nullptr for the front
+    QueuedTrack const *after;
+  };
+
+  /**
+   * @brief Returns the operations transforming `from` into `to`.
+   */
+  static nlohmann::json diff(Queue const &from, Queue const &to);
+
+  /**
+   * @brief Returns the same operations as `diff`, without serializing them.
+   * @details The operations point into both queues, which therefore have to
+   * outlive them.
+   */
+  static std::vector<Operation> operations(Queue const &from, Queue const &to);
+
+  /**
+   * @brief Writes the operations as the same JSON array as `diff`.
+   */
+  static void write(std::vector<Operation> const &ops, JsonWriter &writer);
+};
+
+#endif /* _QUEUE_DIFF_H_ */
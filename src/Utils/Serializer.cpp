@@ -41,3 +41,120 @@ json Serializer::serialize<PlaybackTrack>(PlaybackTrack const &track) {
   result["playing_for"] = track.progressMs;
   return result;
 }
+
+template <>
+json Serializer::serialize<Queue>(Queue const &queue) {
+  json result = json::array();
+  for (auto &&track : queue.tracks) {
+    result.push_back(Serializer::serialize(track));
+  }
+  return result;
+}
+
+// The writer versions emit the keys in the same (sorted) order as
+// nlohmann::json does, so both produce exactly the same output.
+
+template <typename Writer>
+static void writeBaseHead(BaseTrack const &track, Writer &writer) {
+  writer.key("added_by").value(track.addedBy);
+  writer.key("album").value(track.album);
+  writer.key("artist").value(track.artist);
+}
+
+template <typename Writer>
+static void writeBaseMiddle(BaseTrack const &track, Writer &writer) {
+  writer.key("duration").value(track.durationMs);
+  writer.key("icon_uri").value(track.iconUri);
+}
+
+template <typename Writer>
+static void writeBaseTail(BaseTrack const &track, Writer &writer) {
+  writer.key("title").value(track.title);
+  writer.key("track_id").value(track.trackId);
+}
+
+template <typename Writer>
+static void writeTrack(BaseTrack const &track, Writer &writer) {
+  writer.beginObject();
+  writeBaseHead(track, writer);
+  writeBaseMiddle(track, writer);
+  writeBaseTail(track, writer);
+  writer.endObject();
+}
+
+template <typename Writer>
+static void writeTrack(QueuedTrack const &track, Writer &writer) {
+  writer.beginObject();
+  writeBaseHead(track, writer);
+  writer.key("current_vote").value(track.userHasVoted ? 1 : 0);
+  writeBaseMiddle(track, writer);
+  writeBaseTail(track, writer);
+  writer.key("votes").value(track.votes);
+  writer.endObject();
+}
+
+template <typename Writer>
+static void writeTrack(PlaybackTrack const &track, Writer &writer) {
+  writer.beginObject();
+  writeBaseHead(track, writer);
+  writeBaseMiddle(track, writer);
+  writer.key("playing").value(track.isPlaying);
+  writer.key("playing_for").value(track.progressMs);
+  writeBaseTail(track, writer);
+  writer.endObject();
+}
+
+template <typename Writer>
+static void writeQueue(Queue const &queue, Writer &writer) {
+  writer.beginArray(queue.tracks.size());
+  for (auto &&track : queue.tracks) {
+    writeTrack(track, writer);
+  }
+  writer.endArray();
+}
+
+template <>
+void Serializer::serialize<BaseTrack>(BaseTrack const &track,
+                                      JsonWriter &writer) {
+  writeTrack(track, writer);
+}
+
+template <>
+void Serializer::serialize<BaseTrack>(BaseTrack const &track,
+                                      BinaryWriter &writer) {
+  writeTrack(track, writer);
+}
+
+template <>
+void Serializer::serialize<QueuedTrack>(QueuedTrack const &track,
+                                        JsonWriter &writer) {
+  writeTrack(track, writer);
+}
+
+template <>
+void Serializer::serialize<QueuedTrack>(QueuedTrack const &track,
+                                        BinaryWriter &writer) {
+  writeTrack(track, writer);
+}
+
+template <>
+void Serializer::serialize<PlaybackTrack>(PlaybackTrack const &track,
+                                          JsonWriter &writer) {
+  writeTrack(track, writer);
+}
+
+template <>
+void Serializer::serialize<PlaybackTrack>(PlaybackTrack const &track,
+                                          BinaryWriter &writer) {
+  writeTrack(track, writer);
+}
+
+template <>
+void Serializer::serialize<Queue>(Queue const &queue, JsonWriter &writer) {
+  writeQueue(queue, writer);
+}
+
+template <>
+void Serializer::serialize<Queue>(Queue const &queue, BinaryWriter &writer) {
+  writeQueue(queue, writer);
+}
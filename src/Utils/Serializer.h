@@ -8,6 +8,8 @@
 #ifndef _SERIALIZER_H_
 #define _SERIALIZER_H_
 
+#include "Utils/BinaryWriter.h"
+#include "Utils/JsonWriter.h"
 #include "json/json.hpp"
 
 /**
@@ -18,6 +20,20 @@ class Serializer {
  public:
   template <class T>
   static nlohmann::json serialize(T const &);
+
+  /**
+   * @brief Writes the same JSON as `serialize(T const &)`, but directly into
+   * the output of the writer, without creating a JSON document first.
+   */
+  template <class T>
+  static void serialize(T const &, JsonWriter &writer);
+
+  /**
+   * @brief Writes the same data as `serialize(T const &, JsonWriter &)` in
+   * the format of the writer.
+   */
+  template <class T>
+  static void serialize(T const &, BinaryWriter &writer);
 };
 
 #endif /* _SERIALIZER_H_ */
@@ -9,11 +9,26 @@
 #include "SimpleScheduler.h"
 
 #include "Types/GlobalTypes.h"
+#include "Utils/QueueDiff.h"
+#include "Utils/Serializer.h"
 
 using namespace std;
+using json = nlohmann::json;
+
+/**
+ * @brief Serializes the track, an empty object if there is none.
+ */
+static json serializeCurrentTrack(optional<QueuedTrack> const &track) {
+  if (!track.has_value()) {
+    return json::object();
+  }
+  return Serializer::serialize<BaseTrack>(track.value());
+}
 
 SimpleScheduler::SimpleScheduler(DataStore *const datastore,
-                                 MusicBackend *const musicbackend) {
+                                 MusicBackend *const musicbackend,
+                                 ChangeNotifier *const notifier,
+                                 EventBroadcaster *const events) {
   if (datastore == nullptr)
     LOG(ERROR) << "TrackScheduler Ctor: datastore is nullptr!";
   if (musicbackend == nullptr)
@@ -21,6 +36,8 @@ SimpleScheduler::SimpleScheduler(DataStore *const datastore,
 
   mDataStore = datastore;
   mMusicBackend = musicbackend;
+  mChangeNotifier = notifier;
+  mEvents = events;
 }
 
 SimpleScheduler::~SimpleScheduler() {
@@ -33,6 +50,8 @@ SimpleScheduler::~SimpleScheduler() {
    */
   mDataStore = nullptr;
   mMusicBackend = nullptr;
+  mChangeNotifier = nullptr;
+  mEvents = nullptr;
 }
 
 void SimpleScheduler::start() {
@@ -96,7 +115,7 @@ TResultOpt SimpleScheduler::doSchedule() {
                  "SimpleScheduler.doSchedule: nullpointer Fatal Error");
   }
 
-  this_thread::sleep_for(chrono::milliseconds(cScheduleIntervalTimeMs));
+  waitForNextSchedule();
 
   TResult<std::optional<PlaybackTrack>> playbackTrackRet;
   playbackTrackRet = mMusicBackend->getCurrentPlayback();
@@ -110,7 +129,7 @@ TResultOpt SimpleScheduler::doSchedule() {
       LOG(ERROR) << "SimpleScheduler.doSchedule: " << error->getErrorMessage();
       return std::nullopt;
     }
-    mLastPlaybackTrack = playbackTrackRet;
+    setLastPlayback(playbackTrackRet);
     return *error;
   }
 
@@ -216,31 +235,120 @@ TResultOpt SimpleScheduler::doSchedule() {
       }
     } break;
   }
-  mLastPlaybackTrack = playbackTrackRet;
+  setLastPlayback(playbackTrackRet);
 
   return nullopt;
 }
 
-TResult<bool> SimpleScheduler::areQueuesEmpty() {
-  auto adminQueRet = mDataStore->getQueue(QueueType::Admin);
-  if (auto error = std::get_if<Error>(&adminQueRet)) {
-    return *error;
+void SimpleScheduler::waitForNextSchedule() {
+  auto deadline = chrono::steady_clock::now() +
+                  chrono::milliseconds(cScheduleIntervalTimeMs);
+  if (mChangeNotifier == nullptr || mEvents == nullptr) {
+    this_thread::sleep_until(deadline);
+    return;
   }
-  auto adminQueue = std::get<Queue>(adminQueRet);
-  if (!adminQueue.tracks.empty()) {
-    return false;
+
+  // publish every change right away instead of once per interval
+  auto version = mChangeNotifier->getVersion();
+  publishQueues();
+  for (auto now = chrono::steady_clock::now(); now < deadline;
+       now = chrono::steady_clock::now()) {
+    auto timeout = chrono::ceil<chrono::milliseconds>(deadline - now);
+    auto current = mChangeNotifier->waitForChange(version, timeout);
+    if (current != version) {
+      version = current;
+      publishQueues();
+    }
   }
+}
 
-  auto normalQueueRet = mDataStore->getQueue(QueueType::Normal);
-  if (auto error = std::get_if<Error>(&normalQueueRet)) {
-    return *error;
+void SimpleScheduler::publishQueues() {
+  auto snapshotRet = mDataStore->getQueueSnapshot();
+  if (auto error = std::get_if<Error>(&snapshotRet)) {
+    LOG(ERROR) << "SimpleScheduler: " << error->getErrorMessage();
+    return;
   }
-  auto normalQueue = std::get<Queue>(normalQueueRet);
-  if (!normalQueue.tracks.empty()) {
-    return false;
+  auto snapshot = std::get<TQueueSnapshot>(snapshotRet);
+  if (mPublishedQueues && mPublishedQueues->version == snapshot->version) {
+    return;
+  }
+
+  // new subscribers start with the whole queues, all others only get the
+  // changes
+  json state = {
+      {"version", snapshot->version},
+      {"currently_playing", serializeCurrentTrack(snapshot->currentTrack)},
+      {"normal_queue", Serializer::serialize(snapshot->normalQueue)},
+      {"admin_queue", Serializer::serialize(snapshot->adminQueue)}};
+  auto stateEvent = EventBroadcaster::formatEvent("queues", state.dump());
+  if (!mPublishedQueues) {
+    mEvents->publish(stateEvent, stateEvent);
+    mPublishedQueues = snapshot;
+    return;
+  }
+
+  auto const &published = *mPublishedQueues;
+  json diff = {
+      {"base_version", published.version},
+      {"version", snapshot->version},
+      {"normal_queue",
+       QueueDiff::diff(published.normalQueue, snapshot->normalQueue)},
+      {"admin_queue",
+       QueueDiff::diff(published.adminQueue, snapshot->adminQueue)}};
+  auto const &before = published.currentTrack;
+  auto const &after = snapshot->currentTrack;
+  if (before.has_value() != after.has_value() ||
+      (after.has_value() && before->trackId != after->trackId)) {
+    diff["currently_playing"] = serializeCurrentTrack(after);
   }
 
-  return true;
+  mEvents->publish(EventBroadcaster::formatEvent("queues_diff", diff.dump()),
+                   move(stateEvent));
+  mPublishedQueues = snapshot;
+}
+
+void SimpleScheduler::setLastPlayback(
+    TResult<std::optional<PlaybackTrack>> const &playback) {
+  // must be called with mMtxPlayback held, the progress of a track does not
+  // count as a change
+  auto isChanged = [&]() {
+    if (playback.index() != mLastPlaybackTrack.index()) {
+      return true;
+    }
+    auto last = std::get_if<std::optional<PlaybackTrack>>(&mLastPlaybackTrack);
+    auto current = std::get_if<std::optional<PlaybackTrack>>(&playback);
+    if (last == nullptr) {
+      return false;
+    }
+    if (last->has_value() != current->has_value()) {
+      return true;
+    }
+    return last->has_value() &&
+           ((*last)->trackId != (*current)->trackId ||
+            (*last)->isPlaying != (*current)->isPlaying);
+  };
+
+  bool changed = isChanged();
+  mLastPlaybackTrack = playback;
+  if (changed && mChangeNotifier != nullptr) {
+    mChangeNotifier->notify();
+  }
+
+  // tick the progress of the playback to all subscribers
+  auto current = std::get_if<std::optional<PlaybackTrack>>(&playback);
+  if (mEvents != nullptr && current != nullptr) {
+    json tick = json::object();
+    if (current->has_value()) {
+      tick = {{"track_id", (*current)->trackId},
+              {"playing", (*current)->isPlaying},
+              {"playing_for", (*current)->progressMs}};
+    }
+    mEvents->publish(EventBroadcaster::formatEvent("playback", tick.dump()));
+  }
+}
+
+TResult<bool> SimpleScheduler::areQueuesEmpty() {
+  return mDataStore->isEmpty();
 }
 
 TResult<bool> SimpleScheduler::isTrackPlaying(
@@ -17,13 +17,24 @@
 #include "DataStore.h"
 #include "MusicBackend.h"
 #include "Types/Result.h"
+#include "Utils/ChangeNotifier.h"
+#include "Utils/EventBroadcaster.h"
 
 /**
  * @brief A simple track scheduler (for presentation purposes).
  */
 class SimpleScheduler {
  public:
-  SimpleScheduler(DataStore* const datastore, MusicBackend* const musicbackend);
+  /**
+   * @param notifier Is notified when the playback changes (another track or
+   * paused/resumed), may be `nullptr`.
+   * @param events Receives the changes of the queues and the polled playback
+   * (see RestAPI events), may be `nullptr`.
+   */
+  SimpleScheduler(DataStore* const datastore,
+                  MusicBackend* const musicbackend,
+                  ChangeNotifier* const notifier,
+                  EventBroadcaster* const events);
   ~SimpleScheduler();
 
   /**
@@ -73,12 +84,29 @@ class SimpleScheduler {
    */
   void threadFunc();
 
+  /**
+   * @brief Waits for the next schedule interval, changes of the queues are
+   * published in the meantime.
+   */
+  void waitForNextSchedule();
+
+  /**
+   * @brief Publishes the difference between the last published queues and the
+   * current ones.
+   */
+  void publishQueues();
+
+  void setLastPlayback(TResult<std::optional<PlaybackTrack>> const& playback);
   TResult<bool> areQueuesEmpty();
   TResult<bool> isTrackPlaying(std::optional<PlaybackTrack> const& currentOpt);
   TResult<bool> isTrackFinished(std::optional<PlaybackTrack> const& currentOpt);
 
   DataStore* mDataStore;
   MusicBackend* mMusicBackend;
+  ChangeNotifier* mChangeNotifier;
+  EventBroadcaster* mEvents;
+  // only accessed by the scheduler thread
+  TQueueSnapshot mPublishedQueues;
   SchedulerState mSchedulerState = SchedulerState::Idle;
   TResult<std::optional<PlaybackTrack>> mLastPlaybackTrack;
 
@@ -0,0 +1,160 @@
+/*****************************************************************************/
+/**
+ * @file    Test_BinaryWriter.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class BinaryWriter
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "TrackGenerator.h"
+#include "Utils/BinaryWriter.h"
+#include "Utils/Serializer.h"
+#include "json/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+static string encode(json const &document, BinaryFormat format) {
+  auto bytes = (format == BinaryFormat::MessagePack)
+                   ? json::to_msgpack(document)
+                   : json::to_cbor(document);
+  return string(bytes.begin(), bytes.end());
+}
+
+/**
+ * @brief Checks that the writer creates the same output as nlohmann::json in
+ * both formats.
+ */
+template <typename Write>
+static void assertSameAsJson(json const &expected, Write write) {
+  for (auto format : {BinaryFormat::MessagePack, BinaryFormat::Cbor}) {
+    string out;
+    BinaryWriter writer(out, format);
+    write(writer);
+    ASSERT_EQ(out, encode(expected, format));
+  }
+}
+
+TEST(BinaryWriter, Structure) {
+  json expected = {{"array", {1, true, nullptr, json::object(), json::array()}},
+                   {"float", 1.5},
+                   {"string", "text"}};
+
+  assertSameAsJson(expected, [](BinaryWriter &writer) {
+    writer.beginObject()
+        .key("array")
+        .beginArray()
+        .value(1)
+        .value(true)
+        .nullValue()
+        .beginObject()
+        .endObject()
+        .beginArray(0)
+        .endArray()
+        .endArray()
+        .key("float")
+        .value(1.5)
+        .key("string")
+        .value("text")
+        .endObject();
+  });
+
+  // already encoded values are counted as a single element
+  string raw;
+  BinaryWriter(raw, BinaryFormat::MessagePack).value(2);
+  string out;
+  BinaryWriter(out, BinaryFormat::MessagePack)
+      .beginArray()
+      .raw(raw)
+      .value(3)
+      .endArray();
+  ASSERT_EQ(out, encode({2, 3}, BinaryFormat::MessagePack));
+}
+
+TEST(BinaryWriter, Integers) {
+  vector<uint64_t> const unsignedValues = {
+      0,          23,         24,         127,
+      128,        255,        256,        65535,
+      65536,      4294967295, 4294967296, numeric_limits<uint64_t>::max()};
+  for (auto value : unsignedValues) {
+    assertSameAsJson(value, [=](BinaryWriter &w) { w.value(value); });
+  }
+
+  vector<int64_t> const negativeValues = {
+      -1,     -24,    -25,         -32,         -33,
+      -128,   -129,   -32768,      -32769,      -2147483648LL,
+      -2147483649LL,  numeric_limits<int64_t>::min()};
+  for (auto value : negativeValues) {
+    assertSameAsJson(value, [=](BinaryWriter &w) { w.value(value); });
+  }
+}
+
+TEST(BinaryWriter, Lengths) {
+  for (size_t length : {0, 23, 24, 31, 32, 255, 256, 65535, 65536}) {
+    string str(length, 'a');
+    assertSameAsJson(str, [&](BinaryWriter &w) { w.value(str); });
+
+    // the head of containers is written when they are ended
+    json array = json::array();
+    for (size_t i = 0; i < length; i++) {
+      array.push_back(i % 2);
+    }
+    assertSameAsJson(array, [=](BinaryWriter &w) {
+      w.beginArray();
+      for (size_t i = 0; i < length; i++) {
+        w.value(i % 2);
+      }
+      w.endArray();
+    });
+    assertSameAsJson(array, [=](BinaryWriter &w) {
+      w.beginArray(length);
+      for (size_t i = 0; i < length; i++) {
+        w.value(i % 2);
+      }
+      w.endArray();
+    });
+
+    // keys are sorted like the ones of nlohmann::json
+    json object = json::object();
+    vector<string> keys;
+    for (size_t i = 0; i < length; i++) {
+      keys.push_back(to_string(100000 + i));
+      object[keys.back()] = i;
+    }
+    assertSameAsJson(object, [&](BinaryWriter &w) {
+      w.beginObject();
+      for (size_t i = 0; i < length; i++) {
+        w.key(keys[i]).value(i);
+      }
+      w.endObject();
+    });
+  }
+}
+
+TEST(BinaryWriter, SameAsSerializer) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(20, 5, true);
+  status.normalQueue.tracks[1].userHasVoted = true;
+
+  assertSameAsJson(Serializer::serialize(status.normalQueue),
+                   [&](BinaryWriter &writer) {
+                     Serializer::serialize(status.normalQueue, writer);
+                   });
+  assertSameAsJson(Serializer::serialize(status.currentTrack.value()),
+                   [&](BinaryWriter &writer) {
+                     Serializer::serialize(status.currentTrack.value(),
+                                           writer);
+                   });
+
+  BaseTrack const &track = status.adminQueue.tracks[0];
+  assertSameAsJson(Serializer::serialize(track), [&](BinaryWriter &writer) {
+    Serializer::serialize(track, writer);
+  });
+}
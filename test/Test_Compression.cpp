@@ -0,0 +1,118 @@
+/*****************************************************************************/
+/**
+ * @file    Test_Compression.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class Compression
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/Network/QueueBodyCache.h"
+#include "TrackGenerator.h"
+#include "Utils/Compression.h"
+#include "Utils/JsonWriter.h"
+
+using namespace std;
+
+/**
+ * @brief Decompresses gzip or deflate data, checking its checksum.
+ */
+static string decompress(string const &data, ContentEncoding encoding) {
+  z_stream stream = {};
+  int windowBits = (encoding == ContentEncoding::Gzip) ? MAX_WBITS + 16
+                                                       : MAX_WBITS;
+  EXPECT_EQ(inflateInit2(&stream, windowBits), Z_OK);
+
+  string out;
+  char buffer[4096];
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+  stream.avail_in = data.size();
+  int result;
+  do {
+    stream.next_out = reinterpret_cast<Bytef *>(buffer);
+    stream.avail_out = sizeof(buffer);
+    result = inflate(&stream, Z_NO_FLUSH);
+    out.append(buffer, sizeof(buffer) - stream.avail_out);
+  } while (result == Z_OK);
+  inflateEnd(&stream);
+
+  EXPECT_EQ(result, Z_STREAM_END);
+  EXPECT_EQ(stream.avail_in, 0);
+  return out;
+}
+
+TEST(Compression, Compress) {
+  string body;
+  for (int i = 0; i < 1000; i++) {
+    body += "{\"track_id\":\"" + to_string(i) + "\",\"votes\":0},";
+  }
+
+  for (auto encoding : {ContentEncoding::Gzip, ContentEncoding::Deflate}) {
+    auto compressed = Compression::compress(body, {}, encoding);
+    ASSERT_LT(compressed.size() * 4, body.size());
+    ASSERT_EQ(decompress(compressed, encoding), body);
+
+    ASSERT_EQ(decompress(Compression::compress("", {}, encoding), encoding),
+              "");
+  }
+}
+
+TEST(Compression, CachedSegments) {
+  string body(5000, 'a');
+  for (size_t i = 0; i < body.size(); i += 7) {
+    body[i] = 'b' + (i % 13);
+  }
+
+  // segments at the start, in the middle, next to each other and at the end
+  vector<BodySegment> segments = {
+      {0, 100, make_shared<CachedSegment const>()},
+      {1000, 500, make_shared<CachedSegment const>()},
+      {1500, 1, make_shared<CachedSegment const>()},
+      {4000, 1000, make_shared<CachedSegment const>()}};
+
+  for (auto encoding : {ContentEncoding::Gzip, ContentEncoding::Deflate}) {
+    auto compressed = Compression::compress(body, segments, encoding);
+    ASSERT_EQ(decompress(compressed, encoding), body);
+  }
+
+  // the cached segments are compressed only once
+  auto cached = segments[1].cached->get("ignored").data;
+  ASSERT_EQ(cached, Compression::compressSegment(body.substr(1000, 500)).data);
+}
+
+TEST(Compression, QueueBodyCache) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(100, 40, false);
+  status.queueVersion = 1;
+  for (auto &track : status.normalQueue.tracks) {
+    track.userHasVoted = false;
+  }
+  status.normalQueue.tracks[5].userHasVoted = true;
+  status.normalQueue.tracks[99].userHasVoted = true;
+
+  QueueBodyCache cache;
+  auto entry = cache.get(status);
+
+  string body;
+  vector<BodySegment> segments;
+  JsonWriter writer(body);
+  writer.beginObject().key("admin_queue");
+  entry->appendAdminQueue(writer, &segments);
+  writer.key("normal_queue");
+  entry->appendNormalQueue(status.normalQueue, writer, &segments);
+  writer.endObject();
+
+  // only the segments without votes of the user are taken from the cache
+  auto nrOfSegments = 100 / QueueBodyCache::Entry::cTracksPerSegment + 1;
+  ASSERT_EQ(segments.size(), 1 + nrOfSegments - 2);
+
+  auto compressed =
+      Compression::compress(body, segments, ContentEncoding::Gzip);
+  ASSERT_EQ(decompress(compressed, ContentEncoding::Gzip), body);
+}
@@ -0,0 +1,78 @@
+/*****************************************************************************/
+/**
+ * @file    Test_ConcurrencyLimit.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class ConcurrencyLimit
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/Utils/ConcurrencyLimit.h"
+
+using namespace std;
+
+TEST(ConcurrencyLimit, AcquireAndRelease) {
+  ConcurrencyLimit limit(2);
+  ASSERT_EQ(limit.getLimit(), 2);
+
+  auto first = limit.tryAcquire();
+  auto second = limit.tryAcquire();
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  ASSERT_EQ(limit.getActive(), 2);
+  ASSERT_EQ(limit.tryAcquire(), nullptr);
+
+  // copies share the slot
+  auto copy = first;
+  first = nullptr;
+  ASSERT_EQ(limit.tryAcquire(), nullptr);
+  copy = nullptr;
+  ASSERT_EQ(limit.getActive(), 1);
+  ASSERT_NE(limit.tryAcquire(), nullptr);
+  ASSERT_EQ(limit.getActive(), 1);
+}
+
+TEST(ConcurrencyLimit, OutlivesLimit) {
+  auto limit = make_unique<ConcurrencyLimit>(1);
+  auto slot = limit->tryAcquire();
+  limit = nullptr;
+  // releasing the slot must not access the destroyed limit
+  slot = nullptr;
+}
+
+TEST(ConcurrencyLimit, Concurrent) {
+  size_t const nrSlots = 4;
+  size_t const nrThreads = 8;
+  ConcurrencyLimit limit(nrSlots);
+  atomic<size_t> held{0};
+  atomic<size_t> maxHeld{0};
+
+  vector<thread> threads;
+  for (size_t t = 0; t < nrThreads; t++) {
+    threads.emplace_back([&]() {
+      for (size_t i = 0; i < 10000; i++) {
+        auto slot = limit.tryAcquire();
+        if (!slot) {
+          continue;
+        }
+        auto now = ++held;
+        auto max = maxHeld.load();
+        while (now > max && !maxHeld.compare_exchange_weak(max, now)) {
+        }
+        held--;
+      }
+    });
+  }
+  for (auto &&t : threads) {
+    t.join();
+  }
+
+  ASSERT_LE(maxHeld.load(), nrSlots);
+  ASSERT_EQ(limit.getActive(), 0);
+}
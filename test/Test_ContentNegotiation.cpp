@@ -0,0 +1,80 @@
+/*****************************************************************************/
+/**
+ * @file    Test_ContentNegotiation.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class ContentNegotiation
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../src/Network/ContentNegotiation.h"
+#include "json/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+TEST(ContentNegotiation, NegotiateFormat) {
+  auto negotiate = ContentNegotiation::negotiateFormat;
+
+  ASSERT_EQ(negotiate(""), ResponseFormat::Json);
+  ASSERT_EQ(negotiate("*/*"), ResponseFormat::Json);
+  ASSERT_EQ(negotiate("text/html"), ResponseFormat::Json);
+  ASSERT_EQ(negotiate("application/msgpack"), ResponseFormat::MessagePack);
+  ASSERT_EQ(negotiate("application/x-msgpack"), ResponseFormat::MessagePack);
+  ASSERT_EQ(negotiate(" Application/CBOR ; charset=x"), ResponseFormat::Cbor);
+
+  // the highest quality wins, the order decides between equal qualities
+  ASSERT_EQ(negotiate("application/json;q=0.9, application/cbor"),
+            ResponseFormat::Cbor);
+  ASSERT_EQ(negotiate("application/cbor;q=0.5,application/msgpack;q=0.8"),
+            ResponseFormat::MessagePack);
+  ASSERT_EQ(negotiate("application/msgpack, application/json"),
+            ResponseFormat::MessagePack);
+  ASSERT_EQ(negotiate("application/json, application/msgpack"),
+            ResponseFormat::Json);
+  ASSERT_EQ(negotiate("text/html, */*;q=0.1, application/cbor;q=0"),
+            ResponseFormat::Json);
+}
+
+TEST(ContentNegotiation, Encode) {
+  json body = {{"tracks", {{{"title", "Title"}, {"duration", 1234}}}},
+               {"playing", true},
+               {"version", 12345678901}};
+
+  ASSERT_EQ(ContentNegotiation::encode(body.dump(), ResponseFormat::Json),
+            body.dump());
+
+  auto msgpack =
+      ContentNegotiation::encode(body.dump(), ResponseFormat::MessagePack);
+  ASSERT_EQ(json::from_msgpack(msgpack), body);
+  ASSERT_LT(msgpack.size(), body.dump().size());
+
+  auto cbor = ContentNegotiation::encode(body.dump(), ResponseFormat::Cbor);
+  ASSERT_EQ(json::from_cbor(cbor), body);
+
+  ASSERT_EQ(ContentNegotiation::getContentType(ResponseFormat::Json),
+            "application/json");
+  ASSERT_EQ(ContentNegotiation::getContentType(ResponseFormat::MessagePack),
+            "application/msgpack");
+  ASSERT_EQ(ContentNegotiation::getContentType(ResponseFormat::Cbor),
+            "application/cbor");
+}
+
+TEST(ContentNegotiation, NegotiateEncoding) {
+  auto negotiate = ContentNegotiation::negotiateEncoding;
+
+  ASSERT_EQ(negotiate(""), ContentEncoding::Identity);
+  ASSERT_EQ(negotiate("br"), ContentEncoding::Identity);
+  ASSERT_EQ(negotiate("gzip, deflate, br"), ContentEncoding::Gzip);
+  ASSERT_EQ(negotiate("deflate, gzip"), ContentEncoding::Deflate);
+  ASSERT_EQ(negotiate("deflate;q=0.5, gzip;q=1.0"), ContentEncoding::Gzip);
+  ASSERT_EQ(negotiate("*"), ContentEncoding::Gzip);
+  ASSERT_EQ(negotiate("gzip;q=0, identity"), ContentEncoding::Identity);
+
+  ASSERT_EQ(ContentNegotiation::getEncodingName(ContentEncoding::Gzip), "gzip");
+  ASSERT_EQ(ContentNegotiation::getEncodingName(ContentEncoding::Deflate),
+            "deflate");
+}
@@ -1,10 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <iostream>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "../src/Datastore/RAMDataStore.h"
 #include "../src/Types/Result.h"
@@ -414,3 +416,450 @@ TEST(DataStoreTest, votetest) {
   restr = ds.getPlayingTrack();
   ASSERT_EQ(checkAlternativeError(restr), false);
 }
+
+TEST(DataStoreTest, RemoveTrackRemovesVotes) {
+  RAMDataStore ds;
+  BaseTrack tr1;
+  tr1.trackId = "song1";
+  BaseTrack tr2;
+  tr2.trackId = "song2";
+
+  User usr1;
+  usr1.SessionID = "usr1_sessionID";
+  usr1.ExpirationDate = time(nullptr) + 100;
+  User usr2;
+  usr2.SessionID = "usr2_sessionID";
+  usr2.ExpirationDate = time(nullptr) + 100;
+  User usr3;
+  usr3.SessionID = "usr3_sessionID";
+  usr3.ExpirationDate = time(nullptr) + 100;
+
+  ds.addTrack(tr1, QueueType::Normal);
+  ds.addTrack(tr2, QueueType::Normal);
+  ds.addUser(usr1);
+  ds.addUser(usr2);
+  ds.addUser(usr3);
+
+  ds.voteTrack(usr1.SessionID, tr1.trackId, true);
+  ds.voteTrack(usr1.SessionID, tr2.trackId, true);
+  ds.voteTrack(usr2.SessionID, tr1.trackId, true);
+
+  // removing track 1 clears it from the votes of its voters only
+  auto res = ds.removeTrack(tr1.trackId, QueueType::Normal);
+  ASSERT_EQ(checkAlternativeError(res), false);
+  auto votes1 = get<User>(ds.getUser(usr1.SessionID)).votes;
+  ASSERT_EQ(votes1.size(), 1);
+  ASSERT_EQ(votes1.count(tr2.trackId), 1);
+  ASSERT_EQ(get<User>(ds.getUser(usr2.SessionID)).votes.size(), 0);
+  ASSERT_EQ(get<User>(ds.getUser(usr3.SessionID)).votes.size(), 0);
+
+  // a removed user does not get revisited when its tracks are played
+  ds.removeUser(usr1.SessionID);
+  res = ds.removeTrack(tr2.trackId, QueueType::Normal);
+  ASSERT_EQ(checkAlternativeError(res), false);
+  ASSERT_EQ(get<Queue>(ds.getQueue(QueueType::Normal)).tracks.size(), 0);
+}
+
+TEST(DataStoreTest, VoteReordersNormalQueue) {
+  RAMDataStore ds;
+  vector<TTrackID> ids = {"song1", "song2", "song3", "song4"};
+  for (auto &&id : ids) {
+    BaseTrack tr;
+    tr.trackId = id;
+    ds.addTrack(tr, QueueType::Normal);
+  }
+
+  vector<User> users(3);
+  for (size_t i = 0; i < users.size(); i++) {
+    users[i].SessionID = "usr" + to_string(i) + "_sessionID";
+    users[i].ExpirationDate = time(nullptr) + 100;
+    ds.addUser(users[i]);
+  }
+
+  auto getOrder = [&ds]() {
+    vector<TTrackID> order;
+    auto queue = get<Queue>(ds.getQueue(QueueType::Normal));
+    for (auto &&track : queue.tracks) {
+      order.push_back(track.trackId);
+    }
+    return order;
+  };
+
+  // equal votes keep the insertion order
+  ASSERT_EQ(getOrder(), ids);
+
+  ds.voteTrack(users[0].SessionID, "song3", true);
+  ds.voteTrack(users[1].SessionID, "song3", true);
+  ds.voteTrack(users[0].SessionID, "song4", true);
+  ASSERT_EQ(getOrder(), (vector<TTrackID>{"song3", "song4", "song1", "song2"}));
+
+  // duplicate votes do not count
+  ds.voteTrack(users[2].SessionID, "song4", true);
+  ds.voteTrack(users[2].SessionID, "song4", true);
+  ASSERT_EQ(getOrder(), (vector<TTrackID>{"song3", "song4", "song1", "song2"}));
+  ds.voteTrack(users[1].SessionID, "song4", true);
+  ASSERT_EQ(getOrder(), (vector<TTrackID>{"song4", "song3", "song1", "song2"}));
+
+  // revoking votes moves the track back behind older tracks
+  ds.voteTrack(users[0].SessionID, "song3", false);
+  ds.voteTrack(users[1].SessionID, "song3", false);
+  ASSERT_EQ(getOrder(), (vector<TTrackID>{"song4", "song1", "song2", "song3"}));
+
+  auto q = get<Queue>(ds.getQueue(QueueType::Normal));
+  ASSERT_EQ(q.tracks[0].votes, 3);
+  ASSERT_EQ(q.tracks[3].votes, 0);
+
+  // the first track is played next
+  ds.nextTrack();
+  auto playing = get<optional<QueuedTrack>>(ds.getPlayingTrack());
+  ASSERT_EQ(playing.value().trackId, "song4");
+  ASSERT_EQ(getOrder(), (vector<TTrackID>{"song1", "song2", "song3"}));
+}
+
+TEST(DataStoreTest, BatchAddAndRemoveTracks) {
+  RAMDataStore ds;
+  vector<BaseTrack> tracks(4);
+  for (size_t i = 0; i < tracks.size(); i++) {
+    tracks[i].trackId = "song" + to_string(i);
+  }
+  ds.addTrack(tracks[3], QueueType::Normal);
+
+  // duplicates within the batch and in the other queue are rejected
+  vector<BaseTrack> batch = {tracks[0], tracks[1], tracks[0], tracks[3]};
+  auto res = ds.addTracks(batch, QueueType::Admin);
+  ASSERT_EQ(checkAlternativeError(res), false);
+  auto results = get<vector<TResultOpt>>(res);
+  ASSERT_EQ(results.size(), 4);
+  ASSERT_FALSE(results[0].has_value());
+  ASSERT_FALSE(results[1].has_value());
+  ASSERT_EQ(results[2]->getErrorCode(), ErrorCode::AlreadyExists);
+  ASSERT_EQ(results[3]->getErrorCode(), ErrorCode::AlreadyExists);
+
+  res = ds.addTracks({tracks[2]}, QueueType::Admin);
+  ASSERT_FALSE(get<vector<TResultOpt>>(res)[0].has_value());
+
+  User usr;
+  usr.SessionID = "usr_sessionID";
+  usr.ExpirationDate = time(nullptr) + 100;
+  ds.addUser(usr);
+  ds.voteTrack(usr.SessionID, tracks[1].trackId, true);
+
+  // the remaining tracks keep their order
+  res = ds.removeTracks({tracks[1].trackId, "unknown"}, QueueType::Admin);
+  results = get<vector<TResultOpt>>(res);
+  ASSERT_FALSE(results[0].has_value());
+  ASSERT_EQ(results[1]->getErrorCode(), ErrorCode::DoesntExist);
+
+  auto admin = get<Queue>(ds.getQueue(QueueType::Admin));
+  ASSERT_EQ(admin.tracks.size(), 2);
+  ASSERT_EQ(admin.tracks[0].trackId, tracks[0].trackId);
+  ASSERT_EQ(admin.tracks[1].trackId, tracks[2].trackId);
+  ASSERT_EQ(get<User>(ds.getUser(usr.SessionID)).votes.size(), 0);
+}
+
+TEST(DataStoreTest, BatchVoteTracks) {
+  RAMDataStore ds;
+  vector<BaseTrack> tracks(3);
+  for (size_t i = 0; i < tracks.size(); i++) {
+    tracks[i].trackId = "song" + to_string(i);
+  }
+  ds.addTracks(tracks, QueueType::Normal);
+
+  User usr;
+  usr.SessionID = "usr_sessionID";
+  usr.ExpirationDate = time(nullptr) + 100;
+  ds.addUser(usr);
+
+  auto res = ds.voteTracks(usr.SessionID, {{"song2", true},
+                                           {"song1", true},
+                                           {"song2", true},
+                                           {"song1", false}});
+  ASSERT_FALSE(res.has_value());
+
+  auto queue = get<Queue>(ds.getQueue(QueueType::Normal));
+  ASSERT_EQ(queue.tracks[0].trackId, "song2");
+  ASSERT_EQ(queue.tracks[0].votes, 1);
+  ASSERT_EQ(queue.tracks[1].trackId, "song0");
+  ASSERT_EQ(queue.tracks[2].votes, 0);
+  auto votes = get<User>(ds.getUser(usr.SessionID)).votes;
+  ASSERT_EQ(votes.size(), 1);
+  ASSERT_EQ(votes.count("song2"), 1);
+
+  res = ds.voteTracks("unknown", {{"song0", true}});
+  ASSERT_TRUE(res.has_value());
+}
+
+TEST(DataStoreTest, LocateTrack) {
+  RAMDataStore ds;
+  vector<BaseTrack> tracks(40);
+  for (size_t i = 0; i < tracks.size(); i++) {
+    tracks[i].trackId = "song" + to_string(i);
+  }
+  ds.addTracks(tracks, QueueType::Admin);
+  ASSERT_TRUE(ds.addTrack(tracks[0], QueueType::Normal).has_value());
+
+  BaseTrack normal;
+  normal.trackId = "normal";
+  ds.addTrack(normal, QueueType::Normal);
+  auto locate = [&ds](TTrackID const &ID) {
+    return get<optional<QueueType>>(ds.locateTrack(ID));
+  };
+  ASSERT_EQ(locate("song5"), QueueType::Admin);
+  ASSERT_EQ(locate("normal"), QueueType::Normal);
+  ASSERT_EQ(locate("unknown"), nullopt);
+
+  // removing most tracks from the middle keeps the remaining ones locatable
+  // and in order
+  for (size_t i = 1; i < tracks.size() - 1; i++) {
+    if (i % 10 != 0) {
+      auto res = ds.removeTrack(tracks[i].trackId, QueueType::Admin);
+      ASSERT_EQ(checkAlternativeError(res), false);
+      ASSERT_EQ(locate(tracks[i].trackId), nullopt);
+    }
+  }
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Admin)), 5);
+  ASSERT_TRUE(get<bool>(ds.hasTrack("song30", QueueType::Admin)));
+  ASSERT_FALSE(get<bool>(ds.hasTrack("song30", QueueType::Normal)));
+
+  vector<TTrackID> expected = {"song0", "song10", "song20", "song30",
+                               "song39"};
+  for (auto &&ID : expected) {
+    ASSERT_EQ(locate(ID), QueueType::Admin);
+    ds.nextTrack();
+    auto playing = get<optional<QueuedTrack>>(ds.getPlayingTrack());
+    ASSERT_EQ(playing.value().trackId, ID);
+    ASSERT_EQ(locate(ID), nullopt);
+  }
+  ds.nextTrack();
+  ASSERT_EQ(locate("normal"), nullopt);
+  ASSERT_TRUE(ds.isEmpty());
+}
+
+TEST(DataStoreTest, MoveTrack) {
+  RAMDataStore ds;
+  BaseTrack tr1;
+  tr1.trackId = "song1";
+  tr1.title = "title1";
+  BaseTrack tr2;
+  tr2.trackId = "song2";
+  ds.addTrack(tr1, QueueType::Normal, 10, 0);
+  ds.addTrack(tr2, QueueType::Normal, 20, 0);
+
+  User usr;
+  usr.SessionID = "usr_sessionID";
+  usr.ExpirationDate = time(nullptr) + 100;
+  ds.addUser(usr);
+  ds.voteTrack(usr.SessionID, tr1.trackId, true);
+
+  // moving requires the track in the source queue
+  auto res = ds.moveTrack(tr1.trackId, QueueType::Admin, QueueType::Normal,
+                          true);
+  ASSERT_EQ(res->getErrorCode(), ErrorCode::DoesntExist);
+  res = ds.moveTrack(tr1.trackId, QueueType::Normal, QueueType::Normal, true);
+  ASSERT_EQ(res->getErrorCode(), ErrorCode::InvalidValue);
+
+  // votes only count in the normal queue
+  res = ds.moveTrack(tr1.trackId, QueueType::Normal, QueueType::Admin, true);
+  ASSERT_FALSE(res.has_value());
+  auto admin = get<Queue>(ds.getQueue(QueueType::Admin));
+  ASSERT_EQ(admin.tracks.size(), 1);
+  ASSERT_EQ(admin.tracks[0].title, tr1.title);
+  ASSERT_EQ(admin.tracks[0].insertedAt, 10);
+  ASSERT_EQ(admin.tracks[0].votes, 0);
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Normal)), 1);
+
+  // the kept votes are counted again, the insertion time is preserved
+  res = ds.moveTrack(tr1.trackId, QueueType::Admin, QueueType::Normal, true);
+  ASSERT_FALSE(res.has_value());
+  auto normal = get<Queue>(ds.getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks[0].trackId, tr1.trackId);
+  ASSERT_EQ(normal.tracks[0].votes, 1);
+  ASSERT_EQ(normal.tracks[0].insertedAt, 10);
+  ASSERT_EQ(get<User>(ds.getUser(usr.SessionID)).votes.size(), 1);
+
+  // otherwise they are revoked
+  ds.moveTrack(tr1.trackId, QueueType::Normal, QueueType::Admin, false);
+  ds.moveTrack(tr1.trackId, QueueType::Admin, QueueType::Normal, false);
+  normal = get<Queue>(ds.getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks[0].trackId, tr1.trackId);
+  ASSERT_EQ(normal.tracks[0].votes, 0);
+  ASSERT_EQ(get<User>(ds.getUser(usr.SessionID)).votes.size(), 0);
+}
+
+TEST(DataStoreTest, QueueSnapshot) {
+  RAMDataStore ds;
+  BaseTrack tr;
+  tr.trackId = "song1";
+  ds.addTrack(tr, QueueType::Normal);
+
+  // without modifications the same snapshot is shared by all readers
+  auto snap1 = get<TQueueSnapshot>(ds.getQueueSnapshot());
+  auto snap2 = get<TQueueSnapshot>(ds.getQueueSnapshot());
+  ASSERT_EQ(snap1, snap2);
+  ASSERT_EQ(snap1->normalQueue.tracks.size(), 1);
+
+  // a modification publishes a new version, old snapshots stay untouched
+  tr.trackId = "song2";
+  ds.addTrack(tr, QueueType::Admin);
+  auto snap3 = get<TQueueSnapshot>(ds.getQueueSnapshot());
+  ASSERT_NE(snap1, snap3);
+  ASSERT_GT(snap3->version, snap1->version);
+  ASSERT_EQ(snap1->adminQueue.tracks.size(), 0);
+  ASSERT_EQ(snap3->adminQueue.tracks.size(), 1);
+
+  ds.nextTrack();
+  auto snap4 = get<TQueueSnapshot>(ds.getQueueSnapshot());
+  ASSERT_GT(snap4->version, snap3->version);
+  ASSERT_EQ(snap4->currentTrack.value().trackId, "song2");
+  ASSERT_FALSE(snap3->currentTrack.has_value());
+}
+
+TEST(DataStoreTest, NotifiesChanges) {
+  RAMDataStore ds;
+  ChangeNotifier notifier;
+  ds.setChangeNotifier(&notifier);
+  BaseTrack tr;
+  tr.trackId = "song1";
+
+  // nothing changed, so the wait times out
+  auto version = notifier.getVersion();
+  ASSERT_EQ(notifier.waitForChange(version, chrono::milliseconds(10)),
+            version);
+
+  // a waiting thread is woken up by a modification of the queues
+  thread waiter([&]() {
+    ASSERT_GT(notifier.waitForChange(version, chrono::seconds(10)), version);
+  });
+  this_thread::sleep_for(chrono::milliseconds(10));
+  ds.addTrack(tr, QueueType::Normal);
+  waiter.join();
+
+  // an outdated version returns immediately
+  ASSERT_NE(notifier.waitForChange(version, chrono::seconds(10)), version);
+
+  // failed modifications don't count as a change
+  version = notifier.getVersion();
+  ds.addTrack(tr, QueueType::Normal);
+  ASSERT_EQ(notifier.getVersion(), version);
+  ds.nextTrack();
+  ASSERT_GT(notifier.getVersion(), version);
+
+  ds.setChangeNotifier(nullptr);
+}
+
+TEST(DataStoreTest, QueueSize) {
+  RAMDataStore ds;
+  ASSERT_TRUE(ds.isEmpty());
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Admin)), 0);
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Normal)), 0);
+
+  BaseTrack tr;
+  tr.trackId = "song1";
+  ds.addTrack(tr, QueueType::Normal);
+  tr.trackId = "song2";
+  ds.addTrack(tr, QueueType::Normal);
+  tr.trackId = "song3";
+  ds.addTrack(tr, QueueType::Admin);
+  ASSERT_FALSE(ds.isEmpty());
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Admin)), 1);
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Normal)), 2);
+
+  ds.removeTrack("song1", QueueType::Normal);
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Normal)), 1);
+
+  ds.nextTrack();
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Admin)), 0);
+  ds.nextTrack();
+  ASSERT_EQ(get<size_t>(ds.getQueueSize(QueueType::Normal)), 0);
+  ASSERT_TRUE(ds.isEmpty());
+}
+
+TEST(DataStoreTest, TrackMetadata) {
+  RAMDataStore ds;
+  BaseTrack tr;
+  tr.trackId = "song1";
+  tr.title = "title";
+  tr.album = "album";
+  tr.artist = "artist";
+  tr.durationMs = 1234;
+  tr.iconUri = "uri";
+  tr.addedBy = "user1";
+  ds.addTrack(tr, QueueType::Normal);
+
+  auto q = get<Queue>(ds.getQueue(QueueType::Normal));
+  ASSERT_EQ(q.tracks.size(), 1);
+  ASSERT_EQ(q.tracks[0].title, "title");
+  ASSERT_EQ(q.tracks[0].album, "album");
+  ASSERT_EQ(q.tracks[0].artist, "artist");
+  ASSERT_EQ(q.tracks[0].durationMs, 1234);
+  ASSERT_EQ(q.tracks[0].iconUri, "uri");
+  ASSERT_EQ(q.tracks[0].addedBy, "user1");
+
+  // the playing track keeps its metadata, even if the same track gets added
+  // again by someone else
+  ds.nextTrack();
+  tr.addedBy = "user2";
+  ds.addTrack(tr, QueueType::Admin);
+  auto playing = get<optional<QueuedTrack>>(ds.getPlayingTrack());
+  ASSERT_EQ(playing.value().title, "title");
+  ASSERT_EQ(playing.value().addedBy, "user1");
+
+  auto removed = get<BaseTrack>(ds.removeTrack("song1", QueueType::Admin));
+  ASSERT_EQ(removed.title, "title");
+  ASSERT_EQ(removed.addedBy, "user2");
+}
+
+TEST(DataStoreTest, SessionIsExtended) {
+  RAMDataStore ds;
+  User usr;
+  usr.SessionID = "usr1_sessionID";
+  usr.ExpirationDate = time(nullptr) + 10;
+  ds.addUser(usr);
+
+  // activity slides the expiration date of the stored user
+  auto res = ds.isSessionExpired(usr.SessionID);
+  ASSERT_EQ(checkAlternativeError(res), false);
+  auto stored = get<User>(ds.getUser(usr.SessionID));
+  ASSERT_GE(stored.ExpirationDate,
+            time(nullptr) + DataStore::cSessionTimeoutAfterSeconds - 1);
+
+  res = ds.isSessionExpired("unknown_sessionID");
+  ASSERT_EQ(checkAlternativeError(res), true);
+}
+
+TEST(DataStoreTest, StateIsConsistent) {
+  RAMDataStore ds;
+  BaseTrack tr;
+  tr.trackId = "song";
+  tr.durationMs = 100;
+  ds.addTrack(tr, QueueType::Normal);
+  for (int i = 0; i < 8; i++) {
+    User usr;
+    usr.SessionID = "usr" + to_string(i);
+    usr.ExpirationDate = time(nullptr) + 3600;
+    ds.addUser(usr);
+  }
+
+  // the users vote while the state is copied
+  atomic<bool> stop{false};
+  thread voter([&]() {
+    for (int i = 0; !stop; i++) {
+      ds.voteTrack("usr" + to_string(i % 8), "song", (i / 8) % 2 == 0);
+    }
+  });
+
+  for (int i = 0; i < 1000; i++) {
+    TQueueSnapshot queues;
+    vector<User> users;
+    ds.getState(queues, users);
+
+    // the votes of the track match the votes of the users
+    int votes = 0;
+    for (auto &&usr : users) {
+      votes += usr.votes.count("song");
+    }
+    ASSERT_EQ(queues->normalQueue.tracks[0].votes, votes);
+  }
+  stop = true;
+  voter.join();
+}
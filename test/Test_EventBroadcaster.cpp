@@ -0,0 +1,124 @@
+/*****************************************************************************/
+/**
+ * @file    Test_EventBroadcaster.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class EventBroadcaster
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/Utils/EventBroadcaster.h"
+
+using namespace std;
+
+using TEvent = EventBroadcaster::TEvent;
+
+static chrono::milliseconds const cTimeout(5000);
+
+TEST(EventBroadcaster, FormatEvent) {
+  ASSERT_EQ(EventBroadcaster::formatEvent("queues", "{\"a\":1}"),
+            "event: queues\ndata: {\"a\":1}\n\n");
+}
+
+TEST(EventBroadcaster, SharesEvents) {
+  EventBroadcaster events;
+  uint64_t first, second;
+  ASSERT_EQ(events.subscribe(first), nullptr);
+  ASSERT_EQ(events.subscribe(second), nullptr);
+
+  events.publish("a");
+  events.publish("b", "state");
+
+  auto a = get<TEvent>(events.waitForEvent(first, cTimeout));
+  auto b = get<TEvent>(events.waitForEvent(first, cTimeout));
+  ASSERT_EQ(*a, "a");
+  ASSERT_EQ(*b, "b");
+
+  // all subscribers get the same instance
+  ASSERT_EQ(get<TEvent>(events.waitForEvent(second, cTimeout)), a);
+
+  // new subscribers start with the state and only get new events
+  uint64_t third;
+  ASSERT_EQ(*events.subscribe(third), "state");
+  events.publish("c");
+  auto c = get<TEvent>(events.waitForEvent(third, cTimeout));
+  ASSERT_EQ(*c, "c");
+}
+
+TEST(EventBroadcaster, Timeout) {
+  EventBroadcaster events;
+  uint64_t position;
+  events.subscribe(position);
+
+  auto result = events.waitForEvent(position, chrono::milliseconds(10));
+  ASSERT_EQ(get<TEvent>(result), nullptr);
+
+  // a published event wakes up the waiting subscriber
+  thread publisher([&]() {
+    this_thread::sleep_for(chrono::milliseconds(10));
+    events.publish("a");
+  });
+  result = events.waitForEvent(position, cTimeout);
+  publisher.join();
+  ASSERT_EQ(*get<TEvent>(result), "a");
+}
+
+TEST(EventBroadcaster, MissedEvents) {
+  EventBroadcaster events;
+  uint64_t position;
+  events.subscribe(position);
+
+  for (size_t i = 0; i <= EventBroadcaster::cMaxEvents; i++) {
+    events.publish(to_string(i));
+  }
+  auto result = events.waitForEvent(position, cTimeout);
+  ASSERT_TRUE(holds_alternative<Error>(result));
+  ASSERT_EQ(get<Error>(result).getErrorCode(), ErrorCode::DoesntExist);
+
+  // subscribing again resynchronizes
+  events.subscribe(position);
+  events.publish("next");
+  result = events.waitForEvent(position, cTimeout);
+  ASSERT_EQ(*get<TEvent>(result), "next");
+}
+
+TEST(EventBroadcaster, ManySubscribers) {
+  EventBroadcaster events;
+  size_t const nrSubscribers = 32;
+  size_t const nrEvents = 100;
+
+  vector<uint64_t> positions(nrSubscribers);
+  for (auto &position : positions) {
+    events.subscribe(position);
+  }
+
+  vector<size_t> received(nrSubscribers, 0);
+  vector<thread> subscribers;
+  for (size_t s = 0; s < nrSubscribers; s++) {
+    subscribers.emplace_back([&, s]() {
+      for (size_t i = 0; i < nrEvents; i++) {
+        auto result = events.waitForEvent(positions[s], cTimeout);
+        auto event = get<TEvent>(result);
+        if (event && *event == to_string(i)) {
+          received[s]++;
+        }
+      }
+    });
+  }
+  for (size_t i = 0; i < nrEvents; i++) {
+    events.publish(to_string(i));
+  }
+  for (auto &&t : subscribers) {
+    t.join();
+  }
+
+  for (auto count : received) {
+    ASSERT_EQ(count, nrEvents);
+  }
+}
@@ -0,0 +1,103 @@
+/*****************************************************************************/
+/**
+ * @file    Test_JsonWriter.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class JsonWriter
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "TrackGenerator.h"
+#include "Utils/JsonWriter.h"
+#include "Utils/Serializer.h"
+#include "json/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+static string escaped(string const &str) {
+  string out;
+  JsonWriter::appendEscaped(str, out);
+  return out;
+}
+
+TEST(JsonWriter, Structure) {
+  string out;
+  JsonWriter writer(out);
+  writer.beginObject()
+      .key("array")
+      .beginArray()
+      .value(1)
+      .value(true)
+      .nullValue()
+      .beginObject()
+      .endObject()
+      .beginArray()
+      .endArray()
+      .raw("[2,3]")
+      .endArray()
+      .key("min")
+      .value(numeric_limits<int64_t>::min())
+      .key("max")
+      .value(numeric_limits<uint64_t>::max())
+      .key("string")
+      .value("text")
+      .endObject();
+
+  ASSERT_EQ(out,
+            "{\"array\":[1,true,null,{},[],[2,3]],"
+            "\"min\":-9223372036854775808,"
+            "\"max\":18446744073709551615,\"string\":\"text\"}");
+}
+
+TEST(JsonWriter, Escaping) {
+  ASSERT_EQ(escaped(""), "");
+  ASSERT_EQ(escaped("no escaping needed at all"), "no escaping needed at all");
+  ASSERT_EQ(escaped("\"\\\b\f\n\r\t"), "\\\"\\\\\\b\\f\\n\\r\\t");
+  ASSERT_EQ(escaped(string("\x00\x01\x1f", 3)), "\\u0000\\u0001\\u001f");
+  ASSERT_EQ(escaped("Motörhead \xe2\x80\x93 Ace"),
+            "Motörhead \xe2\x80\x93 Ace");
+
+  // characters to escape at every position of a block
+  for (size_t i = 0; i < 20; i++) {
+    string str(20, 'a');
+    str[i] = '"';
+    auto expected = json(str).dump();
+    ASSERT_EQ("\"" + escaped(str) + "\"", expected);
+  }
+
+  // every single byte is escaped like nlohmann::json does
+  for (int c = 1; c < 0x80; c++) {
+    string str = "abcdefgh" + string(1, static_cast<char>(c)) + "ijklmnop";
+    ASSERT_EQ("\"" + escaped(str) + "\"", json(str).dump());
+  }
+}
+
+TEST(JsonWriter, SameAsSerializer) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(20, 5, true);
+  status.normalQueue.tracks[0].title = "\"quoted\"\n";
+  status.normalQueue.tracks[1].userHasVoted = true;
+
+  string queue;
+  JsonWriter queueWriter(queue);
+  Serializer::serialize(status.normalQueue, queueWriter);
+  ASSERT_EQ(queue, Serializer::serialize(status.normalQueue).dump());
+
+  string playback;
+  JsonWriter playbackWriter(playback);
+  Serializer::serialize(status.currentTrack.value(), playbackWriter);
+  ASSERT_EQ(playback,
+            Serializer::serialize(status.currentTrack.value()).dump());
+
+  BaseTrack const &track = status.adminQueue.tracks[0];
+  string base;
+  JsonWriter baseWriter(base);
+  Serializer::serialize(track, baseWriter);
+  ASSERT_EQ(base, Serializer::serialize(track).dump());
+}
@@ -37,3 +37,29 @@ TEST(JukeBox, generateSession) {
   string expected = "ID0" + to_string(time(nullptr));
   EXPECT_EQ(value, expected);
 }
+
+TEST(JukeBox, queueStatusTagOfPreviousRun) {
+  // the versions of a restarted server begin at the same numbers again
+  JukeBox previousRun;
+  JukeBox currentRun;
+
+  auto previousSession = previousRun.generateSession(nullopt, "previous");
+  ASSERT_EQ(checkAlternativeError(previousSession), false);
+  auto currentSession = currentRun.generateSession(nullopt, "current");
+  ASSERT_EQ(checkAlternativeError(currentSession), false);
+
+  auto previous = previousRun.getQueueStatusTag(get<string>(previousSession));
+  ASSERT_EQ(checkAlternativeError(previous), false);
+  auto current = currentRun.getQueueStatusTag(get<string>(currentSession));
+  ASSERT_EQ(checkAlternativeError(current), false);
+
+  auto previousTag = get<QueueStatusTag>(previous);
+  auto currentTag = get<QueueStatusTag>(current);
+  ASSERT_EQ(previousTag.version, currentTag.version);
+  ASSERT_EQ(previousTag.votesHash, currentTag.votesHash);
+  ASSERT_NE(previousTag.epoch, currentTag.epoch);
+
+  // the epoch stays the same within a run
+  auto again = currentRun.getQueueStatusTag(get<string>(currentSession));
+  ASSERT_EQ(get<QueueStatusTag>(again).epoch, currentTag.epoch);
+}
@@ -0,0 +1,185 @@
+/*****************************************************************************/
+/**
+ * @file    Test_Metrics.cpp
+ * @author  Team Server
+ * @brief   Test implementation for classes LatencyHistogram and Metrics
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/Utils/Metrics.h"
+
+using namespace std;
+
+static Metrics::CounterValue findCounter(string const &name) {
+  for (auto &&counter : Metrics::getInstance().getCounters()) {
+    if (counter.name == name) {
+      return counter;
+    }
+  }
+  return {};
+}
+
+static Metrics::HistogramValue findHistogram(string const &name) {
+  for (auto &&histogram : Metrics::getInstance().getHistograms()) {
+    if (histogram.name == name) {
+      return histogram;
+    }
+  }
+  return {};
+}
+
+TEST(LatencyHistogram, BucketBounds) {
+  // small values are exact
+  for (uint64_t v = 0; v < LatencyHistogram::cSubBuckets; v++) {
+    ASSERT_EQ(LatencyHistogram::getBucketUpperBound(
+                  LatencyHistogram::getBucketIndex(v)),
+              v);
+  }
+
+  // every value lies within its bucket, the relative error is bounded
+  size_t lastIndex = 0;
+  for (uint64_t v = 1; v < (uint64_t(1) << 40); v = v * 5 / 4 + 1) {
+    auto index = LatencyHistogram::getBucketIndex(v);
+    auto upper = LatencyHistogram::getBucketUpperBound(index);
+    ASSERT_GE(index, lastIndex);
+    ASSERT_LT(index, LatencyHistogram::cBuckets);
+    ASSERT_GE(upper, v);
+    ASSERT_LE(upper - v, v / LatencyHistogram::cSubBuckets);
+    lastIndex = index;
+  }
+
+  // values out of range end up in the last bucket
+  ASSERT_EQ(LatencyHistogram::getBucketIndex(UINT64_MAX),
+            LatencyHistogram::cBuckets - 1);
+}
+
+TEST(LatencyHistogram, Quantiles) {
+  LatencyHistogram histogram;
+  ASSERT_EQ(histogram.getQuantile(0.5), 0);
+
+  for (uint64_t v = 1; v <= 1000; v++) {
+    histogram.record(v * 1000);
+  }
+  ASSERT_EQ(histogram.getCount(), 1000);
+  ASSERT_EQ(histogram.getSum(), 500500000);
+
+  auto median = histogram.getQuantile(0.5);
+  ASSERT_GE(median, 500000);
+  ASSERT_LE(median, 500000 * 9 / 8);
+  auto p99 = histogram.getQuantile(0.99);
+  ASSERT_GE(p99, 990000);
+  ASSERT_LE(p99, 990000 * 9 / 8);
+  ASSERT_GE(histogram.getQuantile(1.0), 1000000);
+
+  LatencyHistogram copy(histogram);
+  copy.add(histogram);
+  ASSERT_EQ(copy.getCount(), 2000);
+  ASSERT_EQ(copy.getQuantile(0.5), median);
+}
+
+TEST(Metrics, RegisterTwice) {
+  auto &metrics = Metrics::getInstance();
+  auto id = metrics.registerCounter("test_register_total", "a=\"1\"");
+  ASSERT_EQ(metrics.registerCounter("test_register_total", "a=\"1\""), id);
+  ASSERT_NE(metrics.registerCounter("test_register_total", "a=\"2\""), id);
+}
+
+TEST(Metrics, MergesThreads) {
+  auto &metrics = Metrics::getInstance();
+  auto counter = metrics.registerCounter("test_merge_total");
+  auto histogram = metrics.registerHistogram("test_merge_duration");
+
+  size_t const nrThreads = 8;
+  size_t const nrIterations = 10000;
+  vector<thread> threads;
+  for (size_t t = 0; t < nrThreads; t++) {
+    threads.emplace_back([&]() {
+      for (size_t i = 0; i < nrIterations; i++) {
+        metrics.increment(counter);
+        metrics.record(histogram, 100);
+      }
+    });
+  }
+  // reading concurrently must be possible
+  findCounter("test_merge_total");
+  for (auto &&t : threads) {
+    t.join();
+  }
+
+  // the threads have exited, their counts must be kept
+  ASSERT_EQ(findCounter("test_merge_total").value, nrThreads * nrIterations);
+  auto merged = findHistogram("test_merge_duration").histogram;
+  ASSERT_EQ(merged.getCount(), nrThreads * nrIterations);
+  ASSERT_EQ(merged.getSum(), nrThreads * nrIterations * 100);
+
+  // the calling thread is counted as well
+  metrics.increment(counter, 5);
+  ASSERT_EQ(findCounter("test_merge_total").value,
+            nrThreads * nrIterations + 5);
+}
+
+TEST(Metrics, PrometheusText) {
+  auto &metrics = Metrics::getInstance();
+  auto first = metrics.registerCounter("test_text_total", "a=\"1\"");
+  metrics.registerGauge("test_text_gauge");
+  auto second = metrics.registerCounter("test_text_total", "a=\"2\"");
+  auto gauge = metrics.registerGauge("test_text_gauge");
+  auto histogram = metrics.registerHistogram("test_text_seconds");
+  metrics.increment(first, 2);
+  metrics.increment(second, 3);
+  metrics.set(gauge, -4);
+  for (size_t i = 0; i < 4; i++) {
+    metrics.record(histogram, 2000000000);
+  }
+
+  string text;
+  metrics.writePrometheusText(text);
+
+  // metrics with the same name are grouped
+  ASSERT_NE(text.find("# TYPE test_text_total counter\n"
+                      "test_text_total{a=\"1\"} 2\n"
+                      "test_text_total{a=\"2\"} 3\n"),
+            string::npos);
+  ASSERT_NE(text.find("# TYPE test_text_gauge gauge\n"
+                      "test_text_gauge -4\n"),
+            string::npos);
+  // histograms are exported in seconds
+  ASSERT_NE(text.find("# TYPE test_text_seconds summary\n"
+                      "test_text_seconds{quantile=\"0.5\"} 2.0"),
+            string::npos);
+  ASSERT_NE(text.find("test_text_seconds_sum 8\n"
+                      "test_text_seconds_count 4\n"),
+            string::npos);
+}
+
+TEST(Metrics, LimitReached) {
+  // must run after all other tests registering gauges
+  auto &metrics = Metrics::getInstance();
+  auto const limit = Metrics::cMaxGauges;
+  for (size_t i = 0;; i++) {
+    auto labels = "i=\"" + to_string(i) + "\"";
+    if (metrics.registerGauge("test_limit_gauge", labels) == limit) {
+      break;
+    }
+    ASSERT_LT(i, limit);
+  }
+
+  testing::internal::CaptureStderr();
+  auto dropped = metrics.registerGauge("test_limit_dropped");
+  auto log = testing::internal::GetCapturedStderr();
+  ASSERT_EQ(dropped, limit);
+  ASSERT_NE(log.find("test_limit_dropped"), string::npos);
+  ASSERT_NE(log.find("limit of " + to_string(limit)), string::npos);
+
+  // updates of the dropped gauge are ignored
+  metrics.set(dropped, 1);
+  string text;
+  metrics.writePrometheusText(text);
+  ASSERT_EQ(text.find("test_limit_dropped"), string::npos);
+}
@@ -0,0 +1,470 @@
+/*****************************************************************************/
+/**
+ * @file    Test_PersistentDataStore.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class PersistentDataStore
+ */
+/*****************************************************************************/
+
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/Datastore/Journal.h"
+#include "../src/Datastore/PersistentDataStore.h"
+#include "../src/Datastore/SnapshotFile.h"
+#include "TrackGenerator.h"
+
+using namespace std;
+
+class PersistentDataStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char dir[] = "/tmp/jukebox_journal_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    mDirectory = dir;
+  }
+
+  void TearDown() override {
+    for (auto &&file : listFiles()) {
+      unlink((mDirectory + "/" + file).c_str());
+    }
+    rmdir(mDirectory.c_str());
+  }
+
+  vector<string> listFiles() {
+    vector<string> files;
+    DIR *dir = opendir(mDirectory.c_str());
+    while (auto entry = readdir(dir)) {
+      string name = entry->d_name;
+      if (name != "." && name != "..") {
+        files.push_back(name);
+      }
+    }
+    closedir(dir);
+    sort(files.begin(), files.end());
+    return files;
+  }
+
+  string getJournalPath(uint64_t generation) {
+    return mDirectory + "/journal." + to_string(generation) + ".bin";
+  }
+
+  /**
+   * @brief Writes a journal file with the given records, numbered from
+   * `firstLsn` on.
+   */
+  void writeJournal(uint64_t generation,
+                    vector<JournalRecord> records,
+                    uint64_t firstLsn) {
+    string data(Journal::cMagic, Journal::cHeaderSize);
+    for (size_t i = 0; i < records.size(); i++) {
+      records[i].lsn = firstLsn + i;
+      Journal::encode(records[i], data);
+    }
+    ofstream journal(getJournalPath(generation), ios::binary);
+    journal.write(data.data(), data.size());
+  }
+
+  unique_ptr<PersistentDataStore> reopen() {
+    auto ds = make_unique<PersistentDataStore>();
+    auto ret = ds->open(mDirectory);
+    EXPECT_FALSE(ret.has_value());
+    return ds;
+  }
+
+  User makeUser(TSessionID const &id) {
+    User user;
+    user.SessionID = id;
+    user.Name = "name_" + id;
+    user.isAdmin = false;
+    user.ExpirationDate = time(nullptr) + 3600;
+    return user;
+  }
+
+  string mDirectory;
+  TrackGenerator mGenerator;
+};
+
+TEST_F(PersistentDataStoreTest, RestoresStateAfterRestart) {
+  auto tracks = mGenerator.generateTracks(4);
+  {
+    auto ds = reopen();
+    ASSERT_FALSE(ds->addUser(makeUser("alice")).has_value());
+    ASSERT_FALSE(ds->addUser(makeUser("bob")).has_value());
+    ASSERT_FALSE(ds->addTrack(tracks[0], QueueType::Admin).has_value());
+    for (int i = 1; i < 4; ++i) {
+      ASSERT_FALSE(ds->addTrack(tracks[i], QueueType::Normal).has_value());
+    }
+    ASSERT_FALSE(ds->voteTrack("alice", tracks[3].trackId, true).has_value());
+    ASSERT_FALSE(ds->voteTrack("bob", tracks[3].trackId, true).has_value());
+    ASSERT_FALSE(ds->voteTrack("bob", tracks[2].trackId, true).has_value());
+    ASSERT_TRUE(holds_alternative<User>(ds->removeUser("bob")));
+    ASSERT_FALSE(ds->nextTrack().has_value());
+  }
+
+  auto ds = reopen();
+  ASSERT_TRUE(ds->hasUser("alice"));
+  ASSERT_FALSE(ds->hasUser("bob"));
+  ASSERT_TRUE(get<User>(ds->getUser("alice")).votes.count(tracks[3].trackId));
+
+  auto playing = get<optional<QueuedTrack>>(ds->getPlayingTrack());
+  ASSERT_TRUE(playing.has_value());
+  ASSERT_EQ(playing->trackId, tracks[0].trackId);
+  ASSERT_EQ(playing->title, tracks[0].title);
+
+  ASSERT_EQ(get<size_t>(ds->getQueueSize(QueueType::Admin)), 0);
+  auto normal = get<Queue>(ds->getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks.size(), 3);
+  // votes stay on the tracks after the voter has been removed
+  ASSERT_EQ(normal.tracks[0].trackId, tracks[3].trackId);
+  ASSERT_EQ(normal.tracks[0].votes, 2);
+  ASSERT_EQ(normal.tracks[1].trackId, tracks[2].trackId);
+  ASSERT_EQ(normal.tracks[1].votes, 1);
+  ASSERT_EQ(normal.tracks[2].trackId, tracks[1].trackId);
+  ASSERT_EQ(normal.tracks[2].votes, 0);
+}
+
+TEST_F(PersistentDataStoreTest, RestoresMovedTracks) {
+  auto tracks = mGenerator.generateTracks(2);
+  {
+    auto ds = reopen();
+    ASSERT_FALSE(ds->addUser(makeUser("alice")).has_value());
+    ASSERT_FALSE(ds->addTrack(tracks[0], QueueType::Normal).has_value());
+    ASSERT_FALSE(ds->addTrack(tracks[1], QueueType::Normal).has_value());
+    ASSERT_FALSE(ds->voteTrack("alice", tracks[1].trackId, true).has_value());
+    ASSERT_FALSE(ds->moveTrack(tracks[0].trackId, QueueType::Normal,
+                               QueueType::Admin, false)
+                     .has_value());
+    ASSERT_FALSE(ds->moveTrack(tracks[1].trackId, QueueType::Normal,
+                               QueueType::Admin, true)
+                     .has_value());
+    ASSERT_FALSE(ds->moveTrack(tracks[1].trackId, QueueType::Admin,
+                               QueueType::Normal, true)
+                     .has_value());
+  }
+
+  auto ds = reopen();
+  auto admin = get<Queue>(ds->getQueue(QueueType::Admin));
+  ASSERT_EQ(admin.tracks.size(), 1);
+  ASSERT_EQ(admin.tracks[0].trackId, tracks[0].trackId);
+  auto normal = get<Queue>(ds->getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks.size(), 1);
+  ASSERT_EQ(normal.tracks[0].trackId, tracks[1].trackId);
+  ASSERT_EQ(normal.tracks[0].votes, 1);
+}
+
+TEST_F(PersistentDataStoreTest, IgnoresTornJournalTail) {
+  auto tracks = mGenerator.generateTracks(2);
+  {
+    auto ds = reopen();
+    ASSERT_FALSE(ds->addTrack(tracks[0], QueueType::Normal).has_value());
+    ASSERT_FALSE(ds->addTrack(tracks[1], QueueType::Normal).has_value());
+  }
+
+  // simulate a crash in the middle of writing a record
+  string record;
+  JournalRecord rec(JournalRecord::Type::RemoveTrack);
+  rec.track.trackId = tracks[0].trackId;
+  Journal::encode(rec, record);
+  ofstream journal(getJournalPath(1), ios::binary | ios::app);
+  journal.write(record.data(), record.size() - 3);
+  journal.close();
+
+  {
+    auto ds = reopen();
+    ASSERT_EQ(get<size_t>(ds->getQueueSize(QueueType::Normal)), 2);
+    // appending after the torn record must still work
+    ASSERT_FALSE(ds->nextTrack().has_value());
+  }
+
+  auto ds = reopen();
+  ASSERT_EQ(get<size_t>(ds->getQueueSize(QueueType::Normal)), 1);
+  auto playing = get<optional<QueuedTrack>>(ds->getPlayingTrack());
+  ASSERT_EQ(playing->trackId, tracks[0].trackId);
+}
+
+TEST_F(PersistentDataStoreTest, ReplayDoesNotRemoveExtendedSessions) {
+  auto tracks = mGenerator.generateQueuedTracks(1);
+  tracks[0].votes = 0;
+  time_t expired = time(nullptr) - 2 * DataStore::cSessionRemovedAfterSeconds;
+
+  // alice's session had been expired when the snapshot was taken, but it has
+  // been extended before she voted
+  QueueSnapshot queues;
+  queues.normalQueue.tracks = tracks;
+  User alice = makeUser("alice");
+  alice.ExpirationDate = expired;
+  ASSERT_FALSE(SnapshotFile::write(mDirectory + "/snapshot.bin", queues,
+                                   {alice}, 1)
+                   .has_value());
+
+  vector<JournalRecord> records;
+  // adding a user removes expired sessions
+  JournalRecord rec(JournalRecord::Type::AddUser);
+  rec.user = makeUser("bob");
+  rec.user.ExpirationDate = expired;
+  records.push_back(rec);
+  rec = JournalRecord(JournalRecord::Type::SetSessionExpiration);
+  rec.sessionId = "alice";
+  rec.expirationDate = time(nullptr) + 3600;
+  records.push_back(rec);
+  rec = JournalRecord(JournalRecord::Type::VoteTrack);
+  rec.sessionId = "alice";
+  rec.track.trackId = tracks[0].trackId;
+  rec.vote = true;
+  records.push_back(rec);
+
+  writeJournal(1, records, 2);
+
+  // the replay starts in a later second than the DataStore was created
+  PersistentDataStore ds;
+  this_thread::sleep_for(chrono::milliseconds(1100));
+  ASSERT_FALSE(ds.open(mDirectory).has_value());
+
+  ASSERT_TRUE(ds.hasUser("alice"));
+  ASSERT_TRUE(get<User>(ds.getUser("alice")).votes.count(tracks[0].trackId));
+  auto normal = get<Queue>(ds.getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks[0].votes, 1);
+
+  // sessions which are still expired are removed after restoring
+  ASSERT_FALSE(ds.hasUser("bob"));
+}
+
+TEST_F(PersistentDataStoreTest, RestoresStateAfterCompaction) {
+  auto tracks = mGenerator.generateTracks(3);
+  {
+    auto ds = reopen();
+    ASSERT_FALSE(ds->addUser(makeUser("alice")).has_value());
+    ASSERT_FALSE(ds->addTrack(tracks[0], QueueType::Normal).has_value());
+    ASSERT_FALSE(ds->addTrack(tracks[1], QueueType::Admin).has_value());
+    ASSERT_FALSE(ds->nextTrack().has_value());
+    ASSERT_FALSE(ds->voteTrack("alice", tracks[0].trackId, true).has_value());
+    ASSERT_FALSE(ds->compact().has_value());
+
+    // modifications after the snapshot go to the journal
+    ASSERT_FALSE(ds->addTrack(tracks[2], QueueType::Normal).has_value());
+  }
+
+  auto ds = reopen();
+  ASSERT_TRUE(ds->hasUser("alice"));
+  auto playing = get<optional<QueuedTrack>>(ds->getPlayingTrack());
+  ASSERT_EQ(playing->trackId, tracks[1].trackId);
+
+  auto normal = get<Queue>(ds->getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks.size(), 2);
+  ASSERT_EQ(normal.tracks[0].trackId, tracks[0].trackId);
+  ASSERT_EQ(normal.tracks[0].votes, 1);
+  ASSERT_EQ(normal.tracks[1].trackId, tracks[2].trackId);
+
+  // a vote restored from the snapshot can be revoked
+  ASSERT_FALSE(ds->voteTrack("alice", tracks[0].trackId, false).has_value());
+  normal = get<Queue>(ds->getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks[0].votes, 0);
+}
+
+TEST_F(PersistentDataStoreTest, CompactionRotatesJournal) {
+  auto tracks = mGenerator.generateTracks(2);
+  auto ds = reopen();
+  ASSERT_FALSE(ds->addTrack(tracks[0], QueueType::Normal).has_value());
+  ASSERT_EQ(listFiles(), vector<string>({"journal.1.bin"}));
+
+  // the old journal is deleted once the snapshot has been written
+  ASSERT_FALSE(ds->compact().has_value());
+  ASSERT_EQ(listFiles(), vector<string>({"journal.2.bin", "snapshot.bin"}));
+  ASSERT_FALSE(ds->addTrack(tracks[1], QueueType::Normal).has_value());
+
+  SnapshotFile snapshot;
+  ASSERT_FALSE(snapshot.open(mDirectory + "/snapshot.bin").has_value());
+  ASSERT_EQ(snapshot.getLsn(), 1);
+  ASSERT_EQ(snapshot.getTrackCount(QueueType::Normal), 1);
+}
+
+TEST_F(PersistentDataStoreTest, RestoresFromRotatedJournals) {
+  auto tracks = mGenerator.generateQueuedTracks(3);
+  vector<JournalRecord> records;
+  for (auto &&track : tracks) {
+    JournalRecord rec(JournalRecord::Type::AddTrack);
+    rec.track = track;
+    rec.track.votes = 0;
+    records.push_back(rec);
+  }
+
+  // crashed after rotating, before the snapshot was written: the new journal
+  // starts with a record which has been buffered for the old one
+  writeJournal(1, {records[0], records[1]}, 1);
+  writeJournal(2, {records[1], records[2]}, 2);
+
+  {
+    auto ds = reopen();
+    auto normal = get<Queue>(ds->getQueue(QueueType::Normal));
+    ASSERT_EQ(normal.tracks.size(), 3);
+    ASSERT_FALSE(ds->nextTrack().has_value());
+  }
+
+  // appending continued in the newest journal
+  auto ds = reopen();
+  ASSERT_EQ(get<size_t>(ds->getQueueSize(QueueType::Normal)), 2);
+  ASSERT_FALSE(ds->compact().has_value());
+  ASSERT_EQ(listFiles(), vector<string>({"journal.3.bin", "snapshot.bin"}));
+}
+
+TEST_F(PersistentDataStoreTest, SnapshotFileRoundTrip) {
+  auto tracks = mGenerator.generateQueuedTracks(3);
+  QueueSnapshot queues;
+  queues.currentTrack = tracks[0];
+  queues.adminQueue.tracks = {tracks[1]};
+  queues.normalQueue.tracks = {tracks[2]};
+
+  User user = makeUser("alice");
+  user.isAdmin = true;
+  user.votes = {tracks[2].trackId, "unknown"};
+
+  string path = mDirectory + "/snapshot.bin";
+  ASSERT_FALSE(SnapshotFile::write(path, queues, {user}, 42).has_value());
+
+  SnapshotFile snapshot;
+  ASSERT_FALSE(snapshot.open(path).has_value());
+  ASSERT_EQ(snapshot.getLsn(), 42);
+  ASSERT_EQ(snapshot.getCurrentTrack()->trackId, tracks[0].trackId);
+  ASSERT_EQ(snapshot.getTrackCount(QueueType::Admin), 1);
+  ASSERT_EQ(snapshot.getTrackCount(QueueType::Normal), 1);
+
+  auto track = snapshot.getTrack(QueueType::Normal, 0);
+  ASSERT_EQ(track.trackId, tracks[2].trackId);
+  ASSERT_EQ(track.title, tracks[2].title);
+  ASSERT_EQ(track.album, tracks[2].album);
+  ASSERT_EQ(track.artist, tracks[2].artist);
+  ASSERT_EQ(track.iconUri, tracks[2].iconUri);
+  ASSERT_EQ(track.addedBy, tracks[2].addedBy);
+  ASSERT_EQ(track.durationMs, tracks[2].durationMs);
+  ASSERT_EQ(track.votes, tracks[2].votes);
+  ASSERT_EQ(track.insertedAt, tracks[2].insertedAt);
+
+  ASSERT_EQ(snapshot.getUserCount(), 1);
+  auto restored = snapshot.getUser(0);
+  ASSERT_EQ(restored.SessionID, user.SessionID);
+  ASSERT_EQ(restored.Name, user.Name);
+  ASSERT_EQ(restored.ExpirationDate, user.ExpirationDate);
+  ASSERT_TRUE(restored.isAdmin);
+  ASSERT_EQ(restored.votes, user.votes);
+
+  auto restoredQueues = snapshot.getQueues();
+  ASSERT_EQ(restoredQueues.currentTrack->trackId, tracks[0].trackId);
+  ASSERT_EQ(restoredQueues.adminQueue.tracks[0].trackId, tracks[1].trackId);
+  ASSERT_EQ(restoredQueues.normalQueue.tracks[0].trackId, tracks[2].trackId);
+}
+
+TEST_F(PersistentDataStoreTest, SnapshotFileFindsUsers) {
+  vector<User> users;
+  for (int i = 99; i >= 0; i--) {
+    users.push_back(makeUser("user" + to_string(i)));
+  }
+
+  string path = mDirectory + "/snapshot.bin";
+  ASSERT_FALSE(SnapshotFile::write(path, {}, users, 1).has_value());
+
+  SnapshotFile snapshot;
+  ASSERT_FALSE(snapshot.open(path).has_value());
+  for (auto &&user : users) {
+    auto found = snapshot.findUser(user.SessionID);
+    ASSERT_TRUE(found.has_value());
+    ASSERT_EQ(found->Name, user.Name);
+  }
+  ASSERT_FALSE(snapshot.findUser("user").has_value());
+  ASSERT_FALSE(snapshot.findUser("user100").has_value());
+  ASSERT_FALSE(snapshot.findUser("").has_value());
+}
+
+TEST_F(PersistentDataStoreTest, ServesSnapshotWhileLoading) {
+  auto tracks = mGenerator.generateQueuedTracks(1000);
+  QueueSnapshot queues;
+  queues.currentTrack = tracks[0];
+  queues.normalQueue.tracks.assign(tracks.begin() + 1, tracks.end());
+  for (size_t i = 0; i < queues.normalQueue.tracks.size(); i++) {
+    queues.normalQueue.tracks[i].votes = 0;
+    queues.normalQueue.tracks[i].insertedAt = i;
+  }
+  User alice = makeUser("alice");
+  User bob = makeUser("bob");
+  bob.ExpirationDate = time(nullptr) - 1;
+  ASSERT_FALSE(SnapshotFile::write(mDirectory + "/snapshot.bin", queues,
+                                   {alice, bob}, 1)
+                   .has_value());
+
+  // no matter if the snapshot has been loaded already, reading returns the
+  // state of the snapshot
+  auto ds = reopen();
+  auto snapshot = get<TQueueSnapshot>(ds->getQueueSnapshot());
+  ASSERT_EQ(snapshot->currentTrack->trackId, tracks[0].trackId);
+  ASSERT_EQ(snapshot->normalQueue.tracks.size(), 999);
+  ASSERT_EQ(snapshot->normalQueue.tracks[0].trackId, tracks[1].trackId);
+  ASSERT_EQ(get<size_t>(ds->getQueueSize(QueueType::Normal)), 999);
+  ASSERT_FALSE(ds->isEmpty());
+  ASSERT_TRUE(ds->hasUser("alice"));
+  ASSERT_EQ(get<User>(ds->getUser("alice")).Name, alice.Name);
+  ASSERT_FALSE(get<bool>(ds->isSessionExpired("alice")));
+  ASSERT_TRUE(holds_alternative<Error>(ds->isSessionExpired("bob")));
+  ASSERT_TRUE(holds_alternative<Error>(ds->isSessionExpired("carol")));
+
+  // modifications wait for the loading
+  ASSERT_FALSE(ds->voteTrack("alice", tracks[999].trackId, true).has_value());
+  auto normal = get<Queue>(ds->getQueue(QueueType::Normal));
+  ASSERT_EQ(normal.tracks.size(), 999);
+  ASSERT_EQ(normal.tracks[0].trackId, tracks[999].trackId);
+  ASSERT_EQ(normal.tracks[0].votes, 1);
+}
+
+TEST_F(PersistentDataStoreTest, RejectsCorruptSnapshot) {
+  auto tracks = mGenerator.generateQueuedTracks(2);
+  QueueSnapshot queues;
+  queues.normalQueue.tracks = tracks;
+
+  string path = mDirectory + "/snapshot.bin";
+  ASSERT_FALSE(SnapshotFile::write(path, queues, {}, 1).has_value());
+
+  // cut off the string table
+  ASSERT_EQ(truncate(path.c_str(), 200), 0);
+  SnapshotFile snapshot;
+  auto ret = snapshot.open(path);
+  ASSERT_TRUE(ret.has_value());
+  ASSERT_EQ(ret->getErrorCode(), ErrorCode::InvalidFormat);
+
+  // the DataStore refuses to start instead of losing data
+  PersistentDataStore ds;
+  ASSERT_TRUE(ds.open(mDirectory).has_value());
+}
+
+TEST_F(PersistentDataStoreTest, RejectsUnsortedUsers) {
+  string path = mDirectory + "/snapshot.bin";
+  ASSERT_FALSE(SnapshotFile::write(path, {},
+                                   {makeUser("bob"), makeUser("alice")}, 1)
+                   .has_value());
+
+  // swap both user records, which directly follow the header
+  size_t const usersOffset = 112;
+  size_t const userSize = 40;
+  fstream file(path, ios::in | ios::out | ios::binary);
+  string records(2 * userSize, '\0');
+  file.seekg(usersOffset);
+  file.read(&records[0], records.size());
+  rotate(records.begin(), records.begin() + userSize, records.end());
+  file.seekp(usersOffset);
+  file.write(records.data(), records.size());
+  file.close();
+
+  SnapshotFile snapshot;
+  auto ret = snapshot.open(path);
+  ASSERT_TRUE(ret.has_value());
+  ASSERT_EQ(ret->getErrorCode(), ErrorCode::InvalidFormat);
+}
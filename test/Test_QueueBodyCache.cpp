@@ -0,0 +1,120 @@
+/*****************************************************************************/
+/**
+ * @file    Test_QueueBodyCache.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class QueueBodyCache
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/Network/QueueBodyCache.h"
+#include "TrackGenerator.h"
+#include "Utils/Serializer.h"
+#include "json/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+static json normalQueue(QueueBodyCache::TEntry const &entry,
+                        QueueStatus const &status) {
+  string out;
+  JsonWriter writer(out);
+  entry->appendNormalQueue(status.normalQueue, writer);
+  return json::parse(out);
+}
+
+TEST(QueueBodyCache, SameAsSerializer) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(20, 3, false);
+  status.queueVersion = 3;
+  // the key of the vote inside of a string must not be patched
+  status.normalQueue.tracks[0].title = "\"current_vote\":0";
+
+  QueueBodyCache cache;
+  auto entry = cache.get(status);
+  ASSERT_EQ(normalQueue(entry, status),
+            Serializer::serialize(status.normalQueue));
+  ASSERT_EQ(json::parse(entry->getAdminQueue()),
+            Serializer::serialize(status.adminQueue));
+  ASSERT_EQ(entry->getQueueVersion(), 3);
+
+  auto empty = gen.generateQueueStatus(0, 0, false);
+  empty.queueVersion = 4;
+  entry = cache.get(empty);
+  ASSERT_EQ(normalQueue(entry, empty), json::array());
+  ASSERT_EQ(entry->getAdminQueue(), "[]");
+}
+
+TEST(QueueBodyCache, SharedPerVersion) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(10, 0, false);
+  status.queueVersion = 7;
+
+  QueueBodyCache cache;
+  auto entry = cache.get(status);
+  ASSERT_EQ(cache.get(status), entry);
+
+  // every user gets its own votes
+  auto otherUser = status;
+  for (auto &track : otherUser.normalQueue.tracks) {
+    track.userHasVoted = !track.userHasVoted;
+  }
+  auto otherEntry = cache.get(otherUser);
+  ASSERT_EQ(otherEntry, entry);
+  ASSERT_EQ(normalQueue(entry, otherUser),
+            Serializer::serialize(otherUser.normalQueue));
+  ASSERT_EQ(normalQueue(entry, status),
+            Serializer::serialize(status.normalQueue));
+
+  // a new version replaces the cached one
+  auto next = gen.generateQueueStatus(5, 0, false);
+  next.queueVersion = 8;
+  auto nextEntry = cache.get(next);
+  ASSERT_NE(nextEntry, entry);
+  ASSERT_EQ(cache.get(next), nextEntry);
+
+  // unknown versions are never cached
+  next.queueVersion = 0;
+  ASSERT_NE(cache.get(next), cache.get(next));
+}
+
+TEST(QueueBodyCache, BinaryFormats) {
+  TrackGenerator gen;
+  auto status = gen.generateQueueStatus(40, 3, false);
+  status.queueVersion = 5;
+  // the binary value of the vote inside of a string must not be patched
+  status.normalQueue.tracks[0].artist = string("\xac" "current_vote\x00", 14);
+  status.normalQueue.tracks[1].userHasVoted = true;
+  status.normalQueue.tracks[39].userHasVoted = true;
+
+  QueueBodyCache cache;
+  auto jsonEntry = cache.get(status);
+  auto msgpackEntry = cache.get(status, ResponseFormat::MessagePack);
+  auto cborEntry = cache.get(status, ResponseFormat::Cbor);
+  ASSERT_NE(msgpackEntry, jsonEntry);
+  ASSERT_EQ(msgpackEntry->getFormat(), ResponseFormat::MessagePack);
+  ASSERT_EQ(cache.get(status, ResponseFormat::MessagePack), msgpackEntry);
+  ASSERT_EQ(cache.get(status, ResponseFormat::Cbor), cborEntry);
+  ASSERT_EQ(cache.get(status), jsonEntry);
+
+  string msgpack;
+  BinaryWriter msgpackWriter(msgpack, BinaryFormat::MessagePack);
+  vector<BodySegment> segments;
+  msgpackEntry->appendNormalQueue(
+      status.normalQueue, msgpackWriter, &segments);
+  ASSERT_EQ(json::from_msgpack(msgpack),
+            Serializer::serialize(status.normalQueue));
+  // the segments with votes of the user are not taken from the cache
+  ASSERT_EQ(segments.size(), 0);
+  ASSERT_EQ(json::from_msgpack(msgpackEntry->getAdminQueue()),
+            Serializer::serialize(status.adminQueue));
+
+  string cbor;
+  BinaryWriter cborWriter(cbor, BinaryFormat::Cbor);
+  cborEntry->appendNormalQueue(status.normalQueue, cborWriter);
+  ASSERT_EQ(json::from_cbor(cbor), Serializer::serialize(status.normalQueue));
+}
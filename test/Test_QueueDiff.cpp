@@ -0,0 +1,147 @@
+/*****************************************************************************/
+/**
+ * @file    Test_QueueDiff.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class QueueDiff
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/Utils/QueueDiff.h"
+#include "TrackGenerator.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * @brief Applies the operations like a client would, using only the track IDs
+ * and the votes.
+ */
+static vector<pair<TTrackID, int>> applyDiff(Queue const &queue,
+                                             json const &ops) {
+  vector<pair<TTrackID, int>> tracks;
+  for (auto &&track : queue.tracks) {
+    tracks.emplace_back(track.trackId, track.votes);
+  }
+
+  auto find = [&](json const &id) {
+    return find_if(tracks.begin(), tracks.end(),
+                   [&](auto const &track) { return id == track.first; });
+  };
+  auto insertAfter = [&](json const &after, pair<TTrackID, int> track) {
+    auto it = after.is_null() ? tracks.begin() : find(after) + 1;
+    tracks.insert(it, track);
+  };
+
+  for (auto &&op : ops) {
+    if (op[0] == "remove") {
+      tracks.erase(find(op[1]));
+    } else if (op[0] == "votes") {
+      find(op[1])->second = op[2].get<int>();
+    } else if (op[0] == "move") {
+      auto it = find(op[1]);
+      auto track = *it;
+      tracks.erase(it);
+      insertAfter(op[2], track);
+    } else if (op[0] == "insert") {
+      auto const &track = op[2];
+      insertAfter(op[1], {track["track_id"].get<TTrackID>(),
+                          track["votes"].get<int>()});
+    }
+  }
+  return tracks;
+}
+
+static vector<pair<TTrackID, int>> ids(Queue const &queue) {
+  vector<pair<TTrackID, int>> tracks;
+  for (auto &&track : queue.tracks) {
+    tracks.emplace_back(track.trackId, track.votes);
+  }
+  return tracks;
+}
+
+TEST(QueueDiff, Unchanged) {
+  TrackGenerator gen;
+  Queue queue{gen.generateQueuedTracks(10)};
+  ASSERT_EQ(QueueDiff::diff(queue, queue).dump(), "[]");
+  ASSERT_EQ(QueueDiff::diff(Queue(), Queue()).dump(), "[]");
+}
+
+TEST(QueueDiff, SingleVote) {
+  TrackGenerator gen;
+  Queue from{gen.generateQueuedTracks(300)};
+  for (size_t i = 0; i < from.tracks.size(); i++) {
+    from.tracks[i].votes = 300 - i;
+  }
+
+  // a track moves up by one vote
+  Queue to = from;
+  to.tracks[200].votes = 150;
+  rotate(to.tracks.begin() + 150, to.tracks.begin() + 200,
+         to.tracks.begin() + 201);
+
+  auto ops = QueueDiff::diff(from, to);
+  ASSERT_EQ(ops.size(), 2);
+  ASSERT_EQ(ops[0][0].get<string>(), "votes");
+  ASSERT_EQ(ops[1][0].get<string>(), "move");
+  ASSERT_LT(ops.dump().size(), 100);
+  ASSERT_EQ(applyDiff(from, ops), ids(to));
+}
+
+TEST(QueueDiff, InsertAndRemove) {
+  TrackGenerator gen;
+  Queue from{gen.generateQueuedTracks(5)};
+  Queue to = from;
+  auto added = gen.generateQueuedTracks(2);
+  to.tracks.erase(to.tracks.begin() + 1);
+  to.tracks.insert(to.tracks.begin(), added[0]);
+  to.tracks.push_back(added[1]);
+
+  auto ops = QueueDiff::diff(from, to);
+  ASSERT_EQ(ops.size(), 3);
+  ASSERT_EQ(ops[0].dump(),
+            json::array({"remove", from.tracks[1].trackId}).dump());
+  ASSERT_EQ(ops[1][0].get<string>(), "insert");
+  ASSERT_TRUE(ops[1][1].is_null());
+  ASSERT_EQ(ops[2][0].get<string>(), "insert");
+  ASSERT_EQ(ops[2][1].get<string>(), from.tracks[4].trackId);
+  ASSERT_EQ(applyDiff(from, ops), ids(to));
+}
+
+TEST(QueueDiff, RandomChanges) {
+  TrackGenerator gen;
+  mt19937 rng(42);
+  for (size_t i = 0; i < 200; i++) {
+    Queue from{gen.generateQueuedTracks(rng() % 20)};
+    Queue to = from;
+
+    // remove some tracks, add some and change some votes
+    to.tracks.erase(remove_if(to.tracks.begin(), to.tracks.end(),
+                              [&](auto const &) { return rng() % 4 == 0; }),
+                    to.tracks.end());
+    for (auto &&track : gen.generateQueuedTracks(rng() % 5)) {
+      to.tracks.push_back(track);
+    }
+    for (auto &track : to.tracks) {
+      if (rng() % 3 == 0) {
+        track.votes = rng() % 10;
+      }
+    }
+    shuffle(to.tracks.begin(), to.tracks.end(), rng);
+
+    auto ops = QueueDiff::diff(from, to);
+    ASSERT_EQ(applyDiff(from, ops), ids(to));
+
+    // the written operations are the same as the serialized ones
+    string written;
+    JsonWriter writer(written);
+    QueueDiff::write(QueueDiff::operations(from, to), writer);
+    ASSERT_EQ(written, ops.dump());
+  }
+}
@@ -1,11 +1,15 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "Network/RestAPI.h"
 #include "NetworkListenerHelper.h"
 #include "RestAPIFixture.h"
+#include "Utils/Metrics.h"
 #include "Utils/Serializer.h"
 #include "json/json.hpp"
 #include "restclient-cpp/restclient.h"
@@ -362,3 +366,429 @@ TEST_F(RestAPIFixture, moveTrack_goodCases) {
   queueType = QueueType::Admin;
   testMoveTrack(this, sid, trkid, queueType, 4);
 }
+
+//
+// addTracksToQueue
+//
+TEST_F(RestAPIFixture, addTracksToQueue_goodCases) {
+  ASSERT_FALSE(listener.hasParametersAddTracksToQueue());
+  ASSERT_EQ(listener.getCountAddTracksToQueue(), 0);
+
+  json requestBody{
+      {"session_id", "1234"},               //
+      {"track_ids", {"track1", "track2"}},  //
+      {"queue_type", "admin"}               //
+  };
+  auto resp = post("/addTracksToQueue", requestBody.dump()).value();
+
+  ASSERT_EQ(resp.code, 200);
+  json expected = {{"results",
+                    {{{"track_id", "track1"}, {"status", 200}},
+                     {{"track_id", "track2"}, {"status", 200}}}}};
+  ASSERT_EQ(json::parse(resp.body), expected);
+  ASSERT_EQ(listener.getCountAddTracksToQueue(), 1);
+
+  TSessionID sid;
+  vector<TTrackID> trkids;
+  QueueType queueType;
+  listener.getLastParametersAddTracksToQueue(sid, trkids, queueType);
+  ASSERT_EQ(sid, "1234");
+  ASSERT_EQ(trkids, (vector<TTrackID>{"track1", "track2"}));
+  ASSERT_EQ(queueType, QueueType::Admin);
+
+  // the track IDs must be strings
+  requestBody["track_ids"] = {"track1", 2};
+  resp = post("/addTracksToQueue", requestBody.dump()).value();
+  ASSERT_EQ(resp.code, 422);
+  ASSERT_EQ(listener.getCountAddTracksToQueue(), 1);
+}
+
+//
+// voteTracks
+//
+TEST_F(RestAPIFixture, voteTracks_goodCases) {
+  ASSERT_FALSE(listener.hasParametersVoteTracks());
+  ASSERT_EQ(listener.getCountVoteTracks(), 0);
+
+  json requestBody{
+      {"session_id", "1234"},                   //
+      {"votes",                                 //
+       {{{"track_id", "track1"}, {"vote", 1}},  //
+        {{"track_id", "track2"}, {"vote", 0}}}}  //
+  };
+  auto resp = put("/voteTracks", requestBody.dump()).value();
+
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(json::parse(resp.body), json::object());
+  ASSERT_EQ(listener.getCountVoteTracks(), 1);
+
+  TSessionID sid;
+  vector<pair<TTrackID, TVote>> votes;
+  listener.getLastParametersVoteTracks(sid, votes);
+  ASSERT_EQ(sid, "1234");
+  ASSERT_EQ(votes.size(), 2);
+  ASSERT_EQ(votes[0], (pair<TTrackID, TVote>{"track1", true}));
+  ASSERT_EQ(votes[1], (pair<TTrackID, TVote>{"track2", false}));
+}
+
+//
+// metrics
+//
+TEST_F(RestAPIFixture, metrics_goodCases) {
+  auto &metrics = Metrics::getInstance();
+  metrics.increment(metrics.registerCounter("test_rest_requests_total"), 3);
+
+  auto resp = get("/metrics", {}).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_NE(resp.body.find("# TYPE test_rest_requests_total counter\n"
+                           "test_rest_requests_total 3\n"),
+            string::npos);
+}
+
+//
+// getCurrentQueues (long polling)
+//
+TEST_F(RestAPIFixture, getCurrentQueues_since) {
+  auto expQueueStatus = gen.generateQueueStatus(3, 1, false);
+  expQueueStatus.version = 8;
+  listener.setResponseGetCurrentQueues(expQueueStatus);
+  listener.setResponseWaitForChange(8);
+
+  // without a version the queues are returned immediately
+  auto resp = get("/getCurrentQueues", {{"session_id", "1234"}}).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(json::parse(resp.body)["version"], 8);
+  ASSERT_EQ(listener.getCountWaitForChange(), 0);
+
+  resp = get("/getCurrentQueues", {{"session_id", "1234"}, {"since", "7"}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(json::parse(resp.body)["version"], 8);
+  ASSERT_EQ(listener.getCountWaitForChange(), 1);
+
+  TSessionID sid;
+  uint64_t since;
+  listener.getLastParametersWaitForChange(sid, since);
+  ASSERT_EQ(sid, "1234");
+  ASSERT_EQ(since, 7);
+
+  // invalid versions
+  for (auto &&invalid : {"", "-1", "abc", "12a", "99999999999999999999"}) {
+    map<string, string> parameters{{"session_id", "1234"}, {"since", invalid}};
+    resp = get("/getCurrentQueues", parameters).value();
+    ASSERT_EQ(resp.code, 422);
+  }
+  ASSERT_EQ(listener.getCountWaitForChange(), 1);
+}
+
+TEST_F(RestAPIFixture, getCurrentQueues_longPollLimit) {
+  // the limit is set in the test configuration
+  size_t const maxLongPolls = 4;
+  auto expQueueStatus = gen.generateQueueStatus(3, 1, false);
+  expQueueStatus.version = 8;
+  listener.setResponseGetCurrentQueues(expQueueStatus);
+  listener.setResponseWaitForChange(8);
+  listener.setDelayWaitForChange(1s);
+  map<string, string> parameters = {{"session_id", "1234"}, {"since", "7"}};
+
+  // every long polling request blocks a thread of the server while it waits
+  vector<thread> clients;
+  for (size_t i = 0; i < maxLongPolls; i++) {
+    clients.emplace_back([&]() { get("/getCurrentQueues", parameters); });
+  }
+  for (size_t i = 0; i < 100; i++) {
+    if (listener.getCountWaitForChange() == maxLongPolls) {
+      break;
+    }
+    this_thread::sleep_for(20ms);
+  }
+  ASSERT_EQ(listener.getCountWaitForChange(), maxLongPolls);
+
+  // further requests are rejected without waiting
+  auto resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 503);
+  ASSERT_EQ(resp.headers["Retry-After"], "5");
+  ASSERT_EQ(json::parse(resp.body)["status"], 503);
+  ASSERT_EQ(listener.getCountWaitForChange(), maxLongPolls);
+
+  // requests without a version are not limited
+  resp = get("/getCurrentQueues", {{"session_id", "1234"}}).value();
+  ASSERT_EQ(resp.code, 200);
+
+  // the slots are released with the responses
+  for (auto &&client : clients) {
+    client.join();
+  }
+  listener.setDelayWaitForChange(0ms);
+  resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(json::parse(resp.body)["version"], 8);
+}
+
+TEST_F(RestAPIFixture, getCurrentQueues_queueVersion) {
+  auto expQueueStatus = gen.generateQueueStatus(300, 5, true);
+  for (auto &track : expQueueStatus.normalQueue.tracks) {
+    track.userHasVoted = false;
+  }
+  expQueueStatus.queueVersion = 5;
+  expQueueStatus.normalQueue.tracks[42].userHasVoted = true;
+
+  // the client knows the queues before the user voted for a track
+  QueueSnapshot base{4, expQueueStatus.adminQueue, expQueueStatus.normalQueue,
+                     QueuedTrack()};
+  base.normalQueue.tracks[42].votes--;
+  base.currentTrack->trackId = expQueueStatus.currentTrack->trackId;
+  listener.setResponseGetCurrentQueues(expQueueStatus);
+  listener.setResponseGetPreviousQueues(
+      make_shared<QueueSnapshot const>(base));
+
+  auto full = get("/getCurrentQueues", {{"session_id", "1234"}}).value();
+  ASSERT_EQ(full.code, 200);
+  ASSERT_EQ(json::parse(full.body)["queue_version"], 5);
+  ASSERT_EQ(listener.getCountGetPreviousQueues(), 0);
+
+  map<string, string> parameters{{"session_id", "1234"},
+                                 {"queue_version", "4"}};
+  auto resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_LT(resp.body.size() * 100, full.body.size());
+  ASSERT_EQ(listener.getCountGetPreviousQueues(), 1);
+
+  TSessionID sid;
+  uint64_t queueVersion;
+  listener.getLastParametersGetPreviousQueues(sid, queueVersion);
+  ASSERT_EQ(sid, "1234");
+  ASSERT_EQ(queueVersion, 4);
+
+  auto track = expQueueStatus.normalQueue.tracks[42];
+  auto delta = json::parse(resp.body);
+  ASSERT_EQ(delta["base_version"], 4);
+  ASSERT_EQ(delta["queue_version"], 5);
+  ASSERT_EQ(delta["normal_queue"],
+            json::array({json::array({"votes", track.trackId, track.votes})}));
+  ASSERT_EQ(delta["admin_queue"], json::array());
+  ASSERT_EQ(delta["current_votes"], json::array({track.trackId}));
+  ASSERT_EQ(delta["currently_playing"].size(), 2);
+
+  // unknown versions get the whole queues
+  listener.setResponseGetPreviousQueues(
+      Error(ErrorCode::DoesntExist, "unknown"));
+  resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.body, full.body);
+
+  // invalid versions
+  parameters["queue_version"] = "abc";
+  resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 422);
+}
+
+TEST_F(RestAPIFixture, events_badCases) {
+  // the session is required
+  auto resp = get("/events", {}).value();
+  ASSERT_EQ(resp.code, 422);
+  ASSERT_EQ(listener.getCountGetEvents(), 0);
+
+  // errors are reported before the stream is started
+  listener.setResponseGetEvents(
+      Error(ErrorCode::SessionExpired, "session expired"));
+  resp = get("/events", {{"session_id", "1234"}}).value();
+  ASSERT_EQ(resp.code, 440);
+  ASSERT_EQ(listener.getCountGetEvents(), 1);
+
+  TSessionID sid;
+  listener.getLastParametersGetEvents(sid);
+  ASSERT_EQ(sid, "1234");
+}
+
+TEST_F(RestAPIFixture, events_limit) {
+  // the limit is set in the test configuration
+  size_t const maxEventStreams = 4;
+  // used by the streams until the server is stopped
+  auto &events = listener.getEventBroadcaster();
+  map<string, string> parameters = {{"session_id", "1234"}};
+
+  // every stream blocks a thread of the server until the client gives up
+  vector<thread> clients;
+  for (size_t i = 0; i < maxEventStreams; i++) {
+    clients.emplace_back([&]() { get("/events", parameters, {}, 2); });
+  }
+  for (size_t i = 0; i < 100; i++) {
+    if (listener.getCountGetEvents() == maxEventStreams) {
+      break;
+    }
+    this_thread::sleep_for(20ms);
+  }
+  ASSERT_EQ(listener.getCountGetEvents(), maxEventStreams);
+
+  // further streams are rejected immediately
+  auto resp = get("/events", parameters).value();
+  ASSERT_EQ(resp.code, 503);
+  ASSERT_EQ(resp.headers["Retry-After"], "5");
+  ASSERT_EQ(json::parse(resp.body)["status"], 503);
+  for (auto &&client : clients) {
+    client.join();
+  }
+
+  // a stream is only noticed to be closed when writing to it fails
+  bool accepted = false;
+  for (size_t i = 0; i < 10 && !accepted; i++) {
+    events.publish(EventBroadcaster::formatEvent("test", "{}"));
+    this_thread::sleep_for(100ms);
+    accepted = get("/events", parameters, {}, 1).value().code != 503;
+  }
+  ASSERT_TRUE(accepted);
+
+  // close the remaining streams before the server is stopped
+  events.publish(EventBroadcaster::formatEvent("test", "{}"));
+  this_thread::sleep_for(100ms);
+  events.publish(EventBroadcaster::formatEvent("test", "{}"));
+}
+
+//
+// response formats
+//
+TEST_F(RestAPIFixture, responseFormats) {
+  listener.setResponseGetCurrentQueues(gen.generateQueueStatus(5, 2, true));
+  map<string, string> parameters = {{"session_id", "1234"}};
+
+  auto resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["Content-Type"], "application/json");
+  auto expected = json::parse(resp.body);
+
+  resp = get("/getCurrentQueues", parameters,
+             {{"Accept", "application/msgpack"}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["Content-Type"], "application/msgpack");
+  ASSERT_EQ(json::from_msgpack(resp.body), expected);
+
+  resp = get("/getCurrentQueues", parameters,
+             {{"Accept", "application/json;q=0.5, application/cbor"}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["Content-Type"], "application/cbor");
+  ASSERT_EQ(json::from_cbor(resp.body), expected);
+
+  // errors use the same format
+  resp = get("/getCurrentQueues", {}, {{"Accept", "application/cbor"}}).value();
+  ASSERT_EQ(resp.code, 422);
+  ASSERT_EQ(json::from_cbor(resp.body)["status"], 422);
+
+  // unsupported formats fall back to JSON
+  resp = get("/getCurrentQueues", parameters, {{"Accept", "text/html"}})
+             .value();
+  ASSERT_EQ(json::parse(resp.body), expected);
+}
+
+TEST_F(RestAPIFixture, responseEncodings) {
+  auto status = gen.generateQueueStatus(50, 10, true);
+  status.queueVersion = 3;
+  listener.setResponseGetCurrentQueues(status);
+  map<string, string> parameters = {{"session_id", "1234"}};
+
+  auto resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers.count("Content-Encoding"), 0);
+  auto size = resp.body.size();
+
+  resp = get("/getCurrentQueues", parameters,
+             {{"Accept-Encoding", "gzip, deflate"}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["Content-Encoding"], "gzip");
+  ASSERT_EQ(resp.body.substr(0, 2), "\x1f\x8b");
+  ASSERT_LT(resp.body.size() * 3, size);
+
+  // binary formats are compressed as well
+  resp = get("/getCurrentQueues", parameters,
+             {{"Accept", "application/msgpack"}, {"Accept-Encoding", "gzip"}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["Content-Type"], "application/msgpack");
+  ASSERT_EQ(resp.headers["Content-Encoding"], "gzip");
+  ASSERT_EQ(resp.body.substr(0, 2), "\x1f\x8b");
+
+  // small bodies are not compressed
+  resp = get("/getCurrentQueues", {}, {{"Accept-Encoding", "gzip"}}).value();
+  ASSERT_EQ(resp.code, 422);
+  ASSERT_EQ(resp.headers.count("Content-Encoding"), 0);
+}
+
+//
+// getCurrentQueues (entity tags)
+//
+TEST_F(RestAPIFixture, getCurrentQueues_eTag) {
+  auto status = gen.generateQueueStatus(3, 1, false);
+  status.version = 4;
+  listener.setResponseGetCurrentQueues(status);
+  map<string, string> parameters = {{"session_id", "1234"}};
+
+  // responses are only tagged if the listener provides a tag
+  auto resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers.count("ETag"), 0);
+
+  listener.setResponseGetQueueStatusTag(QueueStatusTag{0x5eed, 4, 0xabc});
+  resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  auto etag = resp.headers["ETag"];
+  ASSERT_EQ(etag, "W/\"5eed-4-abc\"");
+
+  TSessionID sid;
+  listener.getLastParametersGetQueueStatusTag(sid);
+  ASSERT_EQ(sid, "1234");
+
+  // matching tags are answered without getting the queues
+  auto count = listener.getCountGetCurrentQueues();
+  resp = get("/getCurrentQueues", parameters, {{"If-None-Match", etag}})
+             .value();
+  ASSERT_EQ(resp.code, 304);
+  ASSERT_EQ(resp.body, "");
+  ASSERT_EQ(resp.headers["ETag"], etag);
+  resp = get("/getCurrentQueues", parameters,
+             {{"If-None-Match", "\"other\", \"5eed-4-abc\""}})
+             .value();
+  ASSERT_EQ(resp.code, 304);
+  ASSERT_EQ(listener.getCountGetCurrentQueues(), count);
+
+  // other votes of the user result in another tag
+  listener.setResponseGetQueueStatusTag(QueueStatusTag{0x5eed, 4, 0xabd});
+  resp = get("/getCurrentQueues", parameters, {{"If-None-Match", etag}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["ETag"], "W/\"5eed-4-abd\"");
+
+  // tags of a previous run of the server do not match the same state
+  auto previousRun = resp.headers["ETag"];
+  listener.setResponseGetQueueStatusTag(QueueStatusTag{0x5eee, 4, 0xabd});
+  resp = get("/getCurrentQueues", parameters, {{"If-None-Match", previousRun}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["ETag"], "W/\"5eee-4-abd\"");
+
+  // changes are tagged together with the client's version
+  parameters["queue_version"] = "3";
+  resp = get("/getCurrentQueues", parameters).value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers["ETag"], "W/\"5eee-4-abd-3\"");
+
+  // long polling requests wait for changes instead
+  parameters.erase("queue_version");
+  parameters["since"] = "4";
+  listener.setResponseWaitForChange(4);
+  resp = get("/getCurrentQueues", parameters, {{"If-None-Match", "*"}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(listener.getCountGetCurrentQueues(), count + 4);
+
+  // without a tag the request is handled as usual
+  listener.setResponseGetQueueStatusTag(
+      Error(ErrorCode::SessionExpired, "session expired"));
+  parameters.erase("since");
+  resp = get("/getCurrentQueues", parameters, {{"If-None-Match", "*"}})
+             .value();
+  ASSERT_EQ(resp.code, 200);
+  ASSERT_EQ(resp.headers.count("ETag"), 0);
+}
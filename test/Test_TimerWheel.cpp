@@ -0,0 +1,79 @@
+/*****************************************************************************/
+/**
+ * @file    Test_TimerWheel.cpp
+ * @author  Team Server
+ * @brief   Test implementation for class TimerWheel
+ */
+/*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+#include "../src/Datastore/TimerWheel.h"
+
+using namespace std;
+
+static time_t const cStart = 1000000;
+
+TEST(TimerWheel, ExpiresAtDeadline) {
+  TimerWheel wheel(cStart);
+  wheel.schedule("a", cStart + 10);
+  wheel.schedule("b", cStart + 100);
+  wheel.schedule("c", cStart + 5000);
+  ASSERT_EQ(wheel.size(), 3);
+
+  ASSERT_TRUE(wheel.advance(cStart + 9).empty());
+  ASSERT_EQ(wheel.advance(cStart + 10), vector<TSessionID>{"a"});
+  ASSERT_TRUE(wheel.advance(cStart + 99).empty());
+  ASSERT_EQ(wheel.advance(cStart + 100), vector<TSessionID>{"b"});
+  ASSERT_TRUE(wheel.advance(cStart + 4999).empty());
+  ASSERT_EQ(wheel.advance(cStart + 5000), vector<TSessionID>{"c"});
+  ASSERT_EQ(wheel.size(), 0);
+}
+
+TEST(TimerWheel, FarDeadlines) {
+  TimerWheel wheel(cStart);
+  // beyond the range of all levels
+  time_t far = cStart + 400 * 24 * 3600;
+  wheel.schedule("far", far);
+  time_t month = cStart + 30 * 24 * 3600;
+  wheel.schedule("month", month);
+
+  ASSERT_TRUE(wheel.advance(month - 1).empty());
+  ASSERT_EQ(wheel.advance(month), vector<TSessionID>{"month"});
+  ASSERT_TRUE(wheel.advance(far - 1).empty());
+  ASSERT_EQ(wheel.advance(far), vector<TSessionID>{"far"});
+}
+
+TEST(TimerWheel, RescheduleAndCancel) {
+  TimerWheel wheel(cStart);
+  wheel.schedule("a", cStart + 10);
+  wheel.schedule("b", cStart + 10);
+  wheel.schedule("c", cStart + 3000);
+
+  // sliding a deadline postpones the expiration
+  wheel.schedule("a", cStart + 70);
+  // deadlines can also be moved closer
+  wheel.schedule("c", cStart + 20);
+  ASSERT_TRUE(wheel.cancel("b"));
+  ASSERT_FALSE(wheel.cancel("b"));
+
+  ASSERT_TRUE(wheel.advance(cStart + 19).empty());
+  ASSERT_EQ(wheel.advance(cStart + 20), vector<TSessionID>{"c"});
+  ASSERT_TRUE(wheel.advance(cStart + 69).empty());
+  ASSERT_EQ(wheel.advance(cStart + 70), vector<TSessionID>{"a"});
+  ASSERT_EQ(wheel.size(), 0);
+}
+
+TEST(TimerWheel, ExpiredDeadlines) {
+  TimerWheel wheel(cStart);
+  wheel.schedule("a", cStart - 100);
+  wheel.schedule("b", cStart + 1);
+
+  auto expired = wheel.advance(cStart + 1);
+  sort(expired.begin(), expired.end());
+  ASSERT_EQ(expired, (vector<TSessionID>{"a", "b"}));
+}
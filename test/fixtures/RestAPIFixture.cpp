@@ -86,3 +86,20 @@ optional<RestClient::Response> RestAPIFixture::get(
   }
   return RestClient::get(url.value());
 }
+
+optional<RestClient::Response> RestAPIFixture::get(
+    string const &endpoint,
+    map<string, string> const &queryParameters,
+    RestClient::HeaderFields const &headers,
+    int timeoutSeconds) {
+  auto url = getRequestUrl(endpoint, queryParameters);
+  if (!url.has_value()) {
+    return nullopt;
+  }
+  RestClient::Connection connection(url.value());
+  connection.SetHeaders(headers);
+  if (timeoutSeconds > 0) {
+    connection.SetTimeout(timeoutSeconds);
+  }
+  return connection.get("");
+}
@@ -16,6 +16,7 @@
 #include "MockNetworkListener.h"
 #include "Network/RestAPI.h"
 #include "TrackGenerator.h"
+#include "restclient-cpp/connection.h"
 #include "restclient-cpp/restclient.h"
 
 class RestAPIFixture : public ::testing::Test {
@@ -27,6 +28,11 @@ class RestAPIFixture : public ::testing::Test {
   std::optional<RestClient::Response> get(
       std::string const &endpoint,
       std::map<std::string, std::string> const &queryParameters);
+  std::optional<RestClient::Response> get(
+      std::string const &endpoint,
+      std::map<std::string, std::string> const &queryParameters,
+      RestClient::HeaderFields const &headers,
+      int timeoutSeconds = 0);
 
   MockNetworkListener listener;
   TrackGenerator gen;
@@ -89,9 +89,11 @@ void testGetCurrentQueues(RestAPIFixture *fixture,
   auto expQueueStatus =
       fixture->gen.generateQueueStatus(normalNr, adminNr, playbackTrack);
   json expResponseBody = {
-      {"currently_playing", json::object()},  //
-      {"normal_queue", json::array()},        //
-      {"admin_queue", json::array()}          //
+      {"currently_playing", json::object()},          //
+      {"normal_queue", json::array()},                //
+      {"admin_queue", json::array()},                 //
+      {"version", expQueueStatus.version},            //
+      {"queue_version", expQueueStatus.queueVersion}  //
   };
 
   if (expQueueStatus.currentTrack.has_value()) {
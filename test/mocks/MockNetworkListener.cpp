@@ -1,5 +1,6 @@
 #include "MockNetworkListener.h"
 
+#include <thread>
 #include <tuple>
 
 using namespace std;
@@ -8,11 +9,22 @@ MockNetworkListener::MockNetworkListener()
     : mGenerateSessionCount(0),
       mQueryTracksCount(0),
       mGetCurrentQueuesCount(0),
+      mWaitForChangeCount(0),
+      mWaitForChangeDelay(0),
+      mGetEventsCount(0),
+      mGetEventsResponse(&mEventBroadcaster),
+      mGetPreviousQueuesCount(0),
+      mGetPreviousQueuesResponse(Error(ErrorCode::DoesntExist, "unknown")),
+      mGetQueueStatusTagCount(0),
+      mGetQueueStatusTagResponse(Error(ErrorCode::DoesntExist, "unknown")),
       mAddTrackToQueueCount(0),
       mVoteTrackCount(0),
       mControlPlayerCount(0),
       mRemoveTrackCount(0),
-      mMoveTrackCount(0) {
+      mMoveTrackCount(0),
+      mAddTracksToQueueCount(0),
+      mVoteTracksCount(0),
+      mRemoveTracksCount(0) {
 }
 
 //
@@ -40,6 +52,39 @@ TResult<QueueStatus> MockNetworkListener::getCurrentQueues(
   return mGetCurrentQueuesResponse;
 }
 
+TResult<uint64_t> MockNetworkListener::waitForChange(TSessionID const &sid,
+                                                   uint64_t since,
+                                                   chrono::milliseconds) {
+  {
+    lock_guard<mutex> lock(mWaitForChangeMutex);
+    mWaitForChangeParameters = tuple{sid, since};
+  }
+  mWaitForChangeCount++;
+  this_thread::sleep_for(mWaitForChangeDelay);
+  return mWaitForChangeResponse;
+}
+
+TResult<EventBroadcaster *> MockNetworkListener::getEvents(
+    TSessionID const &sid) {
+  mGetEventsParameters = sid;
+  mGetEventsCount++;
+  return mGetEventsResponse;
+}
+
+TResult<TQueueSnapshot> MockNetworkListener::getPreviousQueues(
+    TSessionID const &sid, uint64_t queueVersion) {
+  mGetPreviousQueuesParameters = tuple{sid, queueVersion};
+  mGetPreviousQueuesCount++;
+  return mGetPreviousQueuesResponse;
+}
+
+TResult<QueueStatusTag> MockNetworkListener::getQueueStatusTag(
+    TSessionID const &sid) {
+  mGetQueueStatusTagParameters = sid;
+  mGetQueueStatusTagCount++;
+  return mGetQueueStatusTagResponse;
+}
+
 TResultOpt MockNetworkListener::addTrackToQueue(TSessionID const &sid,
                                                 TTrackID const &trkid,
                                                 QueueType type) {
@@ -78,6 +123,27 @@ TResultOpt MockNetworkListener::moveTrack(TSessionID const &sid,
   return {};
 }
 
+TResult<vector<TResultOpt>> MockNetworkListener::addTracksToQueue(
+    TSessionID const &sid, vector<TTrackID> const &trkids, QueueType type) {
+  mAddTracksToQueueParameters = tuple{sid, trkids, type};
+  mAddTracksToQueueCount++;
+  return vector<TResultOpt>(trkids.size());
+}
+
+TResultOpt MockNetworkListener::voteTracks(
+    TSessionID const &sid, vector<pair<TTrackID, TVote>> const &votes) {
+  mVoteTracksParameters = tuple{sid, votes};
+  mVoteTracksCount++;
+  return {};
+}
+
+TResult<vector<TResultOpt>> MockNetworkListener::removeTracks(
+    TSessionID const &sid, vector<TTrackID> const &trkids) {
+  mRemoveTracksParameters = tuple{sid, trkids};
+  mRemoveTracksCount++;
+  return vector<TResultOpt>(trkids.size());
+}
+
 //
 // Access functions for the test cases
 //
@@ -137,6 +203,85 @@ void MockNetworkListener::setResponseGetCurrentQueues(
   mGetCurrentQueuesResponse = queueStatus;
 }
 
+// waitForChange
+bool MockNetworkListener::hasParametersWaitForChange() {
+  return mWaitForChangeParameters.has_value();
+}
+
+void MockNetworkListener::getLastParametersWaitForChange(TSessionID &sid,
+                                                         uint64_t &since) {
+  tie(sid, since) = mWaitForChangeParameters.value();
+  mWaitForChangeParameters = nullopt;
+}
+
+size_t MockNetworkListener::getCountWaitForChange() {
+  return mWaitForChangeCount;
+}
+void MockNetworkListener::setResponseWaitForChange(uint64_t version) {
+  mWaitForChangeResponse = version;
+}
+void MockNetworkListener::setDelayWaitForChange(chrono::milliseconds delay) {
+  mWaitForChangeDelay = delay;
+}
+
+// getEvents
+bool MockNetworkListener::hasParametersGetEvents() {
+  return mGetEventsParameters.has_value();
+}
+
+void MockNetworkListener::getLastParametersGetEvents(TSessionID &sid) {
+  sid = mGetEventsParameters.value();
+  mGetEventsParameters = nullopt;
+}
+
+size_t MockNetworkListener::getCountGetEvents() {
+  return mGetEventsCount;
+}
+void MockNetworkListener::setResponseGetEvents(
+    TResult<EventBroadcaster *> const &events) {
+  mGetEventsResponse = events;
+}
+EventBroadcaster &MockNetworkListener::getEventBroadcaster() {
+  return mEventBroadcaster;
+}
+
+// getPreviousQueues
+bool MockNetworkListener::hasParametersGetPreviousQueues() {
+  return mGetPreviousQueuesParameters.has_value();
+}
+
+void MockNetworkListener::getLastParametersGetPreviousQueues(
+    TSessionID &sid, uint64_t &queueVersion) {
+  tie(sid, queueVersion) = mGetPreviousQueuesParameters.value();
+  mGetPreviousQueuesParameters = nullopt;
+}
+
+size_t MockNetworkListener::getCountGetPreviousQueues() {
+  return mGetPreviousQueuesCount;
+}
+void MockNetworkListener::setResponseGetPreviousQueues(
+    TResult<TQueueSnapshot> const &queues) {
+  mGetPreviousQueuesResponse = queues;
+}
+
+// getQueueStatusTag
+bool MockNetworkListener::hasParametersGetQueueStatusTag() {
+  return mGetQueueStatusTagParameters.has_value();
+}
+
+void MockNetworkListener::getLastParametersGetQueueStatusTag(TSessionID &sid) {
+  sid = mGetQueueStatusTagParameters.value();
+  mGetQueueStatusTagParameters = nullopt;
+}
+
+size_t MockNetworkListener::getCountGetQueueStatusTag() {
+  return mGetQueueStatusTagCount;
+}
+void MockNetworkListener::setResponseGetQueueStatusTag(
+    TResult<QueueStatusTag> const &tag) {
+  mGetQueueStatusTagResponse = tag;
+}
+
 // addTrackToQueue
 bool MockNetworkListener::hasParametersAddTrackToQueue() {
   return mAddTrackToQueueParameters.has_value();
@@ -213,3 +358,48 @@ void MockNetworkListener::getLastParametersRemoveTrack(TSessionID &sid,
 size_t MockNetworkListener::getCountRemoveTrack() {
   return mRemoveTrackCount;
 }
+
+// addTracksToQueue
+bool MockNetworkListener::hasParametersAddTracksToQueue() {
+  return mAddTracksToQueueParameters.has_value();
+}
+
+void MockNetworkListener::getLastParametersAddTracksToQueue(
+    TSessionID &sid, vector<TTrackID> &trkids, QueueType &queueType) {
+  tie(sid, trkids, queueType) = mAddTracksToQueueParameters.value();
+  mAddTracksToQueueParameters = nullopt;
+}
+
+size_t MockNetworkListener::getCountAddTracksToQueue() {
+  return mAddTracksToQueueCount;
+}
+
+// voteTracks
+bool MockNetworkListener::hasParametersVoteTracks() {
+  return mVoteTracksParameters.has_value();
+}
+
+void MockNetworkListener::getLastParametersVoteTracks(
+    TSessionID &sid, vector<pair<TTrackID, TVote>> &votes) {
+  tie(sid, votes) = mVoteTracksParameters.value();
+  mVoteTracksParameters = nullopt;
+}
+
+size_t MockNetworkListener::getCountVoteTracks() {
+  return mVoteTracksCount;
+}
+
+// removeTracks
+bool MockNetworkListener::hasParametersRemoveTracks() {
+  return mRemoveTracksParameters.has_value();
+}
+
+void MockNetworkListener::getLastParametersRemoveTracks(
+    TSessionID &sid, vector<TTrackID> &trkids) {
+  tie(sid, trkids) = mRemoveTracksParameters.value();
+  mRemoveTracksParameters = nullopt;
+}
+
+size_t MockNetworkListener::getCountRemoveTracks() {
+  return mRemoveTracksCount;
+}
@@ -9,7 +9,12 @@
 #ifndef _MOCK_NETWORK_LISTENER_H_
 #define _MOCK_NETWORK_LISTENER_H_
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "NetworkListener.h"
 
@@ -38,6 +43,17 @@ class MockNetworkListener : public NetworkListener {
 
   TResult<QueueStatus> getCurrentQueues(TSessionID const &sid) override;
 
+  TResult<uint64_t> waitForChange(TSessionID const &sid,
+                                  uint64_t since,
+                                  std::chrono::milliseconds timeout) override;
+
+  TResult<EventBroadcaster *> getEvents(TSessionID const &sid) override;
+
+  TResult<TQueueSnapshot> getPreviousQueues(TSessionID const &sid,
+                                            uint64_t queueVersion) override;
+
+  TResult<QueueStatusTag> getQueueStatusTag(TSessionID const &sid) override;
+
   TResultOpt addTrackToQueue(TSessionID const &sid,
                              TTrackID const &trkid,
                              QueueType type) override;
@@ -54,6 +70,18 @@ class MockNetworkListener : public NetworkListener {
                        TTrackID const &trkid,
                        QueueType type) override;
 
+  TResult<std::vector<TResultOpt>> addTracksToQueue(
+      TSessionID const &sid,
+      std::vector<TTrackID> const &trkids,
+      QueueType type) override;
+
+  TResultOpt voteTracks(
+      TSessionID const &sid,
+      std::vector<std::pair<TTrackID, TVote>> const &votes) override;
+
+  TResult<std::vector<TResultOpt>> removeTracks(
+      TSessionID const &sid, std::vector<TTrackID> const &trkids) override;
+
   //
   // Access functions for the test cases
   //
@@ -77,6 +105,35 @@ class MockNetworkListener : public NetworkListener {
   size_t getCountGetCurrentQueues();
   void setResponseGetCurrentQueues(QueueStatus const &queueStatus);
 
+  // waitForChange
+  bool hasParametersWaitForChange();
+  void getLastParametersWaitForChange(TSessionID &sid, uint64_t &since);
+  size_t getCountWaitForChange();
+  void setResponseWaitForChange(uint64_t version);
+  // time waitForChange blocks before it responds
+  void setDelayWaitForChange(std::chrono::milliseconds delay);
+
+  // getEvents
+  bool hasParametersGetEvents();
+  void getLastParametersGetEvents(TSessionID &sid);
+  size_t getCountGetEvents();
+  void setResponseGetEvents(TResult<EventBroadcaster *> const &events);
+  // returned by getEvents unless another response is set
+  EventBroadcaster &getEventBroadcaster();
+
+  // getPreviousQueues
+  bool hasParametersGetPreviousQueues();
+  void getLastParametersGetPreviousQueues(TSessionID &sid,
+                                          uint64_t &queueVersion);
+  size_t getCountGetPreviousQueues();
+  void setResponseGetPreviousQueues(TResult<TQueueSnapshot> const &queues);
+
+  // getQueueStatusTag
+  bool hasParametersGetQueueStatusTag();
+  void getLastParametersGetQueueStatusTag(TSessionID &sid);
+  size_t getCountGetQueueStatusTag();
+  void setResponseGetQueueStatusTag(TResult<QueueStatusTag> const &tag);
+
   // addTrackToQueue
   bool hasParametersAddTrackToQueue();
   void getLastParametersAddTrackToQueue(TSessionID &sid,
@@ -108,6 +165,25 @@ class MockNetworkListener : public NetworkListener {
   void getLastParametersRemoveTrack(TSessionID &sid, TTrackID &trkid);
   size_t getCountRemoveTrack();
 
+  // addTracksToQueue
+  bool hasParametersAddTracksToQueue();
+  void getLastParametersAddTracksToQueue(TSessionID &sid,
+                                         std::vector<TTrackID> &trkids,
+                                         QueueType &queueType);
+  size_t getCountAddTracksToQueue();
+
+  // voteTracks
+  bool hasParametersVoteTracks();
+  void getLastParametersVoteTracks(
+      TSessionID &sid, std::vector<std::pair<TTrackID, TVote>> &votes);
+  size_t getCountVoteTracks();
+
+  // removeTracks
+  bool hasParametersRemoveTracks();
+  void getLastParametersRemoveTracks(TSessionID &sid,
+                                     std::vector<TTrackID> &trkids);
+  size_t getCountRemoveTracks();
+
   //
   // Store the parameter sets, responses and call counts for each request.
   //
@@ -132,6 +208,29 @@ class MockNetworkListener : public NetworkListener {
   size_t mGetCurrentQueuesCount;
   TResult<QueueStatus> mGetCurrentQueuesResponse;
 
+  // waitForChange
+  std::optional<std::tuple<TSessionID, uint64_t>> mWaitForChangeParameters;
+  std::mutex mWaitForChangeMutex;
+  std::atomic<size_t> mWaitForChangeCount;
+  TResult<uint64_t> mWaitForChangeResponse;
+  std::chrono::milliseconds mWaitForChangeDelay;
+
+  // getEvents
+  std::optional<TSessionID> mGetEventsParameters;
+  std::atomic<size_t> mGetEventsCount;
+  TResult<EventBroadcaster *> mGetEventsResponse;
+  EventBroadcaster mEventBroadcaster;
+
+  // getPreviousQueues
+  std::optional<std::tuple<TSessionID, uint64_t>> mGetPreviousQueuesParameters;
+  size_t mGetPreviousQueuesCount;
+  TResult<TQueueSnapshot> mGetPreviousQueuesResponse;
+
+  // getQueueStatusTag
+  std::optional<TSessionID> mGetQueueStatusTagParameters;
+  size_t mGetQueueStatusTagCount;
+  TResult<QueueStatusTag> mGetQueueStatusTagResponse;
+
   // addTrackToQueue
   std::optional<std::tuple<TSessionID, TTrackID, QueueType>>
       mAddTrackToQueueParameters;
@@ -153,6 +252,22 @@ class MockNetworkListener : public NetworkListener {
   std::optional<std::tuple<TSessionID, TTrackID, QueueType>>
       mMoveTrackParameters;
   size_t mMoveTrackCount;
+
+  // addTracksToQueue
+  std::optional<std::tuple<TSessionID, std::vector<TTrackID>, QueueType>>
+      mAddTracksToQueueParameters;
+  size_t mAddTracksToQueueCount;
+
+  // voteTracks
+  std::optional<
+      std::tuple<TSessionID, std::vector<std::pair<TTrackID, TVote>>>>
+      mVoteTracksParameters;
+  size_t mVoteTracksCount;
+
+  // removeTracks
+  std::optional<std::tuple<TSessionID, std::vector<TTrackID>>>
+      mRemoveTracksParameters;
+  size_t mRemoveTracksCount;
 };
 
 #endif /* _MOCK_NETWORK_LISTENER_H_ */